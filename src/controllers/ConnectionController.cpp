@@ -6,6 +6,9 @@
 #include <drogon/HttpResponse.h>
 #include <json/json.h>
 
+#include <chrono>
+#include <set>
+
 using namespace drogon;
 
 namespace
@@ -18,6 +21,83 @@ HttpResponsePtr makeError(HttpStatusCode code, const std::string &message)
     response->setStatusCode(code);
     return response;
 }
+
+// Bulk requests name devices explicitly ({"devices": [...]}) or by group
+// ({"group": "..."}); unknown names are returned in `missing`.
+bool selectDevices(const Json::Value &body, std::vector<Device> &selected, std::vector<std::string> &missing,
+                   std::string &error)
+{
+    auto repo = RepositoryProvider::instance();
+    if (body.isMember("devices"))
+    {
+        if (!body["devices"].isArray())
+        {
+            error = "devices must be an array of device names";
+            return false;
+        }
+        std::set<std::string> seen;
+        for (const auto &name : body["devices"])
+        {
+            if (!name.isString() || !seen.insert(name.asString()).second)
+            {
+                continue;
+            }
+            if (auto device = repo->find(name.asString()))
+            {
+                selected.push_back(*device);
+            }
+            else
+            {
+                missing.push_back(name.asString());
+            }
+        }
+        return true;
+    }
+    if (body.isMember("group"))
+    {
+        const auto group = body["group"].asString();
+        for (const auto &device : repo->list())
+        {
+            if (device.group == group)
+            {
+                selected.push_back(device);
+            }
+        }
+        return true;
+    }
+    error = "Request must name devices or a group";
+    return false;
+}
+
+Json::Value bulkResponse(const std::vector<ConnectionStatus> &statuses, const std::vector<std::string> &missing,
+                         bool wantConnected, std::chrono::steady_clock::time_point started)
+{
+    Json::Value results(Json::arrayValue);
+    Json::UInt succeeded = 0;
+    for (const auto &status : statuses)
+    {
+        auto item = status.toJson();
+        item["ok"] = status.connected == wantConnected && status.lastError.empty();
+        succeeded += item["ok"].asBool() ? 1 : 0;
+        results.append(item);
+    }
+    for (const auto &name : missing)
+    {
+        Json::Value item;
+        item["deviceName"] = name;
+        item["ok"] = false;
+        item["lastError"] = "Device not found";
+        results.append(item);
+    }
+
+    Json::Value payload;
+    payload["results"] = results;
+    payload["succeeded"] = succeeded;
+    payload["failed"] = results.size() - succeeded;
+    payload["elapsedMs"] = static_cast<Json::UInt64>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
+    return payload;
+}
 } // namespace
 
 void ConnectionController::listStatuses(const HttpRequestPtr &request,
@@ -35,6 +115,77 @@ void ConnectionController::listStatuses(const HttpRequestPtr &request,
     callback(response);
 }
 
+void ConnectionController::openMany(const HttpRequestPtr &request,
+                                    std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto json = request->getJsonObject();
+    if (!json)
+    {
+        callback(makeError(k400BadRequest, "JSON body is required"));
+        return;
+    }
+
+    std::vector<Device> devices;
+    std::vector<std::string> missing;
+    std::string error;
+    if (!selectDevices(*json, devices, missing, error))
+    {
+        callback(makeError(k400BadRequest, error));
+        return;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto parallelism = (*json).get("parallelism", 0).asUInt();
+    ConnectionLifecycleServiceProvider::instance()->openAll(
+        devices, parallelism,
+        [callback = std::move(callback), missing, started](const std::vector<ConnectionStatus> &statuses) {
+            auto response = HttpResponse::newHttpJsonResponse(bulkResponse(statuses, missing, true, started));
+            response->setStatusCode(k200OK);
+            callback(response);
+        });
+}
+
+void ConnectionController::closeMany(const HttpRequestPtr &request,
+                                     std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto json = request->getJsonObject();
+    if (!json)
+    {
+        callback(makeError(k400BadRequest, "JSON body is required"));
+        return;
+    }
+
+    std::vector<Device> devices;
+    std::vector<std::string> missing;
+    std::string error;
+    if (!selectDevices(*json, devices, missing, error))
+    {
+        callback(makeError(k400BadRequest, error));
+        return;
+    }
+
+    // Only connections that were ever opened can be closed; skip the rest of a group.
+    auto service = ConnectionLifecycleServiceProvider::instance();
+    std::vector<std::string> names;
+    for (const auto &device : devices)
+    {
+        if (service->status(device.name) || (*json).isMember("devices"))
+        {
+            names.push_back(device.name);
+        }
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto parallelism = (*json).get("parallelism", 0).asUInt();
+    service->closeAll(
+        names, parallelism,
+        [callback = std::move(callback), missing, started](const std::vector<ConnectionStatus> &statuses) {
+            auto response = HttpResponse::newHttpJsonResponse(bulkResponse(statuses, missing, false, started));
+            response->setStatusCode(k200OK);
+            callback(response);
+        });
+}
+
 void ConnectionController::openConnection(const HttpRequestPtr &request,
                                           std::function<void(const HttpResponsePtr &)> &&callback,
                                           const std::string &name) const
@@ -83,6 +234,40 @@ void ConnectionController::closeConnection(const HttpRequestPtr &request,
     callback(response);
 }
 
+void ConnectionController::timing(const HttpRequestPtr &request,
+                                  std::function<void(const HttpResponsePtr &)> &&callback,
+                                  const std::string &name) const
+{
+    auto service = ConnectionLifecycleServiceProvider::instance();
+    auto timing = service->timing(name);
+    if (!timing)
+    {
+        callback(makeError(k404NotFound, "No timing recorded for this connection"));
+        return;
+    }
+
+    auto payload = timing->toJson();
+    payload["deviceName"] = name;
+    auto response = HttpResponse::newHttpJsonResponse(payload);
+    response->setStatusCode(k200OK);
+    callback(response);
+}
+
+void ConnectionController::ioThreads(const HttpRequestPtr &request,
+                                     std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto service = ConnectionLifecycleServiceProvider::instance();
+    Json::Value payload(Json::arrayValue);
+    for (const auto &thread : service->ioThreads())
+    {
+        payload.append(thread.toJson());
+    }
+
+    auto response = HttpResponse::newHttpJsonResponse(payload);
+    response->setStatusCode(k200OK);
+    callback(response);
+}
+
 void ConnectionController::view(const HttpRequestPtr &request,
                                 std::function<void(const HttpResponsePtr &)> &&callback) const
 {
@@ -28,6 +28,10 @@ Device deviceFromRequest(const HttpRequestPtr &request)
         {
             device.edsFile = (*json)["edsFile"].asString();
         }
+        if ((*json).isMember("group"))
+        {
+            device.group = (*json)["group"].asString();
+        }
         if ((*json).isMember("signals") && (*json)["signals"].isArray())
         {
             for (const auto &sig : (*json)["signals"])
@@ -57,6 +61,10 @@ Device deviceFromRequest(const HttpRequestPtr &request)
         {
             device.edsFile = params.at("edsFile");
         }
+        if (params.find("group") != params.end() && !params.at("group").empty())
+        {
+            device.group = params.at("group");
+        }
     }
     return device;
 }
@@ -1,12 +1,12 @@
 #include "ExplicitMessagingController.h"
 #include "models/ExplicitMessage.h"
+#include "models/SignalCodec.h"
 #include "repositories/RepositoryProvider.h"
 #include "services/ExplicitMessageServiceProvider.h"
 
 #include <EIPScanner/cip/GeneralStatusCodes.h>
 #include <drogon/HttpResponse.h>
 #include <algorithm>
-#include <cstring>
 #include <iomanip>
 #include <json/json.h>
 #include <limits>
@@ -47,6 +47,30 @@ PayloadType parsePayloadType(const std::string &value)
     {
         return PayloadType::Real32;
     }
+    if (lower == "int16")
+    {
+        return PayloadType::Int16;
+    }
+    if (lower == "int32")
+    {
+        return PayloadType::Int32;
+    }
+    if (lower == "int64")
+    {
+        return PayloadType::Int64;
+    }
+    if (lower == "uint64")
+    {
+        return PayloadType::UInt64;
+    }
+    if (lower == "real64")
+    {
+        return PayloadType::Real64;
+    }
+    if (lower == "string")
+    {
+        return PayloadType::String;
+    }
     if (lower == "hex")
     {
         return PayloadType::Hex;
@@ -72,6 +96,18 @@ std::string payloadTypeToString(PayloadType type)
         return "int8";
     case PayloadType::Real32:
         return "real32";
+    case PayloadType::Int16:
+        return "int16";
+    case PayloadType::Int32:
+        return "int32";
+    case PayloadType::Int64:
+        return "int64";
+    case PayloadType::UInt64:
+        return "uint64";
+    case PayloadType::Real64:
+        return "real64";
+    case PayloadType::String:
+        return "string";
     case PayloadType::Hex:
         return "hex";
     default:
@@ -79,6 +115,48 @@ std::string payloadTypeToString(PayloadType type)
     }
 }
 
+// Numeric payloads share the signal codec table; CIP explicit data is little-endian.
+const SignalCodec::ScalarCodec *scalarCodecFor(PayloadType type)
+{
+    std::optional<SignalType> signalType;
+    switch (type)
+    {
+    case PayloadType::UInt8:
+        signalType = SignalType::UInt8;
+        break;
+    case PayloadType::UInt16:
+        signalType = SignalType::UInt16;
+        break;
+    case PayloadType::UInt32:
+        signalType = SignalType::UInt32;
+        break;
+    case PayloadType::UInt64:
+        signalType = SignalType::UInt64;
+        break;
+    case PayloadType::Int8:
+        signalType = SignalType::SInt;
+        break;
+    case PayloadType::Int16:
+        signalType = SignalType::Int16;
+        break;
+    case PayloadType::Int32:
+        signalType = SignalType::Int32;
+        break;
+    case PayloadType::Int64:
+        signalType = SignalType::Int64;
+        break;
+    case PayloadType::Real32:
+        signalType = SignalType::Real32;
+        break;
+    case PayloadType::Real64:
+        signalType = SignalType::Real64;
+        break;
+    default:
+        return nullptr;
+    }
+    return &SignalCodec::kScalarCodecs[SignalCodec::scalarCodecIndex(*signalType, ByteOrder::Little)];
+}
+
 std::string generalStatusDescription(uint8_t status)
 {
     switch (static_cast<eipScanner::cip::GeneralStatusCodes>(status))
@@ -275,76 +353,21 @@ bool encodePayload(const std::string &input, PayloadType type, std::vector<uint8
         return true;
     case PayloadType::Hex:
         return parseHexPayload(input, payload, error);
-    case PayloadType::UInt8:
-    {
-        uint64_t value{0};
-        if (!parseUnsignedField(input, 0, std::numeric_limits<uint8_t>::max(), "Payload", value, error))
-        {
-            return false;
-        }
-        payload = {static_cast<uint8_t>(value)};
-        return true;
-    }
-    case PayloadType::UInt16:
-    {
-        uint64_t value{0};
-        if (!parseUnsignedField(input, 0, std::numeric_limits<uint16_t>::max(), "Payload", value, error))
-        {
-            return false;
-        }
-        payload = {static_cast<uint8_t>(value & 0xFF), static_cast<uint8_t>((value >> 8) & 0xFF)};
-        return true;
-    }
-    case PayloadType::UInt32:
-    {
-        uint64_t value{0};
-        if (!parseUnsignedField(input, 0, std::numeric_limits<uint32_t>::max(), "Payload", value, error))
-        {
-            return false;
-        }
-        payload = {static_cast<uint8_t>(value & 0xFF),
-                   static_cast<uint8_t>((value >> 8) & 0xFF),
-                   static_cast<uint8_t>((value >> 16) & 0xFF),
-                   static_cast<uint8_t>((value >> 24) & 0xFF)};
-        return true;
-    }
-    case PayloadType::Int8:
-    {
-        int64_t value{0};
-        if (!parseSignedField(input, std::numeric_limits<int8_t>::min(), std::numeric_limits<int8_t>::max(), "Payload", value, error))
-        {
-            return false;
-        }
-        payload = {static_cast<uint8_t>(static_cast<int8_t>(value))};
+    case PayloadType::String:
+        payload.assign(input.begin(), input.end());
         return true;
+    default:
+        break;
     }
-    case PayloadType::Real32:
+
+    const auto *codec = scalarCodecFor(type);
+    if (!codec)
     {
-        if (input.empty())
-        {
-            error = "Payload is required";
-            return false;
-        }
-        try
-        {
-            float floatValue = std::stof(input);
-            static_assert(sizeof(float) == 4, "Unexpected float size");
-            uint32_t raw{0};
-            std::memcpy(&raw, &floatValue, sizeof(float));
-            payload = {static_cast<uint8_t>(raw & 0xFF),
-                       static_cast<uint8_t>((raw >> 8) & 0xFF),
-                       static_cast<uint8_t>((raw >> 16) & 0xFF),
-                       static_cast<uint8_t>((raw >> 24) & 0xFF)};
-            return true;
-        }
-        catch (const std::exception &)
-        {
-            error = "Invalid floating point payload";
-            return false;
-        }
-    }
+        error = "Unsupported payload type";
+        return false;
     }
-    return false;
+    payload.assign(codec->width, 0);
+    return codec->parse(input, payload.data(), error);
 }
 
 std::string decodeValue(const std::vector<uint8_t> &data, PayloadType type, std::string &decodeError)
@@ -355,46 +378,21 @@ std::string decodeValue(const std::vector<uint8_t> &data, PayloadType type, std:
         return "";
     }
 
-    switch (type)
+    if (type == PayloadType::String)
+    {
+        return SignalCodec::decodeText(data.data(), data.size());
+    }
+    const auto *codec = scalarCodecFor(type);
+    if (!codec)
     {
-    case PayloadType::UInt8:
-        return std::to_string(data.front());
-    case PayloadType::UInt16:
-        if (data.size() < 2)
-        {
-            decodeError = "Response too short for uint16";
-            return "";
-        }
-        return std::to_string(static_cast<uint16_t>(data[0] | (data[1] << 8)));
-    case PayloadType::UInt32:
-        if (data.size() < 4)
-        {
-            decodeError = "Response too short for uint32";
-            return "";
-        }
-        return std::to_string(static_cast<uint32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24)));
-    case PayloadType::Int8:
-        return std::to_string(static_cast<int8_t>(data.front()));
-    case PayloadType::Real32:
-        if (data.size() < 4)
-        {
-            decodeError = "Response too short for real32";
-            return "";
-        }
-        {
-            uint32_t raw = static_cast<uint32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
-            float value{0.0F};
-            std::memcpy(&value, &raw, sizeof(float));
-            std::ostringstream ss;
-            ss << value;
-            return ss.str();
-        }
-    case PayloadType::Hex:
-        return toHexString(data);
-    case PayloadType::None:
-    default:
         return toHexString(data);
     }
+    if (data.size() < codec->width)
+    {
+        decodeError = "Response too short for " + payloadTypeToString(type);
+        return "";
+    }
+    return codec->format(data.data());
 }
 
 Json::Value presets()
@@ -0,0 +1,83 @@
+#include "LoadTestController.h"
+
+#include "repositories/RepositoryProvider.h"
+#include "services/LoadTestServiceProvider.h"
+
+#include <drogon/HttpResponse.h>
+#include <json/json.h>
+
+using namespace drogon;
+
+namespace
+{
+HttpResponsePtr makeError(HttpStatusCode code, const std::string &message)
+{
+    Json::Value payload;
+    payload["error"] = message;
+    auto response = HttpResponse::newHttpJsonResponse(payload);
+    response->setStatusCode(code);
+    return response;
+}
+} // namespace
+
+void LoadTestController::start(const HttpRequestPtr &request,
+                               std::function<void(const HttpResponsePtr &)> &&callback,
+                               const std::string &name) const
+{
+    auto device = RepositoryProvider::instance()->find(name);
+    if (!device)
+    {
+        callback(makeError(k404NotFound, "Device not found"));
+        return;
+    }
+
+    if (!device->connection.has_value())
+    {
+        callback(makeError(k400BadRequest, "Device does not include a connection configuration"));
+        return;
+    }
+
+    auto json = request->getJsonObject();
+    const auto spec = LoadTestSpec::fromJson(json ? *json : Json::Value(Json::objectValue));
+    std::string error;
+    if (!spec.isValid(error))
+    {
+        callback(makeError(k400BadRequest, error));
+        return;
+    }
+
+    auto service = LoadTestServiceProvider::instance();
+    if (!service->start(*device, spec, error))
+    {
+        callback(makeError(k409Conflict, error));
+        return;
+    }
+
+    auto response = HttpResponse::newHttpJsonResponse(service->report().toJson());
+    response->setStatusCode(k202Accepted);
+    callback(response);
+}
+
+void LoadTestController::report(const HttpRequestPtr &request,
+                                std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto response = HttpResponse::newHttpJsonResponse(LoadTestServiceProvider::instance()->report().toJson());
+    response->setStatusCode(k200OK);
+    callback(response);
+}
+
+void LoadTestController::stop(const HttpRequestPtr &request,
+                              std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto service = LoadTestServiceProvider::instance();
+    std::string error;
+    if (!service->stop(error))
+    {
+        callback(makeError(k409Conflict, error));
+        return;
+    }
+
+    auto response = HttpResponse::newHttpJsonResponse(service->report().toJson());
+    response->setStatusCode(k202Accepted);
+    callback(response);
+}
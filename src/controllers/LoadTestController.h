@@ -0,0 +1,21 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+class LoadTestController : public drogon::HttpController<LoadTestController>
+{
+public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(LoadTestController::start, "/api/devices/{1}/load", drogon::Post);
+    ADD_METHOD_TO(LoadTestController::report, "/api/load", drogon::Get);
+    ADD_METHOD_TO(LoadTestController::stop, "/api/load/stop", drogon::Post);
+    METHOD_LIST_END
+
+    void start(const drogon::HttpRequestPtr &request,
+               std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+               const std::string &name) const;
+    void report(const drogon::HttpRequestPtr &request,
+                std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+    void stop(const drogon::HttpRequestPtr &request,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+};
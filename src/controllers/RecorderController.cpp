@@ -0,0 +1,83 @@
+#include "RecorderController.h"
+
+#include "services/TrafficRecorderProvider.h"
+
+#include <drogon/HttpResponse.h>
+#include <json/json.h>
+
+#include <filesystem>
+
+using namespace drogon;
+
+namespace
+{
+HttpResponsePtr makeError(HttpStatusCode code, const std::string &message)
+{
+    Json::Value payload;
+    payload["error"] = message;
+    auto response = HttpResponse::newHttpJsonResponse(payload);
+    response->setStatusCode(code);
+    return response;
+}
+
+HttpResponsePtr makeStatus(const TrafficRecorder &recorder)
+{
+    auto payload = recorder.stats().toJson();
+    payload["config"] = recorder.config().toJson();
+    auto response = HttpResponse::newHttpJsonResponse(payload);
+    response->setStatusCode(k200OK);
+    return response;
+}
+} // namespace
+
+void RecorderController::status(const HttpRequestPtr &request,
+                                std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    callback(makeStatus(*TrafficRecorderProvider::instance()));
+}
+
+void RecorderController::start(const HttpRequestPtr &request,
+                               std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto recorder = TrafficRecorderProvider::instance();
+    if (recorder->recording())
+    {
+        callback(makeError(k409Conflict, "Recorder is already running"));
+        return;
+    }
+    std::string error;
+    if (!recorder->start(error))
+    {
+        callback(makeError(k500InternalServerError, error));
+        return;
+    }
+    callback(makeStatus(*recorder));
+}
+
+void RecorderController::stop(const HttpRequestPtr &request,
+                              std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto recorder = TrafficRecorderProvider::instance();
+    if (!recorder->recording())
+    {
+        callback(makeError(k409Conflict, "Recorder is not running"));
+        return;
+    }
+    recorder->stop();
+    callback(makeStatus(*recorder));
+}
+
+void RecorderController::exportPcapng(const HttpRequestPtr &request,
+                                      std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto recorder = TrafficRecorderProvider::instance();
+    // Written next to the logs and overwritten by the next export.
+    const auto path = (std::filesystem::path(recorder->config().directory) / "traffic.pcapng").string();
+    std::string error;
+    if (!recorder->exportPcapng(path, error))
+    {
+        callback(makeError(k500InternalServerError, error));
+        return;
+    }
+    callback(HttpResponse::newFileResponse(path, "traffic.pcapng", CT_APPLICATION_OCTET_STREAM));
+}
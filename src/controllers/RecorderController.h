@@ -0,0 +1,23 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+class RecorderController : public drogon::HttpController<RecorderController>
+{
+public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(RecorderController::status, "/api/recorder", drogon::Get);
+    ADD_METHOD_TO(RecorderController::start, "/api/recorder/start", drogon::Post);
+    ADD_METHOD_TO(RecorderController::stop, "/api/recorder/stop", drogon::Post);
+    ADD_METHOD_TO(RecorderController::exportPcapng, "/api/recorder/export.pcapng", drogon::Get);
+    METHOD_LIST_END
+
+    void status(const drogon::HttpRequestPtr &request,
+                std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+    void start(const drogon::HttpRequestPtr &request,
+               std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+    void stop(const drogon::HttpRequestPtr &request,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+    void exportPcapng(const drogon::HttpRequestPtr &request,
+                      std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+};
@@ -0,0 +1,84 @@
+#include "ReplayController.h"
+
+#include "repositories/RepositoryProvider.h"
+#include "services/ReplayServiceProvider.h"
+
+#include <drogon/HttpResponse.h>
+#include <json/json.h>
+
+using namespace drogon;
+
+namespace
+{
+HttpResponsePtr makeError(HttpStatusCode code, const std::string &message)
+{
+    Json::Value payload;
+    payload["error"] = message;
+    auto response = HttpResponse::newHttpJsonResponse(payload);
+    response->setStatusCode(code);
+    return response;
+}
+} // namespace
+
+void ReplayController::start(const HttpRequestPtr &request,
+                             std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto json = request->getJsonObject();
+    if (!json)
+    {
+        callback(makeError(k400BadRequest, "JSON body is required"));
+        return;
+    }
+    const auto spec = ReplaySpec::fromJson(*json);
+    std::string error;
+    if (!spec.isValid(error))
+    {
+        callback(makeError(k400BadRequest, error));
+        return;
+    }
+    if (!RepositoryProvider::instance()->find(spec.target))
+    {
+        callback(makeError(k404NotFound, "Device not found"));
+        return;
+    }
+
+    auto service = ReplayServiceProvider::instance();
+    if (service->report().state == "running")
+    {
+        callback(makeError(k409Conflict, "A replay is already running"));
+        return;
+    }
+    if (!service->start(spec, error))
+    {
+        callback(makeError(k400BadRequest, error));
+        return;
+    }
+
+    auto response = HttpResponse::newHttpJsonResponse(service->report().toJson());
+    response->setStatusCode(k202Accepted);
+    callback(response);
+}
+
+void ReplayController::report(const HttpRequestPtr &request,
+                              std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto response = HttpResponse::newHttpJsonResponse(ReplayServiceProvider::instance()->report().toJson());
+    response->setStatusCode(k200OK);
+    callback(response);
+}
+
+void ReplayController::stop(const HttpRequestPtr &request,
+                            std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    auto service = ReplayServiceProvider::instance();
+    std::string error;
+    if (!service->stop(error))
+    {
+        callback(makeError(k409Conflict, error));
+        return;
+    }
+
+    auto response = HttpResponse::newHttpJsonResponse(service->report().toJson());
+    response->setStatusCode(k200OK);
+    callback(response);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+class ReplayController : public drogon::HttpController<ReplayController>
+{
+public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(ReplayController::start, "/api/replay", drogon::Post);
+    ADD_METHOD_TO(ReplayController::report, "/api/replay", drogon::Get);
+    ADD_METHOD_TO(ReplayController::stop, "/api/replay/stop", drogon::Post);
+    METHOD_LIST_END
+
+    void start(const drogon::HttpRequestPtr &request,
+               std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+    void report(const drogon::HttpRequestPtr &request,
+                std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+    void stop(const drogon::HttpRequestPtr &request,
+              std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
+};
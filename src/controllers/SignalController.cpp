@@ -5,7 +5,10 @@
 #include "services/IOSignalService.h"
 
 #include <drogon/HttpResponse.h>
+#include <algorithm>
+#include <cctype>
 #include <fstream>
+#include <limits>
 #include <optional>
 #include <sstream>
 
@@ -34,6 +37,77 @@ std::optional<Device> fetchDevice(const std::string &name, std::string &error)
     return device;
 }
 
+// Signals are addressed by name or by the numeric handle reported in snapshots.
+// Names win so existing clients keep working; the handle form skips the name lookup.
+std::optional<IOSignalService::SignalHandle> resolveSignal(IOSignalService *service,
+                                                          const std::string &deviceName,
+                                                          const std::string &signal)
+{
+    if (auto handle = service->resolveHandle(deviceName, signal))
+    {
+        return handle;
+    }
+    if (signal.empty() || signal.size() > 9 ||
+        !std::all_of(signal.begin(), signal.end(), [](unsigned char c) { return std::isdigit(c) != 0; }))
+    {
+        return std::nullopt;
+    }
+    return static_cast<IOSignalService::SignalHandle>(std::stoul(signal));
+}
+
+// Parses an optional unsigned query parameter; an empty value yields `fallback`.
+bool parseUnsigned(const std::string &text, uint64_t fallback, uint64_t &value)
+{
+    if (text.empty())
+    {
+        value = fallback;
+        return true;
+    }
+    if (text.size() > 19 ||
+        !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c) != 0; }))
+    {
+        return false;
+    }
+    value = std::stoull(text);
+    return true;
+}
+
+// Generators and rules drive numeric outputs, one of them per output. Rule
+// references are resolved when the mappings are applied, so only syntax is checked here.
+bool validateOutputDrivers(const std::vector<SignalMapping> &mappings, std::string &error)
+{
+    for (const auto &mapping : mappings)
+    {
+        if (!mapping.generator.has_value() && !mapping.rule.has_value())
+        {
+            continue;
+        }
+        if (mapping.direction != SignalDirection::Output || mapping.type == SignalType::String)
+        {
+            error = "Signal " + mapping.name + ": generators and rules drive numeric outputs only";
+            return false;
+        }
+        if (mapping.generator.has_value() && mapping.rule.has_value())
+        {
+            error = "Signal " + mapping.name + ": an output has either a generator or a rule";
+            return false;
+        }
+        if (mapping.generator.has_value() && !mapping.generator->isValid(error))
+        {
+            error = "Signal " + mapping.name + ": " + error;
+            return false;
+        }
+        if (mapping.rule.has_value() &&
+            ((!mapping.rule->when.empty() && !RuleProgram::check(mapping.rule->when, error)) ||
+             !RuleProgram::check(mapping.rule->value, error)))
+        {
+            error = "Signal " + mapping.name + ": rule: " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
 std::vector<SignalMapping> defaultMappingsFromEds(const Device &device)
 {
     std::vector<SignalMapping> mappings;
@@ -137,6 +211,11 @@ void SignalController::update(const HttpRequestPtr &request,
     {
         newMappings.push_back(SignalMapping::fromJson(entry));
     }
+    if (!validateOutputDrivers(newMappings, error))
+    {
+        callback(makeError(k400BadRequest, error));
+        return;
+    }
 
     device->signals = newMappings;
     if (!repo->update(deviceName, *device, error))
@@ -190,6 +269,11 @@ void SignalController::importMappings(const HttpRequestPtr &request,
     {
         imported = defaultMappingsFromEds(*device);
     }
+    if (!validateOutputDrivers(imported, error))
+    {
+        callback(makeError(k400BadRequest, error));
+        return;
+    }
 
     device->signals = imported;
     if (!repo->update(deviceName, *device, error))
@@ -277,6 +361,8 @@ void SignalController::assemblies(const HttpRequestPtr &request,
     {
         payload["outputBytes"].append(byte);
     }
+    payload["inputVersion"] = static_cast<Json::UInt64>(assembliesOpt->inputVersion);
+    payload["outputVersion"] = static_cast<Json::UInt64>(assembliesOpt->outputVersion);
 
     if (device->connection.has_value())
     {
@@ -354,10 +440,133 @@ void SignalController::setOutputBytes(const HttpRequestPtr &request,
     callback(resp);
 }
 
+void SignalController::changes(const HttpRequestPtr &request,
+                               std::function<void(const HttpResponsePtr &)> &&callback,
+                               const std::string &deviceName) const
+{
+    std::string error;
+    auto device = fetchDevice(deviceName, error);
+    if (!device)
+    {
+        callback(makeError(k404NotFound, error));
+        return;
+    }
+
+    uint64_t since = 0;
+    if (!parseUnsigned(request->getParameter("since"), 0, since))
+    {
+        callback(makeError(k400BadRequest, "since must be a change version"));
+        return;
+    }
+
+    auto service = IOSignalServiceProvider::instance();
+    if (service->mappings(deviceName).empty() && !device->signals.empty())
+    {
+        service->applyMappings(deviceName, device->signals);
+    }
+
+    auto changes = service->changes(deviceName, since);
+    if (!changes)
+    {
+        callback(makeError(k404NotFound, "Device has no signal data yet"));
+        return;
+    }
+
+    Json::Value payload;
+    payload["version"] = static_cast<Json::UInt64>(changes->version);
+    payload["changes"] = Json::arrayValue;
+    for (const auto &value : changes->values)
+    {
+        payload["changes"].append(value.toJson());
+    }
+    auto resp = HttpResponse::newHttpJsonResponse(payload);
+    resp->setStatusCode(k200OK);
+    callback(resp);
+}
+
+void SignalController::history(const HttpRequestPtr &request,
+                               std::function<void(const HttpResponsePtr &)> &&callback,
+                               const std::string &deviceName,
+                               const std::string &signal) const
+{
+    std::string error;
+    auto device = fetchDevice(deviceName, error);
+    if (!device)
+    {
+        callback(makeError(k404NotFound, error));
+        return;
+    }
+
+    // from and to are wall-clock milliseconds since the epoch.
+    uint64_t fromMs = 0;
+    uint64_t toMs = 0;
+    constexpr uint64_t kMaxMs = static_cast<uint64_t>(std::numeric_limits<int64_t>::max() / 1000);
+    if (!parseUnsigned(request->getParameter("from"), 0, fromMs) ||
+        !parseUnsigned(request->getParameter("to"), kMaxMs, toMs) || fromMs > kMaxMs || toMs > kMaxMs)
+    {
+        callback(makeError(k400BadRequest, "from and to must be epoch milliseconds"));
+        return;
+    }
+
+    auto service = IOSignalServiceProvider::instance();
+    service->applyMappings(deviceName, device->signals);
+    auto handle = resolveSignal(service, deviceName, signal);
+    auto samples = handle ? service->history(deviceName, *handle, static_cast<int64_t>(fromMs) * 1000,
+                                             static_cast<int64_t>(toMs) * 1000)
+                          : std::nullopt;
+    if (!samples)
+    {
+        callback(makeError(k404NotFound, "Signal not found"));
+        return;
+    }
+
+    Json::Value payload;
+    payload["handle"] = *handle;
+    payload["samples"] = Json::arrayValue;
+    for (const auto &sample : *samples)
+    {
+        Json::Value entry;
+        entry["timestampMs"] = static_cast<double>(sample.timestampUs) / 1000.0;
+        entry["value"] = sample.value;
+        payload["samples"].append(entry);
+    }
+    auto resp = HttpResponse::newHttpJsonResponse(payload);
+    resp->setStatusCode(k200OK);
+    callback(resp);
+}
+
+void SignalController::getValue(const HttpRequestPtr &request,
+                                std::function<void(const HttpResponsePtr &)> &&callback,
+                                const std::string &deviceName,
+                                const std::string &signal) const
+{
+    std::string error;
+    auto device = fetchDevice(deviceName, error);
+    if (!device)
+    {
+        callback(makeError(k404NotFound, error));
+        return;
+    }
+
+    auto service = IOSignalServiceProvider::instance();
+    service->applyMappings(deviceName, device->signals);
+    auto handle = resolveSignal(service, deviceName, signal);
+    auto value = handle ? service->snapshot(deviceName, *handle) : std::nullopt;
+    if (!value)
+    {
+        callback(makeError(k404NotFound, "Signal not found"));
+        return;
+    }
+
+    auto resp = HttpResponse::newHttpJsonResponse(value->toJson());
+    resp->setStatusCode(k200OK);
+    callback(resp);
+}
+
 void SignalController::setValue(const HttpRequestPtr &request,
                                 std::function<void(const HttpResponsePtr &)> &&callback,
                                 const std::string &deviceName,
-                                const std::string &signalName) const
+                                const std::string &signal) const
 {
     std::string error;
     auto device = fetchDevice(deviceName, error);
@@ -377,7 +586,8 @@ void SignalController::setValue(const HttpRequestPtr &request,
 
     auto service = IOSignalServiceProvider::instance();
     service->applyMappings(deviceName, device->signals);
-    if (!service->setOutputValue(deviceName, signalName, value))
+    auto handle = resolveSignal(service, deviceName, signal);
+    if (!handle || !service->setOutputValue(deviceName, *handle, value))
     {
         callback(makeError(k404NotFound, "Signal not found or not writable"));
         return;
@@ -393,6 +603,25 @@ void SignalController::setValue(const HttpRequestPtr &request,
     callback(resp);
 }
 
+void SignalController::rules(const HttpRequestPtr &, std::function<void(const HttpResponsePtr &)> &&callback) const
+{
+    // Rules read other devices' inputs; apply every stored mapping so their references resolve.
+    auto service = IOSignalServiceProvider::instance();
+    for (const auto &device : RepositoryProvider::instance()->list())
+    {
+        service->applyMappings(device.name, device.signals);
+    }
+
+    Json::Value payload(Json::arrayValue);
+    for (const auto &status : service->rules())
+    {
+        payload.append(status.toJson());
+    }
+    auto resp = HttpResponse::newHttpJsonResponse(payload);
+    resp->setStatusCode(k200OK);
+    callback(resp);
+}
+
 void SignalController::view(const HttpRequestPtr &request,
                             std::function<void(const HttpResponsePtr &)> &&callback,
                             const std::string &deviceName) const
@@ -12,7 +12,11 @@ public:
     ADD_METHOD_TO(SignalController::exportMappings, "/api/devices/{1}/signals/export", drogon::Get);
     ADD_METHOD_TO(SignalController::assemblies, "/api/devices/{1}/assemblies", drogon::Get);
     ADD_METHOD_TO(SignalController::setOutputBytes, "/api/devices/{1}/assemblies/output", drogon::Post);
+    ADD_METHOD_TO(SignalController::changes, "/api/devices/{1}/signals/changes", drogon::Get);
+    ADD_METHOD_TO(SignalController::history, "/api/devices/{1}/signals/{2}/history", drogon::Get);
+    ADD_METHOD_TO(SignalController::getValue, "/api/devices/{1}/signals/{2}/value", drogon::Get);
     ADD_METHOD_TO(SignalController::setValue, "/api/devices/{1}/signals/{2}/value", drogon::Post);
+    ADD_METHOD_TO(SignalController::rules, "/api/rules", drogon::Get);
     ADD_METHOD_TO(SignalController::view, "/devices/{1}/io", drogon::Get);
     ADD_METHOD_TO(SignalController::assembliesView, "/devices/{1}/assemblies", drogon::Get);
     METHOD_LIST_END
@@ -35,10 +39,23 @@ public:
     void setOutputBytes(const drogon::HttpRequestPtr &request,
                         std::function<void(const drogon::HttpResponsePtr &)> &&callback,
                         const std::string &deviceName) const;
+    void changes(const drogon::HttpRequestPtr &request,
+                 std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                 const std::string &deviceName) const;
+    void history(const drogon::HttpRequestPtr &request,
+                 std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                 const std::string &deviceName,
+                 const std::string &signal) const;
+    void getValue(const drogon::HttpRequestPtr &request,
+                  std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                  const std::string &deviceName,
+                  const std::string &signal) const;
     void setValue(const drogon::HttpRequestPtr &request,
                   std::function<void(const drogon::HttpResponsePtr &)> &&callback,
                   const std::string &deviceName,
-                  const std::string &signalName) const;
+                  const std::string &signal) const;
+    void rules(const drogon::HttpRequestPtr &request,
+               std::function<void(const drogon::HttpResponsePtr &)> &&callback) const;
     void view(const drogon::HttpRequestPtr &request,
               std::function<void(const drogon::HttpResponsePtr &)> &&callback,
               const std::string &deviceName) const;
@@ -0,0 +1,898 @@
+#include "AdapterEmulator.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+
+namespace
+{
+// Encapsulation commands and status codes.
+constexpr uint16_t kListServices = 0x0004;
+constexpr uint16_t kListIdentity = 0x0063;
+constexpr uint16_t kRegisterSession = 0x0065;
+constexpr uint16_t kUnregisterSession = 0x0066;
+constexpr uint16_t kSendRRData = 0x006F;
+constexpr uint32_t kUnsupportedCommand = 0x0001;
+constexpr uint32_t kInvalidFormat = 0x0003;
+constexpr uint32_t kInvalidSession = 0x0064;
+constexpr size_t kHeaderBytes = 24;
+
+// Common packet format item types.
+constexpr uint16_t kNullAddressItem = 0x0000;
+constexpr uint16_t kIdentityItem = 0x000C;
+constexpr uint16_t kConnectedDataItem = 0x00B1;
+constexpr uint16_t kUnconnectedDataItem = 0x00B2;
+constexpr uint16_t kServicesItem = 0x0100;
+constexpr uint16_t kO2TSocketAddressItem = 0x8000;
+constexpr uint16_t kSequencedAddressItem = 0x8002;
+
+// CIP services, classes and general status codes.
+constexpr uint8_t kGetAttributeAll = 0x01;
+constexpr uint8_t kGetAttributeSingle = 0x0E;
+constexpr uint8_t kSetAttributeSingle = 0x10;
+constexpr uint8_t kForwardClose = 0x4E;
+constexpr uint8_t kForwardOpen = 0x54;
+constexpr uint8_t kLargeForwardOpen = 0x5B;
+constexpr uint16_t kIdentityClass = 0x01;
+constexpr uint16_t kAssemblyClass = 0x04;
+constexpr uint16_t kConnectionManagerClass = 0x06;
+constexpr uint8_t kConnectionFailure = 0x01;
+constexpr uint8_t kPathSegmentError = 0x04;
+constexpr uint8_t kPathDestinationUnknown = 0x05;
+constexpr uint8_t kServiceNotSupported = 0x08;
+constexpr uint8_t kAttributeNotSettable = 0x0E;
+constexpr uint8_t kNotEnoughData = 0x13;
+constexpr uint8_t kAttributeNotSupported = 0x14;
+constexpr uint8_t kTooMuchData = 0x15;
+
+class Writer
+{
+public:
+    Writer &u8(uint8_t value)
+    {
+        bytes.push_back(value);
+        return *this;
+    }
+    Writer &u16(uint16_t value) { return u8(value & 0xFF).u8(value >> 8); }
+    Writer &u32(uint32_t value) { return u16(value & 0xFFFF).u16(value >> 16); }
+    Writer &raw(const std::vector<uint8_t> &data)
+    {
+        bytes.insert(bytes.end(), data.begin(), data.end());
+        return *this;
+    }
+    Writer &item(uint16_t type, const std::vector<uint8_t> &data)
+    {
+        return u16(type).u16(static_cast<uint16_t>(data.size())).raw(data);
+    }
+
+    std::vector<uint8_t> bytes;
+};
+
+// Reads little-endian fields; running past the end clears ok() instead of throwing.
+class Reader
+{
+public:
+    Reader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+    explicit Reader(const std::vector<uint8_t> &data) : Reader(data.data(), data.size()) {}
+
+    uint8_t u8() { return static_cast<uint8_t>(take(1)); }
+    uint16_t u16() { return static_cast<uint16_t>(take(2)); }
+    uint32_t u32() { return static_cast<uint32_t>(take(4)); }
+    std::vector<uint8_t> bytes(size_t count)
+    {
+        if (!fits(count))
+        {
+            return {};
+        }
+        std::vector<uint8_t> out(data_ + offset_, data_ + offset_ + count);
+        offset_ += count;
+        return out;
+    }
+    std::vector<uint8_t> rest() { return bytes(size_ - offset_); }
+    size_t remaining() const { return size_ - offset_; }
+    bool ok() const { return ok_; }
+
+private:
+    bool fits(size_t count)
+    {
+        ok_ = ok_ && offset_ + count <= size_;
+        return ok_;
+    }
+    uint64_t take(size_t count)
+    {
+        if (!fits(count))
+        {
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            value |= static_cast<uint64_t>(data_[offset_ + i]) << (8 * i);
+        }
+        offset_ += count;
+        return value;
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    size_t offset_{0};
+    bool ok_{true};
+};
+
+// The logical segments of an EPath, in order.
+struct PathSegment
+{
+    enum Kind
+    {
+        Class,
+        Instance,
+        Attribute,
+        ConnectionPoint
+    } kind;
+    uint32_t value;
+};
+
+bool parsePath(const std::vector<uint8_t> &path, std::vector<PathSegment> &segments)
+{
+    Reader reader(path);
+    while (reader.remaining() > 0 && reader.ok())
+    {
+        const uint8_t segment = reader.u8();
+        if (segment == 0x34)
+        {
+            // Electronic key: the emulator accepts any.
+            reader.bytes(9);
+            continue;
+        }
+        if ((segment & 0xE0) != 0x20)
+        {
+            return false;
+        }
+        PathSegment::Kind kind;
+        switch (segment & 0x1C)
+        {
+        case 0x00:
+            kind = PathSegment::Class;
+            break;
+        case 0x04:
+            kind = PathSegment::Instance;
+            break;
+        case 0x0C:
+            kind = PathSegment::ConnectionPoint;
+            break;
+        case 0x10:
+            kind = PathSegment::Attribute;
+            break;
+        default:
+            return false;
+        }
+        uint32_t value = 0;
+        switch (segment & 0x03)
+        {
+        case 0:
+            value = reader.u8();
+            break;
+        case 1:
+            reader.u8();
+            value = reader.u16();
+            break;
+        case 2:
+            reader.u8();
+            value = reader.u32();
+            break;
+        default:
+            return false;
+        }
+        segments.push_back({kind, value});
+    }
+    return reader.ok();
+}
+
+std::vector<uint8_t> socketAddress(const sockaddr_in &address)
+{
+    // Socket address items are big-endian throughout.
+    std::vector<uint8_t> bytes(16, 0);
+    const uint16_t family = htons(AF_INET);
+    std::memcpy(&bytes[0], &family, 2);
+    std::memcpy(&bytes[2], &address.sin_port, 2);
+    std::memcpy(&bytes[4], &address.sin_addr.s_addr, 4);
+    return bytes;
+}
+
+bool setNonBlocking(int fd)
+{
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+} // namespace
+
+AdapterEmulator::AdapterEmulator(AdapterEmulatorConfig config) : config_(std::move(config))
+{
+    for (const auto &assembly : config_.assemblies)
+    {
+        assemblies_[assembly.instance].assign(assembly.sizeBytes, 0);
+    }
+}
+
+AdapterEmulator::~AdapterEmulator()
+{
+    stop();
+}
+
+bool AdapterEmulator::start(std::string &error)
+{
+    if (running_)
+    {
+        error = "Emulator is already running";
+        return false;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    if (::inet_pton(AF_INET, config_.host.c_str(), &address.sin_addr) != 1)
+    {
+        error = "Invalid host " + config_.host;
+        return false;
+    }
+
+    auto fail = [&](const std::string &what) {
+        error = what + ": " + std::strerror(errno);
+        for (int *fd : {&listenFd_, &udpFd_})
+        {
+            if (*fd >= 0)
+            {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+        return false;
+    };
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const int yes = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    address.sin_port = htons(config_.tcpPort);
+    if (listenFd_ < 0 || ::bind(listenFd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd_, 64) != 0)
+    {
+        return fail("Cannot listen on " + config_.host + ":" + std::to_string(config_.tcpPort));
+    }
+
+    // The UDP port is always ephemeral: Forward Open replies tell the originator where to send.
+    udpFd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    address.sin_port = 0;
+    if (udpFd_ < 0 || ::bind(udpFd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        !setNonBlocking(udpFd_))
+    {
+        return fail("Cannot bind UDP socket");
+    }
+
+    socklen_t length = sizeof(address);
+    ::getsockname(listenFd_, reinterpret_cast<sockaddr *>(&address), &length);
+    tcpPort_ = ntohs(address.sin_port);
+    length = sizeof(address);
+    ::getsockname(udpFd_, reinterpret_cast<sockaddr *>(&address), &length);
+    udpPort_ = ntohs(address.sin_port);
+
+    running_ = true;
+    tcpThread_ = std::thread([this]() { serveTcp(); });
+    udpThread_ = std::thread([this]() { serveUdp(); });
+    return true;
+}
+
+void AdapterEmulator::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    tcpThread_.join();
+    udpThread_.join();
+    ::close(listenFd_);
+    ::close(udpFd_);
+    listenFd_ = udpFd_ = -1;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.clear();
+    stats_.sessions = 0;
+}
+
+std::vector<uint8_t> AdapterEmulator::assembly(uint16_t instance) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = assemblies_.find(instance);
+    return it == assemblies_.end() ? std::vector<uint8_t>() : it->second;
+}
+
+bool AdapterEmulator::setAssembly(uint16_t instance, const std::vector<uint8_t> &data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = assemblies_.find(instance);
+    if (it == assemblies_.end() || it->second.size() != data.size())
+    {
+        return false;
+    }
+    it->second = data;
+    return true;
+}
+
+AdapterEmulatorStats AdapterEmulator::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats.connections = connections_.size();
+    return stats;
+}
+
+size_t AdapterEmulator::dropConnections()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto dropped = connections_.size();
+    connections_.clear();
+    return dropped;
+}
+
+void AdapterEmulator::serveTcp()
+{
+    std::vector<Client> clients;
+    while (running_)
+    {
+        std::vector<pollfd> fds{{listenFd_, POLLIN, 0}};
+        for (const auto &client : clients)
+        {
+            fds.push_back({client.fd, POLLIN, 0});
+        }
+        if (::poll(fds.data(), fds.size(), 50) <= 0)
+        {
+            continue;
+        }
+
+        for (size_t i = clients.size(); i-- > 0;)
+        {
+            auto &client = clients[i];
+            if (!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+            {
+                continue;
+            }
+            uint8_t chunk[4096];
+            const ssize_t received = ::recv(client.fd, chunk, sizeof(chunk), 0);
+            bool open = received > 0;
+            if (open)
+            {
+                client.buffer.insert(client.buffer.end(), chunk, chunk + received);
+                std::vector<uint8_t> reply;
+                while (open && client.buffer.size() >= kHeaderBytes)
+                {
+                    const size_t length = client.buffer[2] | (client.buffer[3] << 8);
+                    if (client.buffer.size() < kHeaderBytes + length)
+                    {
+                        break;
+                    }
+                    reply.clear();
+                    open = handleEncapsulation(client, reply);
+                    client.buffer.erase(client.buffer.begin(), client.buffer.begin() + kHeaderBytes + length);
+                    if (!reply.empty() && ::send(client.fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0)
+                    {
+                        open = false;
+                    }
+                }
+            }
+            if (!open)
+            {
+                ::close(client.fd);
+                if (client.session != 0)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stats_.sessions--;
+                }
+                clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            Client client;
+            socklen_t length = sizeof(client.peer);
+            client.fd = ::accept4(listenFd_, reinterpret_cast<sockaddr *>(&client.peer), &length, SOCK_CLOEXEC);
+            if (client.fd >= 0)
+            {
+                clients.push_back(std::move(client));
+            }
+        }
+    }
+
+    for (const auto &client : clients)
+    {
+        ::close(client.fd);
+    }
+}
+
+bool AdapterEmulator::handleEncapsulation(Client &client, std::vector<uint8_t> &reply)
+{
+    Reader header(client.buffer.data(), kHeaderBytes);
+    const uint16_t command = header.u16();
+    const uint16_t length = header.u16();
+    const uint32_t session = header.u32();
+    header.u32();
+    const auto context = header.bytes(8);
+    const uint32_t options = header.u32();
+    Reader payload(client.buffer.data() + kHeaderBytes, length);
+
+    auto respond = [&](uint32_t status, const std::vector<uint8_t> &data, uint32_t handle) {
+        Writer writer;
+        writer.u16(command).u16(static_cast<uint16_t>(data.size())).u32(handle).u32(status);
+        writer.raw(context).u32(options).raw(data);
+        reply = std::move(writer.bytes);
+    };
+
+    switch (command)
+    {
+    case kRegisterSession:
+    {
+        const uint16_t version = payload.u16();
+        if (!payload.ok() || version != 1 || client.session != 0)
+        {
+            respond(kInvalidFormat, Writer().u16(1).u16(0).bytes, 0);
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            client.session = nextSession_++;
+            stats_.sessions++;
+        }
+        respond(0, Writer().u16(1).u16(0).bytes, client.session);
+        return true;
+    }
+    case kUnregisterSession:
+        return false;
+    case kListIdentity:
+        respond(0, Writer().u16(1).item(kIdentityItem, identityItem()).bytes, session);
+        return true;
+    case kListServices:
+    {
+        Writer service;
+        service.u16(1).u16(0x0120);
+        std::vector<uint8_t> name(16, 0);
+        std::memcpy(name.data(), "Communications", 14);
+        service.raw(name);
+        respond(0, Writer().u16(1).item(kServicesItem, service.bytes).bytes, session);
+        return true;
+    }
+    case kSendRRData:
+    {
+        if (session == 0 || session != client.session)
+        {
+            respond(kInvalidSession, {}, session);
+            return true;
+        }
+        payload.u32(); // interface handle
+        payload.u16(); // timeout
+        const uint16_t count = payload.u16();
+        std::vector<uint8_t> request;
+        for (uint16_t i = 0; i < count && payload.ok(); ++i)
+        {
+            const uint16_t type = payload.u16();
+            const auto item = payload.bytes(payload.u16());
+            if (type == kUnconnectedDataItem)
+            {
+                request = item;
+            }
+        }
+        Reader message(request);
+        const uint8_t service = message.u8();
+        const auto path = message.bytes(message.u8() * 2u);
+        const auto data = message.rest();
+        if (!payload.ok() || request.empty() || !message.ok())
+        {
+            respond(kInvalidFormat, {}, session);
+            return true;
+        }
+
+        const auto result = handleRequest(client, service, path, data);
+        Writer response;
+        response.u8(service | 0x80).u8(0).u8(result.status).u8(static_cast<uint8_t>(result.extendedStatus.size()));
+        for (auto status : result.extendedStatus)
+        {
+            response.u16(status);
+        }
+        response.raw(result.data);
+
+        Writer body;
+        body.u32(0).u16(0).u16(result.includeSocketAddress ? 3 : 2);
+        body.item(kNullAddressItem, {}).item(kUnconnectedDataItem, response.bytes);
+        if (result.includeSocketAddress)
+        {
+            sockaddr_in address{};
+            address.sin_port = htons(udpPort_);
+            ::inet_pton(AF_INET, config_.host.c_str(), &address.sin_addr);
+            body.item(kO2TSocketAddressItem, socketAddress(address));
+        }
+        respond(0, body.bytes, session);
+        return true;
+    }
+    default:
+        respond(kUnsupportedCommand, {}, session);
+        return true;
+    }
+}
+
+AdapterEmulator::CipReply AdapterEmulator::handleRequest(const Client &client, uint8_t service,
+                                                         const std::vector<uint8_t> &path,
+                                                         const std::vector<uint8_t> &data)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.explicitRequests++;
+    }
+
+    std::vector<PathSegment> segments;
+    if (!parsePath(path, segments))
+    {
+        return {kPathSegmentError, {}, {}};
+    }
+    uint32_t classId = 0;
+    uint32_t instance = 0;
+    std::optional<uint32_t> attribute;
+    for (const auto &segment : segments)
+    {
+        if (segment.kind == PathSegment::Class)
+        {
+            classId = segment.value;
+        }
+        else if (segment.kind == PathSegment::Instance)
+        {
+            instance = segment.value;
+        }
+        else if (segment.kind == PathSegment::Attribute)
+        {
+            attribute = segment.value;
+        }
+    }
+
+    if (classId == kConnectionManagerClass)
+    {
+        switch (service)
+        {
+        case kForwardOpen:
+            return forwardOpen(client, data, false);
+        case kLargeForwardOpen:
+            return forwardOpen(client, data, true);
+        case kForwardClose:
+            return forwardClose(data);
+        default:
+            return {kServiceNotSupported, {}, {}};
+        }
+    }
+
+    if (classId == kIdentityClass)
+    {
+        if (instance != 1)
+        {
+            return {kPathDestinationUnknown, {}, {}};
+        }
+        if (service == kGetAttributeAll)
+        {
+            return {0, {}, identityAttributes()};
+        }
+        if (service == kSetAttributeSingle)
+        {
+            return {kAttributeNotSettable, {}, {}};
+        }
+        if (service != kGetAttributeSingle)
+        {
+            return {kServiceNotSupported, {}, {}};
+        }
+        // Attributes 1-7 follow each other in Get_Attribute_All order.
+        static const size_t offsets[] = {0, 2, 4, 6, 8, 10, 14};
+        const auto all = identityAttributes();
+        if (!attribute || *attribute < 1 || *attribute > 7)
+        {
+            return {kAttributeNotSupported, {}, {}};
+        }
+        const size_t begin = offsets[*attribute - 1];
+        const size_t end = *attribute == 7 ? all.size() : offsets[*attribute];
+        return {0, {}, std::vector<uint8_t>(all.begin() + begin, all.begin() + end)};
+    }
+
+    if (classId == kAssemblyClass)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = assemblies_.find(static_cast<uint16_t>(instance));
+        if (it == assemblies_.end())
+        {
+            return {kPathDestinationUnknown, {}, {}};
+        }
+        if (attribute.value_or(0) != 3)
+        {
+            return {kAttributeNotSupported, {}, {}};
+        }
+        if (service == kGetAttributeSingle)
+        {
+            return {0, {}, it->second};
+        }
+        if (service != kSetAttributeSingle)
+        {
+            return {kServiceNotSupported, {}, {}};
+        }
+        if (data.size() != it->second.size())
+        {
+            return {data.size() < it->second.size() ? kNotEnoughData : kTooMuchData, {}, {}};
+        }
+        it->second = data;
+        return {0, {}, {}};
+    }
+
+    return {kPathDestinationUnknown, {}, {}};
+}
+
+AdapterEmulator::CipReply AdapterEmulator::forwardOpen(const Client &client, const std::vector<uint8_t> &data,
+                                                       bool large)
+{
+    Reader request(data);
+    request.u8(); // priority / time tick
+    request.u8(); // timeout ticks
+    request.u32(); // proposed O->T id; the target picks its own
+    const uint32_t proposedT2O = request.u32();
+    const uint16_t serial = request.u16();
+    const uint16_t vendor = request.u16();
+    const uint32_t originatorSerial = request.u32();
+    const uint8_t timeoutMultiplier = request.u8();
+    request.bytes(3);
+    const uint32_t o2tRpi = request.u32();
+    const uint32_t o2tParams = large ? request.u32() : request.u16();
+    const uint32_t t2oRpi = request.u32();
+    const uint32_t t2oParams = large ? request.u32() : request.u16();
+    request.u8(); // transport type / trigger
+    const auto path = request.bytes(request.u8() * 2u);
+
+    Writer failure;
+    failure.u16(serial).u16(vendor).u32(originatorSerial).u8(0).u8(0);
+    auto reject = [&](uint16_t extended) { return CipReply{kConnectionFailure, {extended}, failure.bytes}; };
+
+    std::vector<PathSegment> segments;
+    if (!request.ok() || !parsePath(path, segments))
+    {
+        return {kPathSegmentError, {}, {}};
+    }
+    // The last two instances or connection points are O->T (consumed) then T->O (produced).
+    std::vector<uint16_t> points;
+    for (const auto &segment : segments)
+    {
+        if (segment.kind == PathSegment::Instance || segment.kind == PathSegment::ConnectionPoint)
+        {
+            points.push_back(static_cast<uint16_t>(segment.value));
+        }
+    }
+    if (points.size() < 2)
+    {
+        return reject(0x0315); // invalid segment in connection path
+    }
+    const uint16_t consumed = points[points.size() - 2];
+    const uint16_t produced = points.back();
+    const size_t sizeMask = large ? 0xFFFF : 0x1FF;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.forwardOpens++;
+    const auto consumedIt = assemblies_.find(consumed);
+    const auto producedIt = assemblies_.find(produced);
+    if (consumedIt == assemblies_.end())
+    {
+        return reject(0x0129); // invalid consuming application path
+    }
+    if (producedIt == assemblies_.end())
+    {
+        return reject(0x012A); // invalid producing application path
+    }
+    const Triplet triplet{serial, vendor, originatorSerial};
+    for (const auto &pair : connections_)
+    {
+        if (pair.second.triplet == triplet)
+        {
+            return reject(0x0100); // connection in use or duplicate forward open
+        }
+    }
+
+    // Class 1 sizes carry a 2-byte sequence count, and O->T may add a 4-byte run/idle header.
+    Connection connection;
+    const size_t o2tSize = o2tParams & sizeMask;
+    const size_t t2oSize = t2oParams & sizeMask;
+    const size_t consumedSize = consumedIt->second.size();
+    if (o2tSize != consumedSize + 2 && o2tSize != consumedSize + 6)
+    {
+        return reject(0x0127); // invalid O->T size
+    }
+    if (t2oSize != producedIt->second.size() + 2)
+    {
+        return reject(0x0128); // invalid T->O size
+    }
+
+    connection.triplet = triplet;
+    connection.o2tId = nextConnectionId_++;
+    connection.t2oId = proposedT2O != 0 ? proposedT2O : nextConnectionId_++;
+    connection.consumed = consumed;
+    connection.produced = produced;
+    connection.rpi = std::chrono::microseconds(t2oRpi);
+    connection.timeout = std::chrono::microseconds(static_cast<uint64_t>(o2tRpi) * (4u << timeoutMultiplier));
+    connection.originator = client.peer;
+    connection.originator.sin_port = htons(config_.originatorUdpPort);
+    connection.nextProduction = connection.lastConsumed = Clock::now();
+    connections_[connection.o2tId] = connection;
+
+    Writer reply;
+    reply.u32(connection.o2tId).u32(connection.t2oId).u16(serial).u16(vendor).u32(originatorSerial);
+    reply.u32(o2tRpi).u32(t2oRpi).u8(0).u8(0);
+    return {0, {}, reply.bytes, true};
+}
+
+AdapterEmulator::CipReply AdapterEmulator::forwardClose(const std::vector<uint8_t> &data)
+{
+    Reader request(data);
+    request.u8();
+    request.u8();
+    const uint16_t serial = request.u16();
+    const uint16_t vendor = request.u16();
+    const uint32_t originatorSerial = request.u32();
+
+    Writer reply;
+    reply.u16(serial).u16(vendor).u32(originatorSerial).u8(0).u8(0);
+    if (!request.ok())
+    {
+        return {kNotEnoughData, {}, {}};
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.forwardCloses++;
+    const Triplet triplet{serial, vendor, originatorSerial};
+    for (auto it = connections_.begin(); it != connections_.end(); ++it)
+    {
+        if (it->second.triplet == triplet)
+        {
+            connections_.erase(it);
+            return {0, {}, reply.bytes};
+        }
+    }
+    return {kConnectionFailure, {0x0107}, reply.bytes}; // target connection not found
+}
+
+std::vector<uint8_t> AdapterEmulator::identityAttributes() const
+{
+    Writer writer;
+    writer.u16(config_.vendorId).u16(config_.deviceType).u16(config_.productCode);
+    writer.u8(config_.revisionMajor).u8(config_.revisionMinor);
+    writer.u16(0x0030); // status: operational
+    writer.u32(config_.serialNumber);
+    const auto name = config_.productName.substr(0, 32);
+    writer.u8(static_cast<uint8_t>(name.size())).raw(std::vector<uint8_t>(name.begin(), name.end()));
+    return writer.bytes;
+}
+
+std::vector<uint8_t> AdapterEmulator::identityItem() const
+{
+    sockaddr_in address{};
+    address.sin_port = htons(tcpPort_);
+    ::inet_pton(AF_INET, config_.host.c_str(), &address.sin_addr);
+
+    Writer writer;
+    writer.u16(1).raw(socketAddress(address)).raw(identityAttributes()).u8(0x03); // state: operational
+    return writer.bytes;
+}
+
+void AdapterEmulator::serveUdp()
+{
+    std::vector<uint8_t> datagram(65536);
+    while (running_)
+    {
+        auto wait = std::chrono::microseconds(50000);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto now = Clock::now();
+            for (const auto &pair : connections_)
+            {
+                wait = std::min(wait, std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::max(pair.second.nextProduction - now, Clock::duration::zero())));
+            }
+        }
+
+        pollfd fd{udpFd_, POLLIN, 0};
+        const timespec timeout{static_cast<time_t>(wait.count() / 1000000),
+                               static_cast<long>(wait.count() % 1000000) * 1000};
+        if (::ppoll(&fd, 1, &timeout, nullptr) > 0)
+        {
+            ssize_t received;
+            while ((received = ::recv(udpFd_, datagram.data(), datagram.size(), 0)) > 0)
+            {
+                consume(std::vector<uint8_t>(datagram.begin(), datagram.begin() + received));
+            }
+        }
+        produceDue(Clock::now());
+    }
+}
+
+void AdapterEmulator::consume(const std::vector<uint8_t> &datagram)
+{
+    Reader reader(datagram);
+    const uint16_t count = reader.u16();
+    uint32_t connectionId = 0;
+    std::vector<uint8_t> payload;
+    for (uint16_t i = 0; i < count && reader.ok(); ++i)
+    {
+        const uint16_t type = reader.u16();
+        const auto item = reader.bytes(reader.u16());
+        if (type == kSequencedAddressItem && item.size() >= 4)
+        {
+            connectionId = Reader(item).u32();
+        }
+        else if (type == kConnectedDataItem)
+        {
+            payload = item;
+        }
+    }
+    if (!reader.ok())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections_.find(connectionId);
+    if (it == connections_.end())
+    {
+        return;
+    }
+    auto &connection = it->second;
+    auto &output = assemblies_[connection.consumed];
+    connection.lastConsumed = Clock::now();
+    stats_.packetsConsumed++;
+    // Sequence count first, then an optional run/idle header, then the data.
+    if (payload.size() == output.size() + 6)
+    {
+        std::copy(payload.begin() + 6, payload.end(), output.begin());
+    }
+    else if (payload.size() == output.size() + 2)
+    {
+        std::copy(payload.begin() + 2, payload.end(), output.begin());
+    }
+}
+
+void AdapterEmulator::produceDue(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = connections_.begin(); it != connections_.end();)
+    {
+        auto &connection = it->second;
+        if (now - connection.lastConsumed > connection.timeout)
+        {
+            stats_.timeouts++;
+            it = connections_.erase(it);
+            continue;
+        }
+        if (connection.nextProduction <= now)
+        {
+            Writer address;
+            address.u32(connection.t2oId).u32(++connection.encapsulationSequence);
+            Writer data;
+            data.u16(++connection.cipSequence).raw(assemblies_[connection.produced]);
+            Writer packet;
+            packet.u16(2).item(kSequencedAddressItem, address.bytes).item(kConnectedDataItem, data.bytes);
+            if (::sendto(udpFd_, packet.bytes.data(), packet.bytes.size(), 0,
+                         reinterpret_cast<const sockaddr *>(&connection.originator),
+                         sizeof(connection.originator)) > 0)
+            {
+                stats_.packetsProduced++;
+            }
+            // Keep the absolute schedule unless production fell a whole cycle behind.
+            connection.nextProduction += connection.rpi;
+            if (connection.nextProduction <= now)
+            {
+                connection.nextProduction = now + connection.rpi;
+            }
+        }
+        ++it;
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+struct EmulatedAssembly
+{
+    uint16_t instance{0};
+    uint16_t sizeBytes{0};
+};
+
+struct AdapterEmulatorConfig
+{
+    std::string host{"127.0.0.1"};
+    // 0 picks a free port; tcpPort() reports the one in use.
+    uint16_t tcpPort{0};
+    // Originator port that T->O packets are sent to; EIPScanner listens on 2222.
+    uint16_t originatorUdpPort{2222};
+
+    uint16_t vendorId{0xFFFE};
+    uint16_t deviceType{0x0C}; // communications adapter
+    uint16_t productCode{1};
+    uint8_t revisionMajor{1};
+    uint8_t revisionMinor{0};
+    uint32_t serialNumber{0x00C1A55E};
+    std::string productName{"cipMasterWeb adapter emulator"};
+
+    // Assembly instances, any of which can be produced (T->O) or consumed (O->T).
+    std::vector<EmulatedAssembly> assemblies{{100, 8}, {150, 8}};
+};
+
+struct AdapterEmulatorStats
+{
+    size_t sessions{0};
+    size_t connections{0};
+    uint64_t explicitRequests{0};
+    uint64_t forwardOpens{0};
+    uint64_t forwardCloses{0};
+    uint64_t timeouts{0};
+    uint64_t packetsConsumed{0};
+    uint64_t packetsProduced{0};
+};
+
+// A minimal EtherNet/IP adapter served from two threads on localhost, for
+// tests and benchmarks that need a target without hardware. It answers
+// RegisterSession, ListIdentity, ListServices and SendRRData over TCP, with
+// Get_Attribute_All/Single on the Identity object, Get/Set_Attribute_Single
+// on Assembly instances (attribute 3), and Forward Open, Large Forward Open
+// and Forward Close on the Connection Manager. Open connections produce their
+// T->O assembly cyclically at the requested RPI and consume O->T packets into
+// the output assembly; a connection that receives nothing for its timeout is
+// dropped as a real adapter would.
+class AdapterEmulator
+{
+public:
+    explicit AdapterEmulator(AdapterEmulatorConfig config = {});
+    ~AdapterEmulator();
+
+    AdapterEmulator(const AdapterEmulator &) = delete;
+    AdapterEmulator &operator=(const AdapterEmulator &) = delete;
+
+    bool start(std::string &error);
+    void stop();
+
+    uint16_t tcpPort() const { return tcpPort_; }
+    uint16_t udpPort() const { return udpPort_; }
+
+    std::vector<uint8_t> assembly(uint16_t instance) const;
+    bool setAssembly(uint16_t instance, const std::vector<uint8_t> &data);
+    AdapterEmulatorStats stats() const;
+    // Forgets every connection without a Forward Close, as a power-cycled
+    // adapter would; the originators see their T->O traffic stop.
+    size_t dropConnections();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Triplet = std::tuple<uint16_t, uint16_t, uint32_t>; // serial, vendor, originator serial
+
+    struct Connection
+    {
+        Triplet triplet;
+        uint32_t o2tId{0};
+        uint32_t t2oId{0};
+        uint16_t consumed{0};
+        uint16_t produced{0};
+        std::chrono::microseconds rpi{0};
+        std::chrono::microseconds timeout{0};
+        sockaddr_in originator{};
+        Clock::time_point nextProduction;
+        Clock::time_point lastConsumed;
+        uint32_t encapsulationSequence{0};
+        uint16_t cipSequence{0};
+    };
+
+    struct Client
+    {
+        int fd{-1};
+        sockaddr_in peer{};
+        uint32_t session{0};
+        std::vector<uint8_t> buffer;
+    };
+
+    struct CipReply
+    {
+        uint8_t status{0};
+        std::vector<uint16_t> extendedStatus;
+        std::vector<uint8_t> data;
+        bool includeSocketAddress{false};
+    };
+
+    AdapterEmulatorConfig config_;
+    int listenFd_{-1};
+    int udpFd_{-1};
+    uint16_t tcpPort_{0};
+    uint16_t udpPort_{0};
+    std::atomic<bool> running_{false};
+    std::thread tcpThread_;
+    std::thread udpThread_;
+
+    mutable std::mutex mutex_;
+    std::map<uint16_t, std::vector<uint8_t>> assemblies_;
+    std::map<uint32_t, Connection> connections_; // by O->T connection id
+    uint32_t nextConnectionId_{0x10000};
+    uint32_t nextSession_{1};
+    AdapterEmulatorStats stats_;
+
+    void serveTcp();
+    void serveUdp();
+    bool handleEncapsulation(Client &client, std::vector<uint8_t> &reply);
+    CipReply handleRequest(const Client &client, uint8_t service, const std::vector<uint8_t> &path,
+                           const std::vector<uint8_t> &data);
+    CipReply forwardOpen(const Client &client, const std::vector<uint8_t> &data, bool large);
+    CipReply forwardClose(const std::vector<uint8_t> &data);
+    std::vector<uint8_t> identityItem() const;
+    std::vector<uint8_t> identityAttributes() const;
+    void consume(const std::vector<uint8_t> &datagram);
+    void produceDue(Clock::time_point now);
+};
@@ -0,0 +1,96 @@
+#include "AdapterEmulator.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+volatile std::sig_atomic_t stopRequested = 0;
+
+void usage()
+{
+    std::cerr << "usage: eip_adapter_emulator [--host ADDR] [--port PORT] [--originator-port PORT]\n"
+                 "                            [--assembly INSTANCE:BYTES]...\n";
+}
+
+bool parseAssembly(const std::string &text, EmulatedAssembly &assembly)
+{
+    const auto colon = text.find(':');
+    if (colon == std::string::npos)
+    {
+        return false;
+    }
+    const long instance = std::strtol(text.substr(0, colon).c_str(), nullptr, 0);
+    const long size = std::strtol(text.substr(colon + 1).c_str(), nullptr, 0);
+    if (instance <= 0 || instance > 0xFFFF || size <= 0 || size > 0xFFFF)
+    {
+        return false;
+    }
+    assembly.instance = static_cast<uint16_t>(instance);
+    assembly.sizeBytes = static_cast<uint16_t>(size);
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    AdapterEmulatorConfig config;
+    config.tcpPort = 44818;
+    std::vector<EmulatedAssembly> assemblies;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 2;
+        }
+        const std::string value = argv[++i];
+        EmulatedAssembly assembly;
+        if (arg == "--host")
+        {
+            config.host = value;
+        }
+        else if (arg == "--port")
+        {
+            config.tcpPort = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (arg == "--originator-port")
+        {
+            config.originatorUdpPort = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (arg == "--assembly" && parseAssembly(value, assembly))
+        {
+            assemblies.push_back(assembly);
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (!assemblies.empty())
+    {
+        config.assemblies = assemblies;
+    }
+
+    AdapterEmulator emulator(config);
+    std::string error;
+    if (!emulator.start(error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cout << "Emulating an adapter on " << config.host << ":" << emulator.tcpPort() << " (UDP "
+              << emulator.udpPort() << ")" << std::endl;
+
+    std::signal(SIGINT, [](int) { stopRequested = 1; });
+    std::signal(SIGTERM, [](int) { stopRequested = 1; });
+    while (!stopRequested)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    emulator.stop();
+    return 0;
+}
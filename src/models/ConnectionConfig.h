@@ -1,8 +1,30 @@
 #pragma once
 
 #include <json/json.h>
+
+#include <algorithm>
 #include <optional>
 
+// Connection size limits: a Forward Open carries a 9-bit size field, a Large
+// Forward Open a 16-bit one. The connection size covers the Class 1 header in
+// front of the assembly: a 16-bit sequence count, and a 32-bit run/idle
+// header in the real-time format that has one.
+constexpr uint16_t kForwardOpenMaxBytes = 511;
+constexpr uint16_t kLargeForwardOpenMaxBytes = 65535;
+constexpr uint16_t kSequenceCountBytes = 2;
+constexpr uint16_t kRunIdleHeaderBytes = 4;
+
+constexpr uint16_t class1HeaderBytes(bool runIdle)
+{
+    return kSequenceCountBytes + (runIdle ? kRunIdleHeaderBytes : 0);
+}
+
+// The largest assembly one direction of a connection can carry.
+constexpr uint16_t maxClass1AssemblyBytes(bool large, bool runIdle)
+{
+    return (large ? kLargeForwardOpenMaxBytes : kForwardOpenMaxBytes) - class1HeaderBytes(runIdle);
+}
+
 struct AssemblyInstanceConfig
 {
     uint16_t instance{0};
@@ -46,8 +68,17 @@ struct ConnectionConfig
     AssemblyInstanceConfig inputAssembly;
     std::optional<AssemblyInstanceConfig> configAssembly;
     uint32_t rpiUs{100000};
+    // Either side drops the connection after 4 << timeoutMultiplier RPIs without traffic.
+    uint8_t timeoutMultiplier{0};
     bool multicast{false};
     bool useLargeForwardOpen{false};
+    // Forward Open identity. Unset, each open picks a random connection serial
+    // under the simulator's own originator serial.
+    std::optional<uint16_t> connectionSerial;
+    std::optional<uint32_t> originatorSerial;
+
+    // Connections are opened without a run/idle header in either direction.
+    uint16_t maxAssemblyBytes() const { return maxClass1AssemblyBytes(useLargeForwardOpen, false); }
 
     Json::Value toJson() const
     {
@@ -59,8 +90,17 @@ struct ConnectionConfig
             value["configAssembly"] = configAssembly->toJson();
         }
         value["rpiUs"] = rpiUs;
+        value["timeoutMultiplier"] = timeoutMultiplier;
         value["multicast"] = multicast;
         value["useLargeForwardOpen"] = useLargeForwardOpen;
+        if (connectionSerial.has_value())
+        {
+            value["connectionSerial"] = *connectionSerial;
+        }
+        if (originatorSerial.has_value())
+        {
+            value["originatorSerial"] = *originatorSerial;
+        }
         return value;
     }
 
@@ -80,8 +120,17 @@ struct ConnectionConfig
             config.configAssembly = AssemblyInstanceConfig::fromJson(value["configAssembly"]);
         }
         config.rpiUs = value.get("rpiUs", 100000).asUInt();
+        config.timeoutMultiplier = static_cast<uint8_t>(std::min(value.get("timeoutMultiplier", 0).asUInt(), 255u));
         config.multicast = value.get("multicast", false).asBool();
         config.useLargeForwardOpen = value.get("useLargeForwardOpen", false).asBool();
+        if (value.isMember("connectionSerial"))
+        {
+            config.connectionSerial = static_cast<uint16_t>(value["connectionSerial"].asUInt());
+        }
+        if (value.isMember("originatorSerial"))
+        {
+            config.originatorSerial = value["originatorSerial"].asUInt();
+        }
         return config;
     }
 
@@ -105,11 +154,22 @@ struct ConnectionConfig
                 return false;
             }
         }
+        if (outputAssembly.sizeBytes > maxAssemblyBytes() || inputAssembly.sizeBytes > maxAssemblyBytes())
+        {
+            error = "Assemblies larger than " + std::to_string(maxAssemblyBytes()) + " bytes " +
+                    (useLargeForwardOpen ? "do not fit a Large Forward Open" : "require Large Forward Open");
+            return false;
+        }
         if (rpiUs == 0)
         {
             error = "RPI must be greater than zero";
             return false;
         }
+        if (timeoutMultiplier > 7)
+        {
+            error = "Timeout multiplier must be between 0 and 7";
+            return false;
+        }
         return true;
     }
 };
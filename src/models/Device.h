@@ -15,6 +15,8 @@ struct Device
     uint32_t timeoutMs{1000};
     std::optional<std::string> templateRef;
     std::optional<std::string> edsFile;
+    // Free-form fleet label (e.g. a car or consist) used to open and close devices together.
+    std::optional<std::string> group;
     std::optional<ConnectionConfig> connection;
     std::vector<SignalMapping> signals;
 
@@ -33,6 +35,10 @@ struct Device
         {
             value["edsFile"] = *edsFile;
         }
+        if (group.has_value())
+        {
+            value["group"] = *group;
+        }
         if (connection.has_value())
         {
             value["connection"] = connection->toJson();
@@ -61,6 +67,10 @@ struct Device
         {
             device.edsFile = value["edsFile"].asString();
         }
+        if (value.isMember("group"))
+        {
+            device.group = value["group"].asString();
+        }
         if (value.isMember("connection"))
         {
             device.connection = ConnectionConfig::fromJson(value["connection"]);
@@ -113,5 +123,5 @@ inline bool operator==(const Device &lhs, const Device &rhs)
 {
     return lhs.name == rhs.name && lhs.ipAddress == rhs.ipAddress && lhs.port == rhs.port &&
            lhs.timeoutMs == rhs.timeoutMs && lhs.templateRef == rhs.templateRef &&
-           lhs.edsFile == rhs.edsFile && lhs.signals == rhs.signals;
+           lhs.edsFile == rhs.edsFile && lhs.group == rhs.group && lhs.signals == rhs.signals;
 }
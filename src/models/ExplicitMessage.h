@@ -14,7 +14,13 @@ enum class PayloadType
     UInt16,
     UInt32,
     Int8,
-    Real32
+    Real32,
+    Int16,
+    Int32,
+    Int64,
+    UInt64,
+    Real64,
+    String
 };
 
 struct ExplicitMessageRequest
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// The "io.realtime" block: scheduling and memory settings for the I/O
+// threads. Control and HTTP threads keep the normal scheduler.
+struct IoRealtimeConfig
+{
+    bool enabled{false};
+    // SCHED_FIFO priority, 1-99.
+    int priority{80};
+    // mlockall(MCL_CURRENT | MCL_FUTURE) for the whole process.
+    bool lockMemory{true};
+    // Stack touched on each I/O thread at startup, at most 4096 KiB.
+    size_t prefaultStackKb{256};
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["enabled"] = enabled;
+        value["priority"] = priority;
+        value["lockMemory"] = lockMemory;
+        value["prefaultStackKb"] = static_cast<Json::UInt64>(prefaultStackKb);
+        return value;
+    }
+
+    static IoRealtimeConfig fromJson(const Json::Value &value)
+    {
+        IoRealtimeConfig config;
+        if (!value.isObject())
+        {
+            return config;
+        }
+        config.enabled = value.get("enabled", false).asBool();
+        config.priority = std::clamp(value.get("priority", config.priority).asInt(), 1, 99);
+        config.lockMemory = value.get("lockMemory", true).asBool();
+        config.prefaultStackKb = std::min(value.get("prefaultStackKb", 256).asUInt(), 4096u);
+        return config;
+    }
+};
+
+// The "io" block of custom_config: how many I/O threads service Class 1
+// connections and which CPUs they are pinned to.
+struct IoRuntimeConfig
+{
+    // Zero means one thread per online CPU.
+    size_t threads{0};
+    // Thread i is pinned to cpus[i % cpus.size()]; empty leaves placement to the scheduler.
+    std::vector<int> cpus;
+    // Threads running session setup, ForwardOpen and ForwardClose, so slow devices open in parallel.
+    size_t controlThreads{4};
+    IoRealtimeConfig realtime;
+
+    size_t threadCount() const
+    {
+        if (threads > 0)
+        {
+            return threads;
+        }
+        const auto cores = std::thread::hardware_concurrency();
+        return cores > 0 ? cores : 1;
+    }
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["threads"] = static_cast<Json::UInt64>(threads);
+        Json::Value list(Json::arrayValue);
+        for (int cpu : cpus)
+        {
+            list.append(cpu);
+        }
+        value["cpus"] = list;
+        value["controlThreads"] = static_cast<Json::UInt64>(controlThreads);
+        value["realtime"] = realtime.toJson();
+        return value;
+    }
+
+    static IoRuntimeConfig fromJson(const Json::Value &value)
+    {
+        IoRuntimeConfig config;
+        if (!value.isObject())
+        {
+            return config;
+        }
+        config.threads = value.get("threads", 0).asUInt();
+        config.controlThreads = std::max(1u, value.get("controlThreads", 4).asUInt());
+        config.realtime = IoRealtimeConfig::fromJson(value["realtime"]);
+        for (const auto &cpu : value["cpus"])
+        {
+            if (cpu.isInt() && cpu.asInt() >= 0)
+            {
+                config.cpus.push_back(cpu.asInt());
+            }
+        }
+        return config;
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <string>
+#include <vector>
+
+// How one device is expanded into virtual originators for a load test and
+// how they are ramped up.
+struct LoadTestSpec
+{
+    // Virtual originators in total, each with its own ForwardOpen.
+    uint32_t count{1};
+    // Originators opened per ramp step.
+    uint32_t step{1};
+    // How long each step runs before it is measured.
+    uint32_t holdMs{2000};
+    // ForwardOpens kept in flight while a step opens; 0 means no limit.
+    uint32_t parallelism{0};
+    // Originator i uses rpiUs[i % size]; empty keeps the device's RPI.
+    std::vector<uint32_t> rpiUs;
+    // Stop ramping at the first step where an open fails or a connection drops.
+    bool stopOnDrop{true};
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["count"] = count;
+        value["step"] = step;
+        value["holdMs"] = holdMs;
+        value["parallelism"] = parallelism;
+        Json::Value rpis(Json::arrayValue);
+        for (auto rpi : rpiUs)
+        {
+            rpis.append(rpi);
+        }
+        value["rpiUs"] = rpis;
+        value["stopOnDrop"] = stopOnDrop;
+        return value;
+    }
+
+    static LoadTestSpec fromJson(const Json::Value &value)
+    {
+        LoadTestSpec spec;
+        spec.count = value.get("count", 1).asUInt();
+        spec.step = value.get("step", spec.count).asUInt();
+        spec.holdMs = value.get("holdMs", 2000).asUInt();
+        spec.parallelism = value.get("parallelism", 0).asUInt();
+        for (const auto &rpi : value["rpiUs"])
+        {
+            spec.rpiUs.push_back(rpi.asUInt());
+        }
+        spec.stopOnDrop = value.get("stopOnDrop", true).asBool();
+        return spec;
+    }
+
+    bool isValid(std::string &error) const
+    {
+        if (count == 0 || count > 4096)
+        {
+            error = "count must be between 1 and 4096";
+            return false;
+        }
+        if (step == 0)
+        {
+            error = "step must be greater than zero";
+            return false;
+        }
+        for (auto rpi : rpiUs)
+        {
+            if (rpi == 0)
+            {
+                error = "RPI must be greater than zero";
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <string>
+
+// Which recorded stream to replay, where it goes and how fast.
+struct ReplaySpec
+{
+    // Recorded device name, and whether its received ("input") or sent ("output") frames are replayed.
+    std::string source;
+    std::string direction{"input"};
+    // "outputs" drives the target's O->T assembly; "inputs" feeds its input
+    // decoding as if the frames had been received, for offline analysis.
+    std::string target;
+    std::string mode{"outputs"};
+    // 1 keeps the recorded timing; 10 replays ten times faster.
+    double speed{1.0};
+    // Start over after the last frame until stopped.
+    bool loop{false};
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["source"] = source;
+        value["direction"] = direction;
+        value["target"] = target;
+        value["mode"] = mode;
+        value["speed"] = speed;
+        value["loop"] = loop;
+        return value;
+    }
+
+    static ReplaySpec fromJson(const Json::Value &value)
+    {
+        ReplaySpec spec;
+        spec.source = value.get("source", "").asString();
+        spec.direction = value.get("direction", spec.direction).asString();
+        spec.target = value.get("target", spec.source).asString();
+        spec.mode = value.get("mode", spec.mode).asString();
+        spec.speed = value.get("speed", 1.0).asDouble();
+        spec.loop = value.get("loop", false).asBool();
+        return spec;
+    }
+
+    bool isValid(std::string &error) const
+    {
+        if (source.empty() || target.empty())
+        {
+            error = "source and target are required";
+            return false;
+        }
+        if (direction != "input" && direction != "output")
+        {
+            error = "direction must be input or output";
+            return false;
+        }
+        if (mode != "outputs" && mode != "inputs")
+        {
+            error = "mode must be outputs or inputs";
+            return false;
+        }
+        if (!(speed > 0.0 && speed <= 1000.0))
+        {
+            error = "speed must be greater than 0 and at most 1000";
+            return false;
+        }
+        return true;
+    }
+};
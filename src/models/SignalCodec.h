@@ -0,0 +1,349 @@
+#pragma once
+
+#include "SignalMapping.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Wire formats of CIP signal types, shared by the cyclic I/O path and explicit
+// messaging. Every numeric (type, byte order) pair is its own WireCodec
+// instantiation, so loops grouped by codec inline a fixed-width load or store
+// and adding a type adds a group rather than a branch.
+namespace SignalCodec
+{
+template <size_t Width>
+struct RawWord;
+template <>
+struct RawWord<1>
+{
+    using type = uint8_t;
+};
+template <>
+struct RawWord<2>
+{
+    using type = uint16_t;
+};
+template <>
+struct RawWord<4>
+{
+    using type = uint32_t;
+};
+template <>
+struct RawWord<8>
+{
+    using type = uint64_t;
+};
+
+// Engineering-to-wire conversion: integers round and saturate (NaN maps to
+// the minimum), floating point types convert directly.
+template <typename T>
+T saturate(double raw)
+{
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        return static_cast<T>(raw);
+    }
+    else
+    {
+        if (!(raw > static_cast<double>(std::numeric_limits<T>::min())))
+        {
+            return std::numeric_limits<T>::min();
+        }
+        if (raw >= static_cast<double>(std::numeric_limits<T>::max()))
+        {
+            return std::numeric_limits<T>::max();
+        }
+        return static_cast<T>(std::round(raw));
+    }
+}
+
+template <typename T, ByteOrder Order>
+struct WireCodec
+{
+    using Raw = typename RawWord<sizeof(T)>::type;
+    static constexpr size_t kWidth = sizeof(T);
+
+    static T load(const uint8_t *data)
+    {
+        Raw raw = 0;
+        for (size_t i = 0; i < kWidth; ++i)
+        {
+            raw |= static_cast<Raw>(static_cast<Raw>(data[Order == ByteOrder::Little ? i : kWidth - 1 - i]) << (8 * i));
+        }
+        T value;
+        std::memcpy(&value, &raw, sizeof(T));
+        return value;
+    }
+
+    static void store(T value, uint8_t *data)
+    {
+        Raw raw;
+        std::memcpy(&raw, &value, sizeof(T));
+        for (size_t i = 0; i < kWidth; ++i)
+        {
+            data[Order == ByteOrder::Little ? i : kWidth - 1 - i] = static_cast<uint8_t>(raw >> (8 * i));
+        }
+    }
+
+    static double decode(const uint8_t *data) { return static_cast<double>(load(data)); }
+    static void encode(double raw, uint8_t *data) { store(saturate<T>(raw), data); }
+
+    // Exact text form, for 64-bit integers that do not survive a double.
+    static std::string format(const uint8_t *data)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            std::ostringstream ss;
+            ss.precision(std::numeric_limits<T>::digits10);
+            ss << load(data);
+            return ss.str();
+        }
+        else
+        {
+            return std::to_string(load(data));
+        }
+    }
+
+    static bool parse(const std::string &text, uint8_t *data, std::string &error)
+    {
+        if (text.empty())
+        {
+            error = "Payload is required";
+            return false;
+        }
+        try
+        {
+            size_t used = 0;
+            if constexpr (std::is_floating_point<T>::value)
+            {
+                store(static_cast<T>(std::stod(text, &used)), data);
+            }
+            else if constexpr (std::is_signed<T>::value)
+            {
+                const auto value = std::stoll(text, &used, 0);
+                if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+                {
+                    throw std::out_of_range("payload");
+                }
+                store(static_cast<T>(value), data);
+            }
+            else
+            {
+                if (text.front() == '-')
+                {
+                    throw std::out_of_range("payload");
+                }
+                const auto value = std::stoull(text, &used, 0);
+                if (value > std::numeric_limits<T>::max())
+                {
+                    throw std::out_of_range("payload");
+                }
+                store(static_cast<T>(value), data);
+            }
+            if (used != text.size())
+            {
+                throw std::invalid_argument("payload");
+            }
+            return true;
+        }
+        catch (const std::out_of_range &)
+        {
+            if constexpr (std::is_floating_point<T>::value)
+            {
+                error = "Invalid floating point payload";
+            }
+            else
+            {
+                error = "Payload must be between " + std::to_string(std::numeric_limits<T>::min()) + " and " +
+                        std::to_string(std::numeric_limits<T>::max());
+            }
+        }
+        catch (const std::exception &)
+        {
+            error = std::is_floating_point<T>::value ? "Invalid floating point payload" : "Invalid number for Payload";
+        }
+        return false;
+    }
+};
+
+// Scalar codecs are laid out as [type index * 2 + byte order].
+using ScalarTypes = std::tuple<uint8_t, int8_t, uint16_t, int16_t, uint32_t, int32_t, uint64_t, int64_t, float, double>;
+constexpr size_t kScalarCodecCount = std::tuple_size<ScalarTypes>::value * 2;
+
+template <size_t Index>
+using ScalarCodecAt = WireCodec<std::tuple_element_t<Index / 2, ScalarTypes>, Index % 2 ? ByteOrder::Big : ByteOrder::Little>;
+
+// Position of a numeric type in ScalarTypes, or -1 for Bool, Bits and String.
+constexpr int scalarTypeIndex(SignalType type)
+{
+    switch (type)
+    {
+    case SignalType::UInt8:
+        return 0;
+    case SignalType::SInt:
+        return 1;
+    case SignalType::UInt16:
+        return 2;
+    case SignalType::Int16:
+        return 3;
+    case SignalType::UInt32:
+        return 4;
+    case SignalType::Int32:
+        return 5;
+    case SignalType::UInt64:
+        return 6;
+    case SignalType::Int64:
+        return 7;
+    case SignalType::Real32:
+        return 8;
+    case SignalType::Real64:
+        return 9;
+    default:
+        return -1;
+    }
+}
+
+constexpr int scalarCodecIndex(SignalType type, ByteOrder order)
+{
+    const int index = scalarTypeIndex(type);
+    return index < 0 ? -1 : index * 2 + (order == ByteOrder::Big ? 1 : 0);
+}
+
+struct ScalarCodec
+{
+    size_t width;
+    double (*decode)(const uint8_t *);
+    void (*encode)(double, uint8_t *);
+    std::string (*format)(const uint8_t *);
+    bool (*parse)(const std::string &, uint8_t *, std::string &);
+};
+
+template <size_t... Index>
+constexpr std::array<ScalarCodec, sizeof...(Index)> makeScalarCodecs(std::index_sequence<Index...>)
+{
+    return {{{ScalarCodecAt<Index>::kWidth, &ScalarCodecAt<Index>::decode, &ScalarCodecAt<Index>::encode,
+              &ScalarCodecAt<Index>::format, &ScalarCodecAt<Index>::parse}...}};
+}
+
+inline constexpr auto kScalarCodecs = makeScalarCodecs(std::make_index_sequence<kScalarCodecCount>{});
+
+// Bitfields load the covering bytes (at most eight) as one word, then shift and mask.
+inline uint64_t loadBits(const uint8_t *data, size_t width, ByteOrder order, uint8_t shift, uint64_t mask)
+{
+    if (shift >= 64)
+    {
+        return 0;
+    }
+    uint64_t raw = 0;
+    for (size_t i = 0; i < width; ++i)
+    {
+        raw |= static_cast<uint64_t>(data[order == ByteOrder::Little ? i : width - 1 - i]) << (8 * i);
+    }
+    return (raw >> shift) & mask;
+}
+
+inline void storeBits(uint64_t value, uint8_t *data, size_t width, ByteOrder order, uint8_t shift, uint64_t mask)
+{
+    if (shift >= 64)
+    {
+        return;
+    }
+    uint64_t raw = 0;
+    for (size_t i = 0; i < width; ++i)
+    {
+        raw |= static_cast<uint64_t>(data[order == ByteOrder::Little ? i : width - 1 - i]) << (8 * i);
+    }
+    raw = (raw & ~(mask << shift)) | ((value & mask) << shift);
+    for (size_t i = 0; i < width; ++i)
+    {
+        data[order == ByteOrder::Little ? i : width - 1 - i] = static_cast<uint8_t>(raw >> (8 * i));
+    }
+}
+
+inline uint64_t bitMask(const SignalMapping &mapping)
+{
+    const unsigned shift = mapping.bitOffset.value_or(0);
+    const unsigned bits = std::min<unsigned>(mapping.bitWidth, 64 - std::min(shift, 63u));
+    return bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+}
+
+inline std::string decodeText(const uint8_t *data, size_t length)
+{
+    const auto *end = static_cast<const uint8_t *>(std::memchr(data, 0, length));
+    return std::string(reinterpret_cast<const char *>(data), end ? static_cast<size_t>(end - data) : length);
+}
+
+inline void encodeText(const std::string &text, uint8_t *data, size_t length)
+{
+    const auto used = std::min(text.size(), length);
+    std::memcpy(data, text.data(), used);
+    std::memset(data + used, 0, length - used);
+}
+
+// Raw (unscaled) value of any mapping; zero when the signal does not fit in `size` bytes.
+inline double decodeRaw(const SignalMapping &mapping, const uint8_t *data, size_t size)
+{
+    const size_t offset = mapping.byteOffset;
+    if (offset + mapping.widthBytes() > size || mapping.type == SignalType::String)
+    {
+        return 0.0;
+    }
+    switch (mapping.type)
+    {
+    case SignalType::Bool:
+    {
+        const uint8_t bit = mapping.bitOffset.value_or(8);
+        return (bit < 8 ? (data[offset] >> bit) & 0x01 : data[offset]) ? 1.0 : 0.0;
+    }
+    case SignalType::Bits:
+        return static_cast<double>(loadBits(data + offset, mapping.widthBytes(), mapping.byteOrder,
+                                            mapping.bitOffset.value_or(0), bitMask(mapping)));
+    default:
+        return kScalarCodecs[scalarCodecIndex(mapping.type, mapping.byteOrder)].decode(data + offset);
+    }
+}
+
+// Writes a raw (unscaled) value; signals outside `size` bytes and strings are left untouched.
+inline void encodeRaw(const SignalMapping &mapping, double raw, uint8_t *data, size_t size)
+{
+    const size_t offset = mapping.byteOffset;
+    if (offset + mapping.widthBytes() > size || mapping.type == SignalType::String)
+    {
+        return;
+    }
+    switch (mapping.type)
+    {
+    case SignalType::Bool:
+    {
+        const bool set = std::fabs(raw) >= 0.5;
+        const uint8_t bit = mapping.bitOffset.value_or(8);
+        if (!mapping.bitOffset.has_value())
+        {
+            data[offset] = set ? 1 : 0;
+        }
+        else if (bit < 8)
+        {
+            data[offset] = set ? static_cast<uint8_t>(data[offset] | (1u << bit))
+                               : static_cast<uint8_t>(data[offset] & ~(1u << bit));
+        }
+        break;
+    }
+    case SignalType::Bits:
+    {
+        const auto mask = bitMask(mapping);
+        storeBits(std::min(saturate<uint64_t>(raw), mask), data + offset, mapping.widthBytes(), mapping.byteOrder,
+                  mapping.bitOffset.value_or(0), mask);
+        break;
+    }
+    default:
+        kScalarCodecs[scalarCodecIndex(mapping.type, mapping.byteOrder)].encode(raw, data + offset);
+        break;
+    }
+}
+} // namespace SignalCodec
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <json/json.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+enum class GeneratorType
+{
+    Ramp,
+    Sine,
+    Square,
+    Steps,
+    RandomWalk
+};
+
+inline const char *generatorTypeName(GeneratorType type)
+{
+    switch (type)
+    {
+    case GeneratorType::Ramp:
+        return "ramp";
+    case GeneratorType::Sine:
+        return "sine";
+    case GeneratorType::Square:
+        return "square";
+    case GeneratorType::Steps:
+        return "steps";
+    case GeneratorType::RandomWalk:
+        return "randomWalk";
+    }
+    return "sine";
+}
+
+inline std::optional<GeneratorType> parseGeneratorType(const std::string &name)
+{
+    for (const auto type : {GeneratorType::Ramp, GeneratorType::Sine, GeneratorType::Square, GeneratorType::Steps,
+                            GeneratorType::RandomWalk})
+    {
+        if (name == generatorTypeName(type))
+        {
+            return type;
+        }
+    }
+    return std::nullopt;
+}
+
+struct GeneratorStep
+{
+    double value{0.0};
+    uint32_t holdMs{0};
+
+    Json::Value toJson() const
+    {
+        Json::Value v;
+        v["value"] = value;
+        v["holdMs"] = holdMs;
+        return v;
+    }
+
+    static GeneratorStep fromJson(const Json::Value &value)
+    {
+        GeneratorStep step;
+        step.value = value.get("value", 0.0).asDouble();
+        step.holdMs = value.get("holdMs", 0).asUInt();
+        return step;
+    }
+};
+
+inline bool operator==(const GeneratorStep &lhs, const GeneratorStep &rhs)
+{
+    return lhs.value == rhs.value && lhs.holdMs == rhs.holdMs;
+}
+
+// Drives an output signal from the send path, in engineering units. Ramp,
+// sine and square span low..high once per periodMs; a step sequence holds
+// each value for its holdMs and then repeats. `phase` shifts a waveform by a
+// fraction of its period. A random walk moves by at most stepSize every
+// periodMs, starting midway and staying within low..high.
+struct SignalGenerator
+{
+    GeneratorType type{GeneratorType::Sine};
+    double low{0.0};
+    double high{1.0};
+    uint32_t periodMs{1000};
+    double phase{0.0};
+    // Square only: fraction of each period spent at high.
+    double duty{0.5};
+    std::vector<GeneratorStep> steps;
+    double stepSize{1.0};
+    // Random walks with the same seed repeat the same path.
+    uint32_t seed{1};
+
+    // Periods and holds in microseconds; steps repeat after the sum of their holds.
+    int64_t cycleUs() const
+    {
+        if (type != GeneratorType::Steps)
+        {
+            return static_cast<int64_t>(periodMs) * 1000;
+        }
+        int64_t total = 0;
+        for (const auto &step : steps)
+        {
+            total += static_cast<int64_t>(step.holdMs) * 1000;
+        }
+        return total;
+    }
+
+    // Value of a periodic waveform `elapsedUs` after the generator epoch.
+    // The position within the cycle is taken in integer microseconds so long
+    // runs keep their phase. Random walks are stateful and evaluated by the caller.
+    double valueAt(int64_t elapsedUs) const
+    {
+        const auto cycle = cycleUs();
+        double position = static_cast<double>(elapsedUs % cycle) / static_cast<double>(cycle) + phase;
+        position -= std::floor(position);
+        switch (type)
+        {
+        case GeneratorType::Ramp:
+            return low + (high - low) * position;
+        case GeneratorType::Sine:
+            return (low + high) / 2.0 + (high - low) / 2.0 * std::sin(2.0 * M_PI * position);
+        case GeneratorType::Square:
+            return position < duty ? high : low;
+        case GeneratorType::Steps:
+        {
+            auto at = static_cast<int64_t>(position * static_cast<double>(cycle));
+            for (const auto &step : steps)
+            {
+                at -= static_cast<int64_t>(step.holdMs) * 1000;
+                if (at < 0)
+                {
+                    return step.value;
+                }
+            }
+            return steps.back().value;
+        }
+        case GeneratorType::RandomWalk:
+            break;
+        }
+        return (low + high) / 2.0;
+    }
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["type"] = generatorTypeName(type);
+        if (type == GeneratorType::Steps)
+        {
+            Json::Value stepArray(Json::arrayValue);
+            for (const auto &step : steps)
+            {
+                stepArray.append(step.toJson());
+            }
+            value["steps"] = stepArray;
+        }
+        else
+        {
+            value["low"] = low;
+            value["high"] = high;
+            value["periodMs"] = periodMs;
+        }
+        if (type == GeneratorType::Square)
+        {
+            value["duty"] = duty;
+        }
+        if (type == GeneratorType::RandomWalk)
+        {
+            value["stepSize"] = stepSize;
+            value["seed"] = seed;
+        }
+        else
+        {
+            value["phase"] = phase;
+        }
+        return value;
+    }
+
+    static SignalGenerator fromJson(const Json::Value &value)
+    {
+        SignalGenerator generator;
+        generator.type = parseGeneratorType(value.get("type", "sine").asString()).value_or(GeneratorType::Sine);
+        generator.low = value.get("low", 0.0).asDouble();
+        generator.high = value.get("high", 1.0).asDouble();
+        generator.periodMs = value.get("periodMs", 1000).asUInt();
+        generator.phase = value.get("phase", 0.0).asDouble();
+        generator.duty = value.get("duty", 0.5).asDouble();
+        if (value.isMember("steps") && value["steps"].isArray())
+        {
+            for (const auto &step : value["steps"])
+            {
+                generator.steps.push_back(GeneratorStep::fromJson(step));
+            }
+        }
+        generator.stepSize = value.get("stepSize", 1.0).asDouble();
+        generator.seed = value.get("seed", 1).asUInt();
+        return generator;
+    }
+
+    bool isValid(std::string &error) const
+    {
+        if (type == GeneratorType::Steps)
+        {
+            if (steps.empty() || cycleUs() == 0)
+            {
+                error = "steps need at least one step with a non-zero holdMs";
+                return false;
+            }
+            return true;
+        }
+        if (periodMs == 0)
+        {
+            error = "periodMs must be greater than zero";
+            return false;
+        }
+        if (!(low <= high))
+        {
+            error = "low must not exceed high";
+            return false;
+        }
+        if (type == GeneratorType::Square && !(duty >= 0.0 && duty <= 1.0))
+        {
+            error = "duty must be between 0 and 1";
+            return false;
+        }
+        if (type == GeneratorType::RandomWalk && !(stepSize >= 0.0))
+        {
+            error = "stepSize must not be negative";
+            return false;
+        }
+        return true;
+    }
+};
+
+inline bool operator==(const SignalGenerator &lhs, const SignalGenerator &rhs)
+{
+    return lhs.type == rhs.type && lhs.low == rhs.low && lhs.high == rhs.high && lhs.periodMs == rhs.periodMs &&
+           lhs.phase == rhs.phase && lhs.duty == rhs.duty && lhs.steps == rhs.steps && lhs.stepSize == rhs.stepSize &&
+           lhs.seed == rhs.seed;
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "SignalGenerator.h"
+#include "SignalRule.h"
+
+#include <algorithm>
 #include <cstdint>
 #include <json/json.h>
 #include <optional>
@@ -13,6 +17,9 @@ enum class SignalDirection
     Output
 };
 
+// CIP elementary types. UInt8/SInt/UInt16/UInt32 are USINT/SINT/UINT/UDINT;
+// Bits is an unsigned bitfield of bitWidth bits starting at bitOffset and
+// String a fixed-length, NUL-padded character field.
 enum class SignalType
 {
     Bool,
@@ -20,7 +27,84 @@ enum class SignalType
     UInt16,
     UInt32,
     SInt,
-    Real32
+    Real32,
+    Int16,
+    Int32,
+    Int64,
+    UInt64,
+    Real64,
+    Bits,
+    String
+};
+
+enum class ByteOrder
+{
+    Little,
+    Big
+};
+
+inline const char *signalTypeName(SignalType type)
+{
+    switch (type)
+    {
+    case SignalType::Bool:
+        return "bool";
+    case SignalType::UInt8:
+        return "uint8";
+    case SignalType::UInt16:
+        return "uint16";
+    case SignalType::UInt32:
+        return "uint32";
+    case SignalType::SInt:
+        return "sint";
+    case SignalType::Real32:
+        return "real32";
+    case SignalType::Int16:
+        return "int";
+    case SignalType::Int32:
+        return "dint";
+    case SignalType::Int64:
+        return "lint";
+    case SignalType::UInt64:
+        return "ulint";
+    case SignalType::Real64:
+        return "lreal";
+    case SignalType::Bits:
+        return "bits";
+    case SignalType::String:
+        return "string";
+    }
+    return "uint8";
+}
+
+// Accepts the names above plus the CIP spellings of the original types.
+inline std::optional<SignalType> parseSignalType(const std::string &name)
+{
+    static const std::pair<const char *, SignalType> aliases[] = {
+        {"bool", SignalType::Bool},     {"uint8", SignalType::UInt8},   {"usint", SignalType::UInt8},
+        {"uint16", SignalType::UInt16}, {"uint", SignalType::UInt16},   {"uint32", SignalType::UInt32},
+        {"udint", SignalType::UInt32},  {"sint", SignalType::SInt},     {"real32", SignalType::Real32},
+        {"real", SignalType::Real32},   {"int", SignalType::Int16},     {"dint", SignalType::Int32},
+        {"lint", SignalType::Int64},    {"ulint", SignalType::UInt64},  {"lreal", SignalType::Real64},
+        {"bits", SignalType::Bits},     {"string", SignalType::String},
+    };
+    for (const auto &alias : aliases)
+    {
+        if (name == alias.first)
+        {
+            return alias.second;
+        }
+    }
+    return std::nullopt;
+}
+
+// How far a decoded input must move before it is reported as changed.
+// Percent deadbands are relative to the last reported value.
+enum class DeadbandMode
+{
+    None,
+    Absolute,
+    Percent
 };
 
 struct SignalEnumOption
@@ -57,10 +141,23 @@ struct SignalMapping
     SignalType type{SignalType::UInt8};
     uint16_t byteOffset{0};
     std::optional<uint8_t> bitOffset;
+    // Bits only; fields wider than 64 bits are truncated.
+    uint8_t bitWidth{1};
+    // String only.
+    uint16_t stringLength{0};
+    ByteOrder byteOrder{ByteOrder::Little};
     double scale{1.0};
     double engineeringOffset{0.0};
     std::string units;
     std::vector<SignalEnumOption> enums;
+    DeadbandMode deadbandMode{DeadbandMode::None};
+    double deadband{0.0};
+    // Samples kept for trends; zero uses the service default.
+    uint32_t historyDepth{0};
+    // Outputs only; replaces manual writes with a waveform evaluated every send.
+    std::optional<SignalGenerator> generator;
+    // Outputs only; computes the output from inputs of any device.
+    std::optional<SignalRule> rule;
 
     size_t widthBytes() const
     {
@@ -71,10 +168,20 @@ struct SignalMapping
         case SignalType::SInt:
             return 1;
         case SignalType::UInt16:
+        case SignalType::Int16:
             return 2;
         case SignalType::UInt32:
+        case SignalType::Int32:
         case SignalType::Real32:
             return 4;
+        case SignalType::UInt64:
+        case SignalType::Int64:
+        case SignalType::Real64:
+            return 8;
+        case SignalType::Bits:
+            return std::min<size_t>(8, (bitOffset.value_or(0) + bitWidth + 7) / 8);
+        case SignalType::String:
+            return stringLength;
         default:
             throw std::runtime_error("Unsupported signal type");
         }
@@ -85,32 +192,24 @@ struct SignalMapping
         Json::Value value;
         value["name"] = name;
         value["direction"] = direction == SignalDirection::Input ? "input" : "output";
-        switch (type)
-        {
-        case SignalType::Bool:
-            value["type"] = "bool";
-            break;
-        case SignalType::UInt8:
-            value["type"] = "uint8";
-            break;
-        case SignalType::UInt16:
-            value["type"] = "uint16";
-            break;
-        case SignalType::UInt32:
-            value["type"] = "uint32";
-            break;
-        case SignalType::SInt:
-            value["type"] = "sint";
-            break;
-        case SignalType::Real32:
-            value["type"] = "real32";
-            break;
-        }
+        value["type"] = signalTypeName(type);
         value["byteOffset"] = byteOffset;
         if (bitOffset.has_value())
         {
             value["bitOffset"] = *bitOffset;
         }
+        if (type == SignalType::Bits)
+        {
+            value["bitWidth"] = bitWidth;
+        }
+        if (type == SignalType::String)
+        {
+            value["stringLength"] = stringLength;
+        }
+        if (byteOrder == ByteOrder::Big)
+        {
+            value["byteOrder"] = "big";
+        }
         value["scale"] = scale;
         value["engineeringOffset"] = engineeringOffset;
         value["units"] = units;
@@ -120,6 +219,23 @@ struct SignalMapping
             enumArray.append(opt.toJson());
         }
         value["enums"] = enumArray;
+        if (deadbandMode != DeadbandMode::None)
+        {
+            value["deadbandMode"] = deadbandMode == DeadbandMode::Percent ? "percent" : "absolute";
+            value["deadband"] = deadband;
+        }
+        if (historyDepth > 0)
+        {
+            value["historyDepth"] = historyDepth;
+        }
+        if (generator.has_value())
+        {
+            value["generator"] = generator->toJson();
+        }
+        if (rule.has_value())
+        {
+            value["rule"] = rule->toJson();
+        }
         return value;
     }
 
@@ -129,36 +245,15 @@ struct SignalMapping
         mapping.name = value.get("name", "").asString();
         const auto dir = value.get("direction", "input").asString();
         mapping.direction = dir == "output" ? SignalDirection::Output : SignalDirection::Input;
-        const auto typeStr = value.get("type", "uint8").asString();
-        if (typeStr == "bool")
-        {
-            mapping.type = SignalType::Bool;
-        }
-        else if (typeStr == "uint16")
-        {
-            mapping.type = SignalType::UInt16;
-        }
-        else if (typeStr == "uint32")
-        {
-            mapping.type = SignalType::UInt32;
-        }
-        else if (typeStr == "sint")
-        {
-            mapping.type = SignalType::SInt;
-        }
-        else if (typeStr == "real32")
-        {
-            mapping.type = SignalType::Real32;
-        }
-        else
-        {
-            mapping.type = SignalType::UInt8;
-        }
+        mapping.type = parseSignalType(value.get("type", "uint8").asString()).value_or(SignalType::UInt8);
         mapping.byteOffset = static_cast<uint16_t>(value.get("byteOffset", 0).asUInt());
         if (value.isMember("bitOffset"))
         {
             mapping.bitOffset = static_cast<uint8_t>(value.get("bitOffset", 0).asUInt());
         }
+        mapping.bitWidth = static_cast<uint8_t>(std::clamp(value.get("bitWidth", 1).asUInt(), 1u, 64u));
+        mapping.stringLength = static_cast<uint16_t>(value.get("stringLength", 0).asUInt());
+        mapping.byteOrder = value.get("byteOrder", "little").asString() == "big" ? ByteOrder::Big : ByteOrder::Little;
         mapping.scale = value.get("scale", 1.0).asDouble();
         mapping.engineeringOffset = value.get("engineeringOffset", 0.0).asDouble();
         mapping.units = value.get("units", "").asString();
@@ -169,6 +264,25 @@ struct SignalMapping
                 mapping.enums.push_back(SignalEnumOption::fromJson(opt));
             }
         }
+        const auto deadbandMode = value.get("deadbandMode", "").asString();
+        if (deadbandMode == "absolute")
+        {
+            mapping.deadbandMode = DeadbandMode::Absolute;
+        }
+        else if (deadbandMode == "percent")
+        {
+            mapping.deadbandMode = DeadbandMode::Percent;
+        }
+        mapping.deadband = value.get("deadband", 0.0).asDouble();
+        mapping.historyDepth = value.get("historyDepth", 0).asUInt();
+        if (value.isMember("generator") && value["generator"].isObject())
+        {
+            mapping.generator = SignalGenerator::fromJson(value["generator"]);
+        }
+        if (value.isMember("rule") && value["rule"].isObject())
+        {
+            mapping.rule = SignalRule::fromJson(value["rule"]);
+        }
         return mapping;
     }
 };
@@ -176,14 +290,22 @@ struct SignalMapping
 struct SignalValue
 {
     SignalMapping mapping;
+    uint32_t handle{0};
     double engineeringValue{0.0};
     double rawValue{0.0};
+    // String signals only.
+    std::string textValue;
 
     Json::Value toJson() const
     {
         Json::Value v = mapping.toJson();
+        v["handle"] = handle;
         v["engineeringValue"] = engineeringValue;
         v["rawValue"] = rawValue;
+        if (mapping.type == SignalType::String)
+        {
+            v["textValue"] = textValue;
+        }
         return v;
     }
 };
@@ -191,8 +313,11 @@ struct SignalValue
 inline bool operator==(const SignalMapping &lhs, const SignalMapping &rhs)
 {
     return lhs.name == rhs.name && lhs.direction == rhs.direction && lhs.type == rhs.type &&
-           lhs.byteOffset == rhs.byteOffset && lhs.bitOffset == rhs.bitOffset && lhs.scale == rhs.scale &&
-           lhs.engineeringOffset == rhs.engineeringOffset && lhs.units == rhs.units && lhs.enums == rhs.enums;
+           lhs.byteOffset == rhs.byteOffset && lhs.bitOffset == rhs.bitOffset && lhs.bitWidth == rhs.bitWidth &&
+           lhs.stringLength == rhs.stringLength && lhs.byteOrder == rhs.byteOrder && lhs.scale == rhs.scale &&
+           lhs.engineeringOffset == rhs.engineeringOffset && lhs.units == rhs.units && lhs.enums == rhs.enums &&
+           lhs.deadbandMode == rhs.deadbandMode && lhs.deadband == rhs.deadband && lhs.historyDepth == rhs.historyDepth &&
+           lhs.generator == rhs.generator && lhs.rule == rhs.rule;
 }
 
 inline bool operator!=(const SignalMapping &lhs, const SignalMapping &rhs)
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <json/json.h>
+#include <string>
+
+// Sets an output from decoded inputs on the I/O thread. `value` is written
+// whenever a packet arrives for a device it reads. With `when`, it is written
+// only on packets where `when` turns true, so the output stays writable
+// between firings. The expression syntax is described in RuleProgram.h.
+struct SignalRule
+{
+    std::string when;
+    std::string value{"1"};
+
+    Json::Value toJson() const
+    {
+        Json::Value v;
+        if (!when.empty())
+        {
+            v["when"] = when;
+        }
+        v["value"] = value;
+        return v;
+    }
+
+    static SignalRule fromJson(const Json::Value &value)
+    {
+        SignalRule rule;
+        rule.when = value.get("when", "").asString();
+        rule.value = value.get("value", "1").asString();
+        return rule;
+    }
+};
+
+inline bool operator==(const SignalRule &lhs, const SignalRule &rhs)
+{
+    return lhs.when == rhs.when && lhs.value == rhs.value;
+}
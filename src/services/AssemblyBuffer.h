@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Fixed-capacity byte buffer for assembly frames. Storage is allocated once
+// by reserve() when a connection is configured; assign() and resize() never
+// allocate and clamp to the capacity instead.
+class AssemblyBuffer
+{
+public:
+    AssemblyBuffer() = default;
+    explicit AssemblyBuffer(size_t capacity) { reserve(capacity); }
+
+    AssemblyBuffer(const AssemblyBuffer &other) { *this = other; }
+
+    AssemblyBuffer &operator=(const AssemblyBuffer &other)
+    {
+        if (this != &other)
+        {
+            if (capacity_ != other.capacity_)
+            {
+                reserve(other.capacity_);
+            }
+            assign(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    void reserve(size_t capacity)
+    {
+        data_ = capacity > 0 ? std::make_unique<uint8_t[]>(capacity) : nullptr;
+        capacity_ = capacity;
+        size_ = 0;
+    }
+
+    void assign(const uint8_t *data, size_t size)
+    {
+        size_ = std::min(size, capacity_);
+        if (size_ > 0)
+        {
+            std::memcpy(data_.get(), data, size_);
+        }
+    }
+
+    void resize(size_t size)
+    {
+        size = std::min(size, capacity_);
+        if (size > size_)
+        {
+            std::memset(data_.get() + size_, 0, size - size_);
+        }
+        size_ = size;
+    }
+
+    uint8_t *data() { return data_.get(); }
+    const uint8_t *data() const { return data_.get(); }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    std::vector<uint8_t> toVector() const { return std::vector<uint8_t>(data_.get(), data_.get() + size_); }
+
+private:
+    std::unique_ptr<uint8_t[]> data_;
+    size_t capacity_{0};
+    size_t size_{0};
+};
@@ -0,0 +1,536 @@
+#include "Class1Transport.h"
+
+#include <EIPScanner/MessageRouter.h>
+#include <EIPScanner/cip/EPath.h>
+#include <EIPScanner/cip/connectionManager/ForwardCloseRequest.h>
+#include <EIPScanner/cip/connectionManager/ForwardOpenRequest.h>
+#include <EIPScanner/cip/connectionManager/ForwardOpenResponse.h>
+#include <EIPScanner/cip/connectionManager/LargeForwardOpenRequest.h>
+#include <EIPScanner/cip/connectionManager/NetworkConnectionParametersBuilder.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace
+{
+constexpr uint8_t kForwardOpen = 0x54;
+constexpr uint8_t kLargeForwardOpen = 0x5B;
+constexpr uint8_t kForwardClose = 0x4E;
+constexpr uint16_t kConnectionManagerClass = 0x06;
+
+constexpr uint16_t kConnectedDataItem = 0x00B1;
+constexpr uint16_t kO2TSocketAddressItem = 0x8000;
+constexpr uint16_t kT2OSocketAddressItem = 0x8001;
+constexpr uint16_t kSequencedAddressItem = 0x8002;
+
+// Item count, sequenced address item (connection id, encapsulation
+// sequence), then the connected data item header and the CIP sequence count.
+constexpr size_t kEncapsulationSequenceOffset = 10;
+constexpr size_t kDataLengthOffset = 16;
+constexpr size_t kCipSequenceOffset = 18;
+constexpr size_t kHeaderSize = 20;
+constexpr uint32_t kRun = 1;
+
+constexpr int kReceiveBufferBytes = 4 * 1024 * 1024;
+constexpr size_t kMaxDatagram = 65536;
+
+void put16(uint8_t *at, uint16_t value)
+{
+    at[0] = static_cast<uint8_t>(value);
+    at[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void put32(uint8_t *at, uint32_t value)
+{
+    put16(at, static_cast<uint16_t>(value));
+    put16(at + 2, static_cast<uint16_t>(value >> 16));
+}
+
+uint16_t get16(const uint8_t *at)
+{
+    return static_cast<uint16_t>(at[0] | at[1] << 8);
+}
+
+uint32_t get32(const uint8_t *at)
+{
+    return get16(at) | static_cast<uint32_t>(get16(at + 2)) << 16;
+}
+
+uint64_t keyOf(in_addr_t source, uint32_t t2oId)
+{
+    return static_cast<uint64_t>(source) << 32 | t2oId;
+}
+
+std::string hex(unsigned value, int digits)
+{
+    char text[16];
+    std::snprintf(text, sizeof(text), "0x%0*X", digits, value);
+    return text;
+}
+
+std::string describeFailure(const char *request, const eipScanner::cip::MessageRouterResponse &response)
+{
+    auto message = std::string(request) + " failed: general status " + hex(response.getGeneralStatusCode(), 2);
+    for (const auto status : response.getAdditionalStatus())
+    {
+        message += ", extended status " + hex(status, 4);
+    }
+    return message;
+}
+
+// Socket address items are big-endian: family, port, address, eight zero bytes.
+bool readSocketAddress(const std::vector<uint8_t> &item, in_port_t &port, in_addr_t &address)
+{
+    if (item.size() < 8)
+    {
+        return false;
+    }
+    std::memcpy(&port, &item[2], sizeof(port));
+    std::memcpy(&address, &item[4], sizeof(address));
+    return true;
+}
+
+void notify(int fd)
+{
+    const uint64_t one = 1;
+    // Only fails when the counter is saturated, in which case it is already readable.
+    if (::write(fd, &one, sizeof(one)) < 0)
+    {
+        return;
+    }
+}
+} // namespace
+
+Class1Connection::Class1Connection()
+{
+    inputFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inputFd_ < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Class1Connection");
+    }
+}
+
+Class1Connection::~Class1Connection()
+{
+    ::close(inputFd_);
+}
+
+void Class1Connection::send()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    // Checked again after receivePending, which may have just seen the missing packet delivered.
+    const auto now = Clock::now();
+    if (timedOut(now) && !receivePending() && timedOut(now))
+    {
+        open_.store(false, std::memory_order_release);
+        if (close_)
+        {
+            close_();
+        }
+        return;
+    }
+
+    ++cipSequence_;
+    if (send_)
+    {
+        send_(cipSequence_, output_);
+    }
+    put32(&packet_[kEncapsulationSequenceOffset], ++encapsulationSequence_);
+    put16(&packet_[kCipSequenceOffset], cipSequence_);
+    std::copy_n(output_.begin(), std::min(output_.size(), packet_.size() - dataOffset_), packet_.begin() + dataOffset_);
+    // A full socket buffer drops this cycle's packet; the next cycle sends fresh data anyway.
+    ::sendto(fd_, packet_.data(), packet_.size(), MSG_DONTWAIT, reinterpret_cast<const sockaddr *>(&target_),
+             sizeof(target_));
+}
+
+bool Class1Connection::timedOut(Clock::time_point now) const
+{
+    return now - Clock::time_point(Clock::duration(lastReceived_.load())) > timeout_;
+}
+
+// After a stall the I/O thread can run before the receive thread, with T->O
+// packets still queued on the socket or being handed out. Those count as
+// received, so only a caught-up receive thread lets the connection time out.
+bool Class1Connection::receivePending() const
+{
+    int queued = 0;
+    return (receiving_ && receiving_->load()) || (::ioctl(fd_, FIONREAD, &queued) == 0 && queued > 0);
+}
+
+void Class1Connection::receive()
+{
+    uint64_t count;
+    while (::read(inputFd_, &count, sizeof(count)) == sizeof(count))
+    {
+    }
+    // Cleared before the queue is read, so a packet queued from here on signals again.
+    signalled_.store(false);
+
+    auto head = receiveHead_.load(std::memory_order_relaxed);
+    while (head != receiveTail_.load())
+    {
+        const auto &packet = received_[head % kReceiveSlots];
+        if (receive_)
+        {
+            receive_(packet.at, packet.encapsulationSequence, packet.sequence, packet.data);
+        }
+        receiveHead_.store(++head, std::memory_order_release);
+    }
+}
+
+void Class1Connection::deliver(uint32_t encapsulationSequence, const uint8_t *data, size_t size,
+                               Clock::time_point now)
+{
+    const size_t header = class1HeaderBytes(t2oRunIdle_);
+    if (!isOpen() || size < header)
+    {
+        return;
+    }
+    lastReceived_.store(now.time_since_epoch().count());
+
+    // A full queue drops the packet, as a full socket buffer would; the
+    // sequence count shows it as lost.
+    const auto tail = receiveTail_.load(std::memory_order_relaxed);
+    if (tail - receiveHead_.load(std::memory_order_acquire) == kReceiveSlots)
+    {
+        return;
+    }
+    auto &packet = received_[tail % kReceiveSlots];
+    packet.at = now;
+    packet.encapsulationSequence = encapsulationSequence;
+    packet.sequence = get16(data);
+    packet.data.assign(data + header, data + size);
+    receiveTail_.store(tail + 1);
+    if (!signalled_.exchange(true))
+    {
+        notify(inputFd_);
+    }
+}
+
+std::shared_ptr<Class1Transport> Class1Transport::instance()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<Class1Transport> current;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto transport = current.lock();
+    if (!transport)
+    {
+        transport = std::make_shared<Class1Transport>();
+        current = transport;
+    }
+    return transport;
+}
+
+Class1Transport::Class1Transport(uint16_t port)
+{
+    fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    socklen_t length = sizeof(address);
+    if (fd_ < 0 || wakeFd_ < 0 || ::bind(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::getsockname(fd_, reinterpret_cast<sockaddr *>(&address), &length) != 0)
+    {
+        const int code = errno;
+        for (int fd : {fd_, wakeFd_})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+        throw std::system_error(code, std::generic_category(), "Cannot bind UDP port " + std::to_string(port));
+    }
+    port_ = ntohs(address.sin_port);
+
+    // Many connections can land in the same wakeup; the kernel caps this at rmem_max.
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &kReceiveBufferBytes, sizeof(kReceiveBufferBytes));
+
+    worker_ = std::thread([this]() { loop(); });
+}
+
+Class1Transport::~Class1Transport()
+{
+    running_ = false;
+    notify(wakeFd_);
+    worker_.join();
+    ::close(wakeFd_);
+    ::close(fd_);
+}
+
+void Class1Transport::configure(const IoRuntimeConfig &io)
+{
+    // Failures are not reported here: the I/O threads ask for the same and report theirs.
+    std::call_once(configured_, [this, &io]() {
+        if (!io.cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : io.cpus)
+            {
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            ::pthread_setaffinity_np(worker_.native_handle(), sizeof(set), &set);
+        }
+        if (io.realtime.enabled)
+        {
+            sched_param param{};
+            param.sched_priority = io.realtime.priority;
+            ::pthread_setschedparam(worker_.native_handle(), SCHED_FIFO, &param);
+        }
+    });
+}
+
+size_t Class1Transport::connections() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connections_.size();
+}
+
+std::shared_ptr<Class1Connection> Class1Transport::forwardOpen(
+    const eipScanner::SessionInfoIf::SPtr &session, eipScanner::cip::connectionManager::ConnectionParameters params,
+    bool large, std::string &error)
+{
+    using eipScanner::cip::connectionManager::NetworkConnectionParametersBuilder;
+
+    NetworkConnectionParametersBuilder o2t(params.o2tNetworkConnectionParams, large);
+    NetworkConnectionParametersBuilder t2o(params.t2oNetworkConnectionParams, large);
+    const size_t o2tData = o2t.getConnectionSize();
+    const size_t t2oData = t2o.getConnectionSize();
+    const size_t o2tLimit = maxClass1AssemblyBytes(large, params.o2tRealTimeFormat);
+    const size_t t2oLimit = maxClass1AssemblyBytes(large, params.t2oRealTimeFormat);
+    if (o2tData > o2tLimit || t2oData > t2oLimit)
+    {
+        error = "Assembly exceeds " + std::to_string(o2tData > o2tLimit ? o2tLimit : t2oLimit) + " bytes" +
+                (large ? "" : "; use a Large ForwardOpen");
+        return nullptr;
+    }
+    const size_t o2tSize = o2tData + class1HeaderBytes(params.o2tRealTimeFormat);
+    const size_t t2oSize = t2oData + class1HeaderBytes(params.t2oRealTimeFormat);
+    params.o2tNetworkConnectionParams = o2t.setConnectionSize(static_cast<uint16_t>(o2tSize)).build();
+    params.t2oNetworkConnectionParams = t2o.setConnectionSize(static_cast<uint16_t>(t2oSize)).build();
+
+    // Made first: it can throw, and nothing may fail once the target has opened the connection.
+    auto connection = std::make_shared<Class1Connection>();
+    const auto request = large ? eipScanner::cip::connectionManager::LargeForwardOpenRequest(params).pack()
+                               : eipScanner::cip::connectionManager::ForwardOpenRequest(params).pack();
+    const eipScanner::MessageRouter router;
+    const auto response = router.sendRequest(session, large ? kLargeForwardOpen : kForwardOpen,
+                                             eipScanner::cip::EPath(kConnectionManagerClass, 1), request);
+    if (response.getGeneralStatusCode() != eipScanner::cip::GeneralStatusCodes::SUCCESS)
+    {
+        error = describeFailure(large ? "Large ForwardOpen" : "ForwardOpen", response);
+        return nullptr;
+    }
+    eipScanner::cip::connectionManager::ForwardOpenResponse reply;
+    reply.expand(response.getData());
+
+    connection->fd_ = fd_;
+    connection->receiving_ = &receiving_;
+    connection->o2tId_ = reply.getO2TNetworkConnectionId();
+    connection->t2oId_ = reply.getT2ONetworkConnectionId();
+    connection->serial_ = params.connectionSerialNumber;
+    connection->vendor_ = params.originatorVendorId;
+    connection->originatorSerial_ = params.originatorSerialNumber;
+    connection->path_ = params.connectionPath;
+    connection->t2oRunIdle_ = params.t2oRealTimeFormat != 0;
+    for (auto &packet : connection->received_)
+    {
+        packet.data.reserve(t2oData);
+    }
+    // Timeout = T->O RPI x 4 << multiplier, with the RPI the target granted.
+    const uint64_t t2oApi = reply.getT2OApi() != 0 ? reply.getT2OApi() : params.t2oRPI;
+    connection->timeout_ = std::chrono::microseconds(t2oApi * (4u << (params.connectionTimeoutMultiplier & 0x07)));
+
+    // O->T goes to the target's implicit port unless the reply names another address.
+    connection->target_ = session->getRemoteEndPoint().getAddr();
+    connection->target_.sin_port = htons(kImplicitPort);
+    connection->source_ = connection->target_.sin_addr.s_addr;
+    for (const auto &item : response.getAdditionalPacketItems())
+    {
+        in_port_t itemPort = 0;
+        in_addr_t itemAddress = 0;
+        const auto type = static_cast<uint16_t>(item.getTypeId());
+        if (!readSocketAddress(item.getData(), itemPort, itemAddress))
+        {
+            continue;
+        }
+        if (type == kO2TSocketAddressItem)
+        {
+            connection->target_.sin_port = itemPort;
+            if (itemAddress != htonl(INADDR_ANY))
+            {
+                connection->target_.sin_addr.s_addr = itemAddress;
+            }
+        }
+        else if (type == kT2OSocketAddressItem && IN_MULTICAST(ntohl(itemAddress)))
+        {
+            connection->group_ = itemAddress;
+        }
+    }
+
+    const size_t runIdle = params.o2tRealTimeFormat ? kRunIdleHeaderBytes : 0;
+    connection->dataOffset_ = kHeaderSize + runIdle;
+    connection->packet_.assign(connection->dataOffset_ + o2tData, 0);
+    connection->output_.assign(o2tData, 0);
+    auto *packet = connection->packet_.data();
+    put16(packet, 2);
+    put16(packet + 2, kSequencedAddressItem);
+    put16(packet + 4, 8);
+    put32(packet + 6, connection->o2tId_);
+    put16(packet + 14, kConnectedDataItem);
+    put16(packet + kDataLengthOffset, static_cast<uint16_t>(o2tSize));
+    if (runIdle > 0)
+    {
+        put32(packet + kHeaderSize, kRun);
+    }
+    return connection;
+}
+
+bool Class1Transport::forwardClose(const eipScanner::SessionInfoIf::SPtr &session,
+                                   const std::shared_ptr<Class1Connection> &connection, std::string &error)
+{
+    stop(*connection);
+    connection->open_.store(false, std::memory_order_release);
+
+    eipScanner::cip::connectionManager::ForwardCloseRequest request;
+    request.setConnectionSerialNumber(connection->serial_);
+    request.setOriginatorVendorId(connection->vendor_);
+    request.setOriginatorSerialNumber(connection->originatorSerial_);
+    request.setConnectionPath(connection->path_);
+    const eipScanner::MessageRouter router;
+    const auto response =
+        router.sendRequest(session, kForwardClose, eipScanner::cip::EPath(kConnectionManagerClass, 1), request.pack());
+    if (response.getGeneralStatusCode() != eipScanner::cip::GeneralStatusCodes::SUCCESS)
+    {
+        error = describeFailure("ForwardClose", response);
+        return false;
+    }
+    return true;
+}
+
+void Class1Transport::start(const std::shared_ptr<Class1Connection> &connection)
+{
+    connection->lastReceived_.store(Class1Connection::Clock::now().time_since_epoch().count(),
+                                    std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_[keyOf(connection->source_, connection->t2oId_)] = connection;
+    if (connection->group_ != 0 && groups_[connection->group_]++ == 0)
+    {
+        ip_mreq membership{};
+        membership.imr_multiaddr.s_addr = connection->group_;
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        ::setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership));
+    }
+}
+
+void Class1Transport::stop(const Class1Connection &connection)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = connections_.find(keyOf(connection.source_, connection.t2oId_));
+    if (it == connections_.end() || it->second.get() != &connection)
+    {
+        return;
+    }
+    connections_.erase(it);
+    if (connection.group_ != 0 && --groups_[connection.group_] == 0)
+    {
+        groups_.erase(connection.group_);
+        ip_mreq membership{};
+        membership.imr_multiaddr.s_addr = connection.group_;
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        ::setsockopt(fd_, IPPROTO_IP, IP_DROP_MEMBERSHIP, &membership, sizeof(membership));
+    }
+}
+
+void Class1Transport::loop()
+{
+    std::vector<uint8_t> datagram(kMaxDatagram);
+    pollfd fds[2] = {{fd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+    while (running_)
+    {
+        if (::poll(fds, 2, -1) < 0 && errno != EINTR)
+        {
+            break;
+        }
+        receiving_ = true;
+        sockaddr_in from{};
+        socklen_t length = sizeof(from);
+        ssize_t received;
+        while ((received = ::recvfrom(fd_, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr *>(&from),
+                                      &length)) >= 0)
+        {
+            dispatch(from, datagram.data(), static_cast<size_t>(received));
+            length = sizeof(from);
+        }
+        receiving_ = false;
+    }
+}
+
+void Class1Transport::dispatch(const sockaddr_in &from, const uint8_t *datagram, size_t size)
+{
+    uint32_t connectionId = 0;
+    uint32_t encapsulationSequence = 0;
+    bool addressed = false;
+    const uint8_t *data = nullptr;
+    size_t dataSize = 0;
+    size_t offset = 2;
+    const uint16_t count = size >= 2 ? get16(datagram) : 0;
+    for (uint16_t i = 0; i < count && offset + 4 <= size; ++i)
+    {
+        const uint16_t type = get16(datagram + offset);
+        const uint16_t length = get16(datagram + offset + 2);
+        offset += 4;
+        if (offset + length > size)
+        {
+            break;
+        }
+        if (type == kSequencedAddressItem && length >= 8)
+        {
+            connectionId = get32(datagram + offset);
+            encapsulationSequence = get32(datagram + offset + 4);
+            addressed = true;
+        }
+        else if (type == kConnectedDataItem)
+        {
+            data = datagram + offset;
+            dataSize = length;
+        }
+        offset += length;
+    }
+
+    if (addressed && data)
+    {
+        // Queued under the lock so nothing is queued for a connection once stop() returns.
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = connections_.find(keyOf(from.sin_addr.s_addr, connectionId));
+        if (it != connections_.end())
+        {
+            it->second->deliver(encapsulationSequence, data, dataSize, Class1Connection::Clock::now());
+            return;
+        }
+    }
+    unmatched_.fetch_add(1, std::memory_order_relaxed);
+}
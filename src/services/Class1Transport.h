@@ -0,0 +1,177 @@
+#pragma once
+
+#include "models/ConnectionConfig.h"
+#include "models/IoRuntimeConfig.h"
+
+#include <EIPScanner/SessionInfoIf.h>
+#include <EIPScanner/cip/connectionManager/ConnectionParameters.h>
+#include <netinet/in.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// One open Class 1 connection. The O->T datagram is laid out once at
+// ForwardOpen and rewritten in place for every send.
+class Class1Connection
+{
+public:
+    Class1Connection();
+    ~Class1Connection();
+
+    Class1Connection(const Class1Connection &) = delete;
+    Class1Connection &operator=(const Class1Connection &) = delete;
+
+    using Clock = std::chrono::steady_clock;
+    // `received` is when the packet arrived; `encapsulationSequence` and
+    // `sequence` are its encapsulation sequence number and CIP sequence count.
+    using ReceiveListener = std::function<void(Clock::time_point received, uint32_t encapsulationSequence,
+                                               uint16_t sequence, const std::vector<uint8_t> &data)>;
+    using SendListener = std::function<void(uint16_t sequence, std::vector<uint8_t> &data)>;
+    using CloseListener = std::function<void()>;
+
+    // Listeners are set before Class1Transport::start and not changed after.
+    void setReceiveDataListener(ReceiveListener listener) { receive_ = std::move(listener); }
+    void setSendDataListener(SendListener listener) { send_ = std::move(listener); }
+    void setCloseListener(CloseListener listener) { close_ = std::move(listener); }
+
+    // Sends one O->T packet; meant to be called once per RPI by the I/O thread
+    // that owns the connection. Once no T->O packet has arrived for the
+    // connection timeout, closes the connection instead and never sends again.
+    void send();
+    // Hands the queued T->O packets to the receive listener; meant to be
+    // called by the same I/O thread whenever inputFd() is readable.
+    void receive();
+    int inputFd() const { return inputFd_; }
+    bool isOpen() const { return open_.load(std::memory_order_acquire); }
+
+    uint32_t o2tConnectionId() const { return o2tId_; }
+    uint32_t t2oConnectionId() const { return t2oId_; }
+    std::chrono::microseconds timeout() const { return timeout_; }
+
+private:
+    friend class Class1Transport;
+
+    int fd_{-1};
+    sockaddr_in target_{};
+    in_addr_t source_{0};
+    // Multicast group the target produces T->O to, or 0 for unicast.
+    in_addr_t group_{0};
+    uint32_t o2tId_{0};
+    uint32_t t2oId_{0};
+    uint16_t serial_{0};
+    uint16_t vendor_{0};
+    uint32_t originatorSerial_{0};
+    std::vector<uint8_t> path_;
+    std::chrono::microseconds timeout_{0};
+    bool t2oRunIdle_{false};
+
+    // Send side, touched only by the owning I/O thread.
+    std::vector<uint8_t> packet_;
+    std::vector<uint8_t> output_;
+    size_t dataOffset_{0};
+    uint32_t encapsulationSequence_{0};
+    uint16_t cipSequence_{0};
+
+    // Receive side. The transport's receive thread queues packets and
+    // signals inputFd_; the owning I/O thread takes them off in receive().
+    struct Received
+    {
+        Clock::time_point at;
+        uint32_t encapsulationSequence{0};
+        uint16_t sequence{0};
+        std::vector<uint8_t> data;
+    };
+    static constexpr size_t kReceiveSlots = 8;
+    std::array<Received, kReceiveSlots> received_;
+    std::atomic<size_t> receiveHead_{0};
+    std::atomic<size_t> receiveTail_{0};
+    std::atomic<bool> signalled_{false};
+    int inputFd_{-1};
+
+    std::atomic<bool> open_{true};
+    std::atomic<Clock::rep> lastReceived_{0};
+    // The transport's flag for a receive pass in progress.
+    const std::atomic<bool> *receiving_{nullptr};
+    ReceiveListener receive_;
+    SendListener send_;
+    CloseListener close_;
+
+    void deliver(uint32_t encapsulationSequence, const uint8_t *data, size_t size, Clock::time_point now);
+    bool timedOut(Clock::time_point now) const;
+    bool receivePending() const;
+};
+
+// Class 1 I/O for every connection in the process over one UDP socket bound
+// to the implicit messaging port. ForwardOpen and ForwardClose go over a
+// registered session; T->O datagrams are read on one thread and queued for
+// their connection by source address and T->O connection id, so any number
+// of connections, to one target or many, share the port. EIPScanner's
+// ConnectionManager binds the port once per manager, which leaves every
+// manager but one without input.
+class Class1Transport
+{
+public:
+    static constexpr uint16_t kImplicitPort = 2222;
+
+    // The process-wide transport on kImplicitPort, created on first use and
+    // closed once nothing holds it. Throws std::system_error if the port is taken.
+    static std::shared_ptr<Class1Transport> instance();
+
+    explicit Class1Transport(uint16_t port = kImplicitPort);
+    ~Class1Transport();
+
+    Class1Transport(const Class1Transport &) = delete;
+    Class1Transport &operator=(const Class1Transport &) = delete;
+
+    // Null with `error` set when the target refuses. Connection sizes are the
+    // assembly sizes; the sequence count and run/idle headers are added here.
+    // EIPScanner exceptions from the session propagate.
+    std::shared_ptr<Class1Connection> forwardOpen(const eipScanner::SessionInfoIf::SPtr &session,
+                                                  eipScanner::cip::connectionManager::ConnectionParameters params,
+                                                  bool large, std::string &error);
+    // Stops queueing the connection's input first.
+    bool forwardClose(const eipScanner::SessionInfoIf::SPtr &session, const std::shared_ptr<Class1Connection> &connection,
+                      std::string &error);
+
+    // Starts and stops queueing T->O packets for the connection's receive().
+    // Once stop returns nothing more is queued.
+    void start(const std::shared_ptr<Class1Connection> &connection);
+    void stop(const Class1Connection &connection);
+
+    // Moves the receive thread onto the I/O threads' CPUs and real-time
+    // priority. Only the first call has an effect.
+    void configure(const IoRuntimeConfig &io);
+
+    uint16_t port() const { return port_; }
+    // Connections currently started.
+    size_t connections() const;
+    // Datagrams that matched no open connection.
+    uint64_t unmatched() const { return unmatched_.load(std::memory_order_relaxed); }
+
+private:
+    int fd_{-1};
+    int wakeFd_{-1};
+    uint16_t port_{0};
+    std::atomic<bool> running_{true};
+    std::atomic<bool> receiving_{false};
+    std::atomic<uint64_t> unmatched_{0};
+    std::once_flag configured_;
+    mutable std::mutex mutex_;
+    // Keyed by source address and T->O connection id.
+    std::unordered_map<uint64_t, std::shared_ptr<Class1Connection>> connections_;
+    // Joined multicast groups and how many connections use each.
+    std::unordered_map<in_addr_t, size_t> groups_;
+    std::thread worker_;
+
+    void loop();
+    void dispatch(const sockaddr_in &from, const uint8_t *datagram, size_t size);
+};
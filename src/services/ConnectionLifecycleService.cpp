@@ -1,9 +1,9 @@
 #include "ConnectionLifecycleService.h"
 #include "IOSignalService.h"
 
-#include <EIPScanner/MessageRouter.h>
 #include <EIPScanner/cip/EPath.h>
 #include <EIPScanner/cip/connectionManager/NetworkConnectionParametersBuilder.h>
+#include <algorithm>
 #include <random>
 #include <limits>
 
@@ -11,7 +11,8 @@ namespace
 {
 uint16_t generateSerial()
 {
-    static std::mt19937 rng(std::random_device{}());
+    // Opens run on several control threads at once.
+    thread_local std::mt19937 rng(std::random_device{}());
     std::uniform_int_distribution<uint16_t> dist(1, std::numeric_limits<uint16_t>::max());
     return dist(rng);
 }
@@ -37,21 +38,48 @@ std::vector<uint8_t> buildConnectionPath(const ConnectionConfig &config)
 }
 } // namespace
 
-ConnectionLifecycleService::ConnectionLifecycleService()
+struct ConnectionLifecycleService::Bulk
 {
-    worker_ = std::thread([this]() { loop(); });
-}
+    Bulk(std::vector<std::string> names, size_t parallelism, BulkCompletion done)
+        : names(std::move(names)), parallelism(parallelism), done(std::move(done)), results(this->names.size())
+    {
+    }
 
-ConnectionLifecycleService::~ConnectionLifecycleService()
-{
-    running_ = false;
-    if (worker_.joinable())
+    const std::vector<std::string> names;
+    const size_t parallelism;
+    const BulkCompletion done;
+    std::function<bool(size_t index, std::string &error, Completion done)> start;
+
+    std::mutex mutex;
+    size_t next{0};
+    size_t inFlight{0};
+    size_t finished{0};
+    std::vector<ConnectionStatus> results;
+
+    void finish(size_t index, const ConnectionStatus &status)
     {
-        worker_.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results[index] = status;
+            inFlight--;
+            if (++finished < names.size())
+            {
+                return;
+            }
+        }
+        done(results);
     }
+};
+
+ConnectionLifecycleService::ConnectionLifecycleService(const IoRuntimeConfig &io, std::shared_ptr<SessionPool> sessions,
+                                                       std::shared_ptr<TrafficRecorder> recorder)
+    : sessions_(std::move(sessions)), recorder_(std::move(recorder)), io_(io), reactors_(io), control_(io.controlThreads)
+{
 }
 
-bool ConnectionLifecycleService::open(const Device &device, std::string &error)
+ConnectionLifecycleService::~ConnectionLifecycleService() = default;
+
+bool ConnectionLifecycleService::open(const Device &device, std::string &error, Completion done)
 {
     if (!device.connection.has_value())
     {
@@ -59,29 +87,198 @@ bool ConnectionLifecycleService::open(const Device &device, std::string &error)
         return false;
     }
 
-    IOSignalServiceProvider::instance()->applyMappings(device.name, device.signals);
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto &entry = connections_[device.name];
-    entry.device = device;
-    entry.status.deviceName = device.name;
+    ConnectionStatus current;
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &entry = connections_[device.name];
+        entry.status.deviceName = device.name;
+        current = statusOf(entry);
+        if (!current.connected && !current.opening)
+        {
+            // A live connection keeps the device and mappings it was opened with.
+            entry.device = device;
+            updateStatus(entry, [](ConnectionStatus &status) {
+                status.opening = true;
+                status.closing = false;
+                status.lastError.clear();
+            });
+            queued = true;
+        }
+    }
 
-    if (entry.status.connected || entry.status.opening)
+    if (!queued)
     {
+        if (done)
+        {
+            done(current);
+        }
         return true;
     }
 
-    entry.status.opening = true;
-    entry.status.lastError.clear();
+    auto signalService = IOSignalServiceProvider::instance();
+    signalService->applyMappings(device.name, device.signals);
+    auto signals = signalService->attach(device.name);
+    signalService->configureAssemblies(signals, *device.connection);
+
+    control_.post(device.name, [this, device, signals, done = std::move(done)]() {
+        const auto status = openNow(device, signals);
+        if (done)
+        {
+            done(status);
+        }
+    });
+    return true;
+}
+
+bool ConnectionLifecycleService::close(const std::string &deviceName, std::string &error, Completion done)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(deviceName);
+        if (it == connections_.end())
+        {
+            error = "No such connection";
+            return false;
+        }
+        if (it->second.status.connected)
+        {
+            it->second.status.closing = true;
+        }
+    }
+
+    control_.post(deviceName, [this, deviceName, done = std::move(done)]() {
+        const auto status = closeNow(deviceName);
+        if (done)
+        {
+            done(status);
+        }
+    });
+    return true;
+}
+
+void ConnectionLifecycleService::openAll(const std::vector<Device> &devices, size_t parallelism, BulkCompletion done)
+{
+    std::vector<std::string> names;
+    names.reserve(devices.size());
+    for (const auto &device : devices)
+    {
+        names.push_back(device.name);
+    }
+    auto bulk = std::make_shared<Bulk>(std::move(names), parallelism, std::move(done));
+    bulk->start = [this, devices](size_t index, std::string &error, Completion completion) {
+        return open(devices[index], error, std::move(completion));
+    };
+    runBulk(bulk);
+}
+
+void ConnectionLifecycleService::closeAll(const std::vector<std::string> &deviceNames, size_t parallelism,
+                                          BulkCompletion done)
+{
+    auto bulk = std::make_shared<Bulk>(deviceNames, parallelism, std::move(done));
+    bulk->start = [this, deviceNames](size_t index, std::string &error, Completion completion) {
+        return close(deviceNames[index], error, std::move(completion));
+    };
+    runBulk(bulk);
+}
+
+bool ConnectionLifecycleService::forget(const std::string &deviceName, std::string &error)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(deviceName);
+        if (it == connections_.end())
+        {
+            error = "No such connection";
+            return false;
+        }
+        const auto &entry = it->second;
+        if (entry.connection || entry.status.opening || entry.status.closing)
+        {
+            error = "Connection is still open";
+            return false;
+        }
+        connections_.erase(it);
+    }
+    reactors_.forget(deviceName);
+    IOSignalServiceProvider::instance()->forget(deviceName);
+    return true;
+}
+
+void ConnectionLifecycleService::runBulk(const std::shared_ptr<Bulk> &bulk)
+{
+    if (bulk->names.empty())
+    {
+        bulk->done({});
+        return;
+    }
+
+    // Each completion refills the window, so a slow device only holds up its own slot.
+    while (true)
+    {
+        size_t index = 0;
+        {
+            std::lock_guard<std::mutex> lock(bulk->mutex);
+            if (bulk->next == bulk->names.size() ||
+                (bulk->parallelism > 0 && bulk->inFlight >= bulk->parallelism))
+            {
+                return;
+            }
+            index = bulk->next++;
+            bulk->inFlight++;
+        }
+
+        std::string error;
+        const bool queued = bulk->start(index, error, [this, bulk, index](const ConnectionStatus &status) {
+            bulk->finish(index, status);
+            runBulk(bulk);
+        });
+        if (!queued)
+        {
+            ConnectionStatus status;
+            status.deviceName = bulk->names[index];
+            status.lastError = error;
+            status.lastUpdate = std::chrono::system_clock::now();
+            bulk->finish(index, status);
+        }
+    }
+}
+
+ConnectionStatus ConnectionLifecycleService::openNow(const Device &device, const IOSignalService::DeviceRef &signals)
+{
+    const auto config = *device.connection;
+    std::shared_ptr<Class1Transport> transport;
+    std::shared_ptr<Class1Connection> connection;
+    std::shared_ptr<ConnectionRuntime> runtime;
+    std::string failure;
+
+    // A connection the target closed is still started and polled; retire it
+    // before its replacement is installed.
+    std::shared_ptr<Class1Transport> previousTransport;
+    std::shared_ptr<Class1Connection> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &entry = connections_[device.name];
+        previousTransport = std::move(entry.transport);
+        previous = std::move(entry.connection);
+    }
+    if (previous)
+    {
+        reactors_.detach(device.name);
+        previousTransport->stop(*previous);
+    }
 
+    // Session setup and ForwardOpen block for up to timeoutMs; no lock is held.
+    // The I/O itself runs over UDP, so the session goes back to the pool once
+    // ForwardOpen is answered.
+    std::optional<SessionPool::Lease> lease;
     try
     {
-        auto timeout = std::chrono::milliseconds(device.timeoutMs);
-        entry.session = std::make_shared<eipScanner::SessionInfo>(device.ipAddress, device.port, timeout);
-        entry.manager = std::make_shared<eipScanner::ConnectionManager>(std::make_shared<eipScanner::MessageRouter>());
+        lease.emplace(sessions_->acquire(device.ipAddress, device.port, std::chrono::milliseconds(device.timeoutMs)));
+        transport = Class1Transport::instance();
+        transport->configure(io_);
 
         eipScanner::cip::connectionManager::ConnectionParameters params;
-        auto config = *device.connection;
 
         eipScanner::cip::connectionManager::NetworkConnectionParametersBuilder o2tBuilder(0, config.useLargeForwardOpen);
         o2tBuilder.setConnectionType(config.multicast
@@ -99,102 +296,141 @@ bool ConnectionLifecycleService::open(const Device &device, std::string &error)
 
         params.priorityTimeTick = 0x07;
         params.timeoutTicks = 0x05;
-        params.connectionSerialNumber = generateSerial();
+        params.connectionSerialNumber = config.connectionSerial ? *config.connectionSerial : generateSerial();
         params.originatorVendorId = 0x0456;
-        params.originatorSerialNumber = 0x00010001;
+        params.originatorSerialNumber = config.originatorSerial.value_or(0x00010001);
         params.o2tRPI = config.rpiUs;
         params.t2oRPI = config.rpiUs;
+        params.connectionTimeoutMultiplier = config.timeoutMultiplier;
         params.o2tNetworkConnectionParams = o2tBuilder.build();
         params.t2oNetworkConnectionParams = t2oBuilder.build();
         params.transportTypeTrigger = 0xA3; // client, cyclic
         params.connectionPath = buildConnectionPath(config);
         params.connectionPathSize = static_cast<eipScanner::cip::CipUsint>(params.connectionPath.size() / 2);
 
-        auto conn = entry.manager->forwardOpen(entry.session, params, config.useLargeForwardOpen);
-        if (conn.expired())
+        connection = transport->forwardOpen(lease->session(), params, config.useLargeForwardOpen, failure);
+        if (connection)
         {
-            markError(entry, "ForwardOpen failed");
-            error = entry.status.lastError;
-            return false;
+            runtime = std::make_shared<ConnectionRuntime>(config.rpiUs);
+            const auto recorder = recorder_;
+            const auto stream = recorder ? recorder->openStream(device.name, device.ipAddress,
+                                                                connection->o2tConnectionId(),
+                                                                connection->t2oConnectionId())
+                                         : 0;
+            connection->setReceiveDataListener(
+                [runtime, signals, recorder, stream](ConnectionRuntime::Clock::time_point received,
+                                                     uint32_t encapsulationSequence, uint16_t sequence,
+                                                     const std::vector<uint8_t> &data) {
+                    runtime->received(received, encapsulationSequence, sequence);
+                    if (recorder)
+                    {
+                        recorder->record(stream, TrafficRecorder::Direction::Input, sequence, data);
+                    }
+                    IOSignalServiceProvider::instance()->consumeInputBytes(signals, data);
+                });
+            // The transport sizes the buffer to the output assembly once; fillOutputBytes writes into it in place.
+            connection->setSendDataListener(
+                [runtime, signals, recorder, stream](uint16_t sequence, std::vector<uint8_t> &buffer) {
+                    runtime->sent(ConnectionRuntime::Clock::now());
+                    IOSignalServiceProvider::instance()->fillOutputBytes(signals, buffer);
+                    if (recorder)
+                    {
+                        recorder->record(stream, TrafficRecorder::Direction::Output, sequence, buffer);
+                    }
+                });
+            connection->setCloseListener([runtime]() { runtime->closedByTarget(); });
+            transport->start(connection);
         }
-
-        auto sharedConn = conn.lock();
-        entry.connection = sharedConn;
-        sharedConn->setReceiveDataListener([this, name = device.name](auto, auto, const std::vector<uint8_t> &data) {
-            std::lock_guard<std::mutex> guard(mutex_);
-            auto it = connections_.find(name);
-            if (it == connections_.end())
-            {
-                return;
-            }
-            updateStatus(it->second, [&, received = data.size()](ConnectionStatus &status) {
-                status.packetsReceived++;
-                status.lastSequence += received > 0 ? 1 : 0;
-            });
-            IOSignalServiceProvider::instance()->consumeInputBytes(name, data);
-        });
-
-        sharedConn->setSendDataListener([this, name = device.name](std::vector<uint8_t> &buffer) {
-            std::lock_guard<std::mutex> guard(mutex_);
-            auto it = connections_.find(name);
-            if (it == connections_.end())
-            {
-                return;
-            }
-            updateStatus(it->second, [](ConnectionStatus &status) { status.packetsSent++; });
-            buffer.resize(it->second.device.connection->outputAssembly.sizeBytes, 0);
-            IOSignalServiceProvider::instance()->fillOutputBytes(name, buffer);
-        });
-
-        sharedConn->setCloseListener([this, name = device.name]() {
-            std::lock_guard<std::mutex> guard(mutex_);
-            auto it = connections_.find(name);
-            if (it == connections_.end())
-            {
-                return;
-            }
-            it->second.status.connected = false;
-            it->second.status.opening = false;
-            it->second.status.lastError = "Connection closed by target";
-        });
-
-        updateStatus(entry, [](ConnectionStatus &status) {
-            status.connected = true;
-            status.opening = false;
-            status.lastError.clear();
-        });
-        return true;
     }
     catch (const std::exception &ex)
     {
-        markError(entry, ex.what());
-        error = entry.status.lastError;
-        return false;
+        if (lease)
+        {
+            lease->invalidate();
+        }
+        failure = ex.what();
+    }
+    lease.reset();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = connections_[device.name];
+    if (!failure.empty())
+    {
+        markError(entry, failure);
+        return statusOf(entry);
     }
+
+    entry.transport = transport;
+    entry.connection = connection;
+    entry.runtime = runtime;
+    // One O->T packet per slot, and T->O input decoded as it is queued, both on
+    // the connection's own thread. The transport keeps its socket open while the poll holds it.
+    const auto thread = reactors_.attach(
+        device.name, [transport, connection]() { connection->send(); }, std::chrono::microseconds(config.rpiUs),
+        connection->inputFd(), [connection]() { connection->receive(); });
+    updateStatus(entry, [thread](ConnectionStatus &status) {
+        status.connected = true;
+        status.opening = false;
+        status.lastError.clear();
+        status.ioThread = static_cast<int>(thread);
+    });
+    return statusOf(entry);
 }
 
-bool ConnectionLifecycleService::close(const std::string &deviceName, std::string &error)
+ConnectionStatus ConnectionLifecycleService::closeNow(const std::string &deviceName)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = connections_.find(deviceName);
-    if (it == connections_.end())
+    Device device;
+    std::shared_ptr<Class1Transport> transport;
+    std::shared_ptr<Class1Connection> connection;
     {
-        error = "No such connection";
-        return false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &entry = connections_[deviceName];
+        device = entry.device;
+        transport = entry.transport;
+        connection = entry.connection;
     }
 
-    auto &entry = it->second;
-    if (entry.manager && !entry.connection.expired())
+    // Stop sending before ForwardClose.
+    reactors_.detach(deviceName);
+
+    std::string failure;
+    if (connection && !connection->isOpen())
+    {
+        // The target already dropped it; only the local state goes.
+        transport->stop(*connection);
+    }
+    else if (connection)
     {
-        entry.manager->forwardClose(entry.session, entry.connection);
+        // Any registered session to the target can carry ForwardClose, not only the one that opened it.
+        std::optional<SessionPool::Lease> lease;
+        try
+        {
+            lease.emplace(sessions_->acquire(device.ipAddress, device.port, std::chrono::milliseconds(device.timeoutMs)));
+            transport->forwardClose(lease->session(), connection, failure);
+        }
+        catch (const std::exception &ex)
+        {
+            if (lease)
+            {
+                lease->invalidate();
+            }
+            transport->stop(*connection);
+            failure = ex.what();
+        }
     }
 
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = connections_[deviceName];
     entry.connection.reset();
-    updateStatus(entry, [](ConnectionStatus &status) {
+    entry.transport.reset();
+    updateStatus(entry, [&failure](ConnectionStatus &status) {
         status.connected = false;
         status.opening = false;
+        status.closing = false;
+        status.ioThread = -1;
+        status.lastError = failure;
     });
-    return true;
+    return statusOf(entry);
 }
 
 std::optional<ConnectionStatus> ConnectionLifecycleService::status(const std::string &deviceName)
@@ -205,7 +441,7 @@ std::optional<ConnectionStatus> ConnectionLifecycleService::status(const std::st
     {
         return std::nullopt;
     }
-    return it->second.status;
+    return statusOf(it->second);
 }
 
 std::vector<ConnectionStatus> ConnectionLifecycleService::listStatuses()
@@ -215,44 +451,65 @@ std::vector<ConnectionStatus> ConnectionLifecycleService::listStatuses()
     items.reserve(connections_.size());
     for (const auto &pair : connections_)
     {
-        items.push_back(pair.second.status);
+        items.push_back(statusOf(pair.second));
     }
     return items;
 }
 
-void ConnectionLifecycleService::loop()
+std::vector<IoThreadStatus> ConnectionLifecycleService::ioThreads() const
 {
-    while (running_)
+    return reactors_.threads();
+}
+
+std::shared_ptr<const ConnectionTiming> ConnectionLifecycleService::timing(const std::string &deviceName)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections_.find(deviceName);
+    if (it == connections_.end())
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        std::vector<std::shared_ptr<eipScanner::ConnectionManager>> managers;
+        return nullptr;
+    }
+    return ConnectionRuntime::timing(it->second.runtime);
+}
 
-        {
-            std::lock_guard<std::mutex> guard(mutex_);
-            managers.reserve(connections_.size());
-            for (auto &pair : connections_)
-            {
-                managers.push_back(pair.second.manager);
-                updateStatus(pair.second, [](ConnectionStatus &status) {
-                    status.lastUpdate = std::chrono::system_clock::now();
-                });
-            }
-        }
+ConnectionStatus ConnectionLifecycleService::statusOf(const ConnectionEntry &entry)
+{
+    auto status = entry.status;
+    if (!entry.runtime)
+    {
+        return status;
+    }
 
-        for (auto &manager : managers)
-        {
-            if (manager)
-            {
-                manager->handleConnections(std::chrono::milliseconds(1));
-            }
-        }
+    const auto &runtime = *entry.runtime;
+    status.packetsSent = runtime.packetsSent();
+    status.packetsReceived = runtime.packetsReceived();
+    const auto &sequence = runtime.sequence();
+    status.lastSequence = sequence.lastSequence();
+    status.packetsLost = sequence.lost();
+    status.packetsDuplicated = sequence.duplicates();
+    status.packetsStale = sequence.stale();
+    const auto &encapsulation = runtime.encapsulationSequence();
+    status.lastEncapsulationSequence = encapsulation.lastSequence();
+    status.encapsulationLost = encapsulation.lost();
+    status.encapsulationDuplicated = encapsulation.duplicates();
+    status.encapsulationStale = encapsulation.stale();
+    if (const auto lastActivity = runtime.lastActivity())
+    {
+        status.lastUpdate = std::max(status.lastUpdate, *lastActivity);
+    }
+    if (status.connected && runtime.isClosedByTarget())
+    {
+        status.connected = false;
+        status.lastError = "Connection closed by target";
     }
+    return status;
 }
 
 void ConnectionLifecycleService::markError(ConnectionEntry &entry, const std::string &message)
 {
     entry.status.connected = false;
     entry.status.opening = false;
+    entry.status.closing = false;
     entry.status.lastError = message;
     entry.status.lastUpdate = std::chrono::system_clock::now();
 }
@@ -1,25 +1,41 @@
 #pragma once
 
+#include "Class1Transport.h"
+#include "ConnectionRuntime.h"
+#include "IOReactorPool.h"
+#include "SerialExecutor.h"
+#include "SessionPoolProvider.h"
+#include "IOSignalService.h"
+#include "TrafficRecorder.h"
 #include "models/Device.h"
 
-#include <EIPScanner/ConnectionManager.h>
-#include <EIPScanner/SessionInfo.h>
 #include <chrono>
 #include <functional>
 #include <map>
 #include <mutex>
 #include <optional>
-#include <thread>
 
 struct ConnectionStatus
 {
     std::string deviceName;
     bool connected{false};
     bool opening{false};
+    bool closing{false};
     std::string lastError;
     uint64_t packetsSent{0};
     uint64_t packetsReceived{0};
+    // CIP sequence count of the newest packet received, and how the others compared to it.
     uint64_t lastSequence{0};
+    uint64_t packetsLost{0};
+    uint64_t packetsDuplicated{0};
+    uint64_t packetsStale{0};
+    // The same for the encapsulation sequence number, which every datagram
+    // advances, so it also sees losses while the target repeats a CIP count.
+    uint64_t lastEncapsulationSequence{0};
+    uint64_t encapsulationLost{0};
+    uint64_t encapsulationDuplicated{0};
+    uint64_t encapsulationStale{0};
+    int ioThread{-1};
     std::chrono::system_clock::time_point lastUpdate;
 
     Json::Value toJson() const
@@ -28,10 +44,22 @@ struct ConnectionStatus
         value["deviceName"] = deviceName;
         value["connected"] = connected;
         value["opening"] = opening;
+        value["closing"] = closing;
         value["lastError"] = lastError;
         value["packetsSent"] = static_cast<Json::UInt64>(packetsSent);
         value["packetsReceived"] = static_cast<Json::UInt64>(packetsReceived);
         value["lastSequence"] = static_cast<Json::UInt64>(lastSequence);
+        value["packetsLost"] = static_cast<Json::UInt64>(packetsLost);
+        value["packetsDuplicated"] = static_cast<Json::UInt64>(packetsDuplicated);
+        value["packetsStale"] = static_cast<Json::UInt64>(packetsStale);
+        value["lastEncapsulationSequence"] = static_cast<Json::UInt64>(lastEncapsulationSequence);
+        value["encapsulationLost"] = static_cast<Json::UInt64>(encapsulationLost);
+        value["encapsulationDuplicated"] = static_cast<Json::UInt64>(encapsulationDuplicated);
+        value["encapsulationStale"] = static_cast<Json::UInt64>(encapsulationStale);
+        if (ioThread >= 0)
+        {
+            value["ioThread"] = ioThread;
+        }
         value["lastUpdateMs"] = static_cast<Json::UInt64>(std::chrono::duration_cast<std::chrono::milliseconds>(
                                                              lastUpdate.time_since_epoch())
                                                              .count());
@@ -42,30 +70,61 @@ struct ConnectionStatus
 class ConnectionLifecycleService
 {
 public:
-    ConnectionLifecycleService();
+    // With a recorder, every packet of every connection is passed to it.
+    explicit ConnectionLifecycleService(const IoRuntimeConfig &io = {},
+                                        std::shared_ptr<SessionPool> sessions = SessionPoolProvider::instance(),
+                                        std::shared_ptr<TrafficRecorder> recorder = nullptr);
     ~ConnectionLifecycleService();
 
-    bool open(const Device &device, std::string &error);
-    bool close(const std::string &deviceName, std::string &error);
+    using Completion = std::function<void(const ConnectionStatus &)>;
+    using BulkCompletion = std::function<void(const std::vector<ConnectionStatus> &)>;
+
+    // Both return as soon as the request is queued; the session setup,
+    // ForwardOpen and ForwardClose run on a control thread, one request at a
+    // time per device, and `done` receives the resulting status. Opening an
+    // open or opening connection completes immediately.
+    bool open(const Device &device, std::string &error, Completion done = {});
+    bool close(const std::string &deviceName, std::string &error, Completion done = {});
+    // Open or close a fleet, keeping at most `parallelism` requests (0 for no
+    // limit) outstanding; the control threads still bound how many run at
+    // once. `done` receives one status per input, in input order, after the
+    // last one completes. Rejected requests report their error in lastError.
+    void openAll(const std::vector<Device> &devices, size_t parallelism, BulkCompletion done);
+    void closeAll(const std::vector<std::string> &deviceNames, size_t parallelism, BulkCompletion done);
+    // Drops a closed connection's entry and the device's signal state, for
+    // devices that will not be opened again. Fails while it is open or busy.
+    bool forget(const std::string &deviceName, std::string &error);
     std::optional<ConnectionStatus> status(const std::string &deviceName);
     std::vector<ConnectionStatus> listStatuses();
+    std::vector<IoThreadStatus> ioThreads() const;
+    // Cycle timing since the connection was last opened; null if it never was.
+    std::shared_ptr<const ConnectionTiming> timing(const std::string &deviceName);
 
 private:
     struct ConnectionEntry
     {
         Device device;
         ConnectionStatus status;
-        std::shared_ptr<eipScanner::SessionInfo> session;
-        std::shared_ptr<eipScanner::ConnectionManager> manager;
-        eipScanner::IOConnection::WPtr connection;
+        std::shared_ptr<Class1Transport> transport;
+        std::shared_ptr<Class1Connection> connection;
+        std::shared_ptr<ConnectionRuntime> runtime;
     };
 
+    struct Bulk;
+
     std::mutex mutex_;
     std::map<std::string, ConnectionEntry> connections_;
-    bool running_{true};
-    std::thread worker_;
+    std::shared_ptr<SessionPool> sessions_;
+    std::shared_ptr<TrafficRecorder> recorder_;
+    const IoRuntimeConfig io_;
+    IOReactorPool reactors_;
+    // Declared last so queued requests stop before the state they use goes away.
+    SerialExecutor control_;
 
-    void loop();
+    ConnectionStatus openNow(const Device &device, const IOSignalService::DeviceRef &signals);
+    ConnectionStatus closeNow(const std::string &deviceName);
+    void runBulk(const std::shared_ptr<Bulk> &bulk);
+    static ConnectionStatus statusOf(const ConnectionEntry &entry);
     void markError(ConnectionEntry &entry, const std::string &message);
     void updateStatus(ConnectionEntry &entry, const std::function<void(ConnectionStatus &)> &fn);
 };
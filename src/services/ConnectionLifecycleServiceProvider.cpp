@@ -0,0 +1,12 @@
+#include "ConnectionLifecycleServiceProvider.h"
+
+#include "TrafficRecorderProvider.h"
+
+#include <drogon/drogon.h>
+
+ConnectionLifecycleService *ConnectionLifecycleServiceProvider::instance()
+{
+    static ConnectionLifecycleService service(IoRuntimeConfig::fromJson(drogon::app().getCustomConfig()["io"]),
+                                              SessionPoolProvider::instance(), TrafficRecorderProvider::instance());
+    return &service;
+}
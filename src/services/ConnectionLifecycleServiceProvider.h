@@ -5,10 +5,7 @@
 class ConnectionLifecycleServiceProvider
 {
 public:
-    static ConnectionLifecycleService *instance()
-    {
-        static ConnectionLifecycleService service;
-        return &service;
-    }
+    // Built on first use from the "io" block of custom_config.
+    static ConnectionLifecycleService *instance();
 };
 
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ConnectionTiming.h"
+#include "SequenceTracker.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+
+// Per-packet state of one open Class 1 connection. Only the I/O thread that
+// owns the connection writes it, sending and decoding input alike, so each
+// counter and histogram has one writer. The listeners
+// hold this object directly, so packet handling never looks the connection
+// up or takes a service lock, and status reads only load atomics.
+class ConnectionRuntime
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ConnectionRuntime(uint32_t rpiUs) : timing_(rpiUs) {}
+
+    // `encapsulationSequence` and `sequence` are the packet's encapsulation
+    // sequence number and CIP sequence count.
+    void received(Clock::time_point now, uint32_t encapsulationSequence, uint16_t sequence)
+    {
+        timing_.received(now);
+        encapsulationSequence_.observe(encapsulationSequence);
+        sequence_.observe(sequence);
+        lastActivity_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+        bump(received_);
+    }
+
+    void sent(Clock::time_point now)
+    {
+        timing_.sent(now);
+        lastActivity_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+        bump(sent_);
+    }
+
+    void closedByTarget() { closed_.store(true, std::memory_order_release); }
+    bool isClosedByTarget() const { return closed_.load(std::memory_order_acquire); }
+
+    uint64_t packetsSent() const { return sent_.load(std::memory_order_relaxed); }
+    uint64_t packetsReceived() const { return received_.load(std::memory_order_relaxed); }
+    const SequenceTracker &sequence() const { return sequence_; }
+    const EncapsulationSequenceTracker &encapsulationSequence() const { return encapsulationSequence_; }
+
+    // Wall-clock time of the last packet either way, or nullopt before the first.
+    std::optional<std::chrono::system_clock::time_point> lastActivity() const
+    {
+        const auto ticks = lastActivity_.load(std::memory_order_relaxed);
+        if (ticks == 0)
+        {
+            return std::nullopt;
+        }
+        const auto age = Clock::now() - Clock::time_point(Clock::duration(ticks));
+        return std::chrono::system_clock::now() -
+               std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+    }
+
+    const ConnectionTiming &timing() const { return timing_; }
+
+    // A view of the timing that keeps the whole runtime alive.
+    static std::shared_ptr<const ConnectionTiming> timing(const std::shared_ptr<ConnectionRuntime> &runtime)
+    {
+        return runtime ? std::shared_ptr<const ConnectionTiming>(runtime, &runtime->timing_) : nullptr;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> sent_{0};
+    std::atomic<uint64_t> received_{0};
+    ConnectionTiming timing_;
+    SequenceTracker sequence_;
+    EncapsulationSequenceTracker encapsulationSequence_;
+    std::atomic<Clock::rep> lastActivity_{0};
+    std::atomic<bool> closed_{false};
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+// HDR-style histogram of microsecond durations: values below 64 get exact
+// buckets, larger ones 32 log-linear buckets per power of two (about 3%
+// resolution) up to 2^36 us. Written by one thread with plain relaxed stores
+// and readable from any thread at any time; a reader may see a sample in
+// the count before it shows up in the sum.
+class TimingHistogram
+{
+public:
+    static constexpr unsigned kSubBits = 6;
+    static constexpr uint64_t kSubCount = uint64_t{1} << kSubBits;
+    static constexpr uint64_t kHalfCount = kSubCount / 2;
+    static constexpr unsigned kMaxBits = 36;
+    static constexpr size_t kBucketCount = kSubCount + (kMaxBits - kSubBits) * kHalfCount;
+
+    static size_t bucketOf(uint64_t value)
+    {
+        if (value < kSubCount)
+        {
+            return static_cast<size_t>(value);
+        }
+        const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        if (msb >= kMaxBits)
+        {
+            return kBucketCount - 1;
+        }
+        const unsigned shift = msb - (kSubBits - 1);
+        return static_cast<size_t>(kSubCount + (shift - 1) * kHalfCount + ((value >> shift) - kHalfCount));
+    }
+
+    static uint64_t bucketLow(size_t bucket)
+    {
+        if (bucket < kSubCount)
+        {
+            return bucket;
+        }
+        const auto shift = (bucket - kSubCount) / kHalfCount + 1;
+        return ((bucket - kSubCount) % kHalfCount + kHalfCount) << shift;
+    }
+
+    static uint64_t bucketHigh(size_t bucket)
+    {
+        return bucket + 1 < kBucketCount ? bucketLow(bucket + 1) - 1 : std::numeric_limits<uint64_t>::max();
+    }
+
+    void record(uint64_t valueUs)
+    {
+        bump(counts_[bucketOf(valueUs)], 1);
+        bump(count_, 1);
+        bump(sum_, valueUs);
+        if (valueUs < min_.load(std::memory_order_relaxed))
+        {
+            min_.store(valueUs, std::memory_order_relaxed);
+        }
+        if (valueUs > max_.load(std::memory_order_relaxed))
+        {
+            max_.store(valueUs, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the given quantile, capped at the maximum.
+    uint64_t percentile(double quantile) const
+    {
+        const auto total = count();
+        if (total == 0)
+        {
+            return 0;
+        }
+        const auto rank = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i)
+        {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                return std::min(bucketHigh(i), max_.load(std::memory_order_relaxed));
+            }
+        }
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        const auto total = count();
+        value["count"] = static_cast<Json::UInt64>(total);
+        if (total == 0)
+        {
+            return value;
+        }
+        value["minUs"] = static_cast<Json::UInt64>(min_.load(std::memory_order_relaxed));
+        value["maxUs"] = static_cast<Json::UInt64>(max_.load(std::memory_order_relaxed));
+        value["meanUs"] = static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(total);
+        value["p50Us"] = static_cast<Json::UInt64>(percentile(0.50));
+        value["p90Us"] = static_cast<Json::UInt64>(percentile(0.90));
+        value["p99Us"] = static_cast<Json::UInt64>(percentile(0.99));
+        value["p999Us"] = static_cast<Json::UInt64>(percentile(0.999));
+
+        Json::Value buckets(Json::arrayValue);
+        for (size_t i = 0; i < kBucketCount; ++i)
+        {
+            const auto hits = counts_[i].load(std::memory_order_relaxed);
+            if (hits == 0)
+            {
+                continue;
+            }
+            Json::Value bucket;
+            bucket["lowUs"] = static_cast<Json::UInt64>(bucketLow(i));
+            bucket["highUs"] = static_cast<Json::UInt64>(bucketHigh(i));
+            bucket["count"] = static_cast<Json::UInt64>(hits);
+            buckets.append(bucket);
+        }
+        value["buckets"] = buckets;
+        return value;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t> &counter, uint64_t amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Cycle timing of one Class 1 connection, fed from its I/O thread: the gap
+// between consecutive T->O packets, between consecutive O->T packets, and
+// how far each O->T gap strays from the configured RPI.
+class ConnectionTiming
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ConnectionTiming(uint32_t rpiUs) : rpiUs_(rpiUs) {}
+
+    void received(Clock::time_point now) { interval(lastArrival_, now, interArrival_, false); }
+    void sent(Clock::time_point now) { interval(lastSend_, now, interSend_, true); }
+
+    uint32_t rpiUs() const { return rpiUs_; }
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["rpiUs"] = rpiUs_;
+        value["interArrival"] = interArrival_.toJson();
+        value["interSend"] = interSend_.toJson();
+        value["rpiDeviation"] = deviation_.toJson();
+        return value;
+    }
+
+private:
+    void interval(Clock::time_point &last, Clock::time_point now, TimingHistogram &histogram, bool track)
+    {
+        if (last != Clock::time_point{})
+        {
+            const auto gap = std::chrono::duration_cast<std::chrono::microseconds>(now - last).count();
+            const auto gapUs = static_cast<uint64_t>(gap > 0 ? gap : 0);
+            histogram.record(gapUs);
+            if (track)
+            {
+                deviation_.record(gapUs > rpiUs_ ? gapUs - rpiUs_ : rpiUs_ - gapUs);
+            }
+        }
+        last = now;
+    }
+
+    uint32_t rpiUs_;
+    Clock::time_point lastArrival_{};
+    Clock::time_point lastSend_{};
+    TimingHistogram interArrival_;
+    TimingHistogram interSend_;
+    TimingHistogram deviation_;
+};
@@ -1,7 +1,6 @@
 #include "EIPExplicitMessageService.h"
 
 #include <EIPScanner/MessageRouter.h>
-#include <EIPScanner/SessionInfo.h>
 #include <EIPScanner/cip/EPath.h>
 #include <chrono>
 #include <system_error>
@@ -10,10 +9,10 @@ std::optional<ExplicitMessageResult> EIPExplicitMessageService::sendExplicit(con
                                                                              const ExplicitMessageRequest &request,
                                                                              std::string &error)
 {
+    std::optional<SessionPool::Lease> lease;
     try
     {
-        auto timeout = std::chrono::milliseconds(device.timeoutMs);
-        auto session = std::make_shared<eipScanner::SessionInfo>(device.ipAddress, device.port, timeout);
+        lease.emplace(sessions_->acquire(device.ipAddress, device.port, std::chrono::milliseconds(device.timeoutMs)));
         eipScanner::MessageRouter router;
 
         eipScanner::cip::EPath path(request.classId);
@@ -29,7 +28,7 @@ std::optional<ExplicitMessageResult> EIPExplicitMessageService::sendExplicit(con
             }
         }
 
-        auto response = router.sendRequest(session,
+        auto response = router.sendRequest(lease->session(),
                                            static_cast<eipScanner::cip::CipUsint>(request.serviceCode),
                                            path,
                                            request.payload);
@@ -42,6 +41,10 @@ std::optional<ExplicitMessageResult> EIPExplicitMessageService::sendExplicit(con
     }
     catch (const std::system_error &ex)
     {
+        if (lease)
+        {
+            lease->invalidate();
+        }
         if (ex.code() == std::errc::timed_out)
         {
             error = "Request timed out after " + std::to_string(device.timeoutMs) + " ms";
@@ -53,10 +56,18 @@ std::optional<ExplicitMessageResult> EIPExplicitMessageService::sendExplicit(con
     }
     catch (const std::exception &ex)
     {
+        if (lease)
+        {
+            lease->invalidate();
+        }
         error = ex.what();
     }
     catch (...)
     {
+        if (lease)
+        {
+            lease->invalidate();
+        }
         error = "Unknown error while sending explicit message";
     }
 
@@ -1,11 +1,20 @@
 #pragma once
 
 #include "ExplicitMessageService.h"
+#include "SessionPoolProvider.h"
 
 class EIPExplicitMessageService : public ExplicitMessageService
 {
 public:
+    explicit EIPExplicitMessageService(std::shared_ptr<SessionPool> sessions = SessionPoolProvider::instance())
+        : sessions_(std::move(sessions))
+    {
+    }
+
     std::optional<ExplicitMessageResult> sendExplicit(const Device &device,
                                                       const ExplicitMessageRequest &request,
                                                       std::string &error) override;
+
+private:
+    std::shared_ptr<SessionPool> sessions_;
 };
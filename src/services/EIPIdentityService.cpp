@@ -1,17 +1,16 @@
 #include "EIPIdentityService.h"
 
 #include <EIPScanner/IdentityObject.h>
-#include <EIPScanner/SessionInfo.h>
 #include <chrono>
 #include <exception>
 
 std::optional<IdentityResult> EIPIdentityService::readIdentity(const Device &device, std::string &error)
 {
+    std::optional<SessionPool::Lease> lease;
     try
     {
-        auto timeout = std::chrono::milliseconds(device.timeoutMs);
-        auto session = std::make_shared<eipScanner::SessionInfo>(device.ipAddress, device.port, timeout);
-        eipScanner::IdentityObject identity(1, session);
+        lease.emplace(sessions_->acquire(device.ipAddress, device.port, std::chrono::milliseconds(device.timeoutMs)));
+        eipScanner::IdentityObject identity(1, lease->session());
 
         IdentityResult result;
         result.vendorId = identity.getVendorId();
@@ -25,10 +24,18 @@ std::optional<IdentityResult> EIPIdentityService::readIdentity(const Device &dev
     }
     catch (const std::exception &ex)
     {
+        if (lease)
+        {
+            lease->invalidate();
+        }
         error = ex.what();
     }
     catch (...)
     {
+        if (lease)
+        {
+            lease->invalidate();
+        }
         error = "Unknown error while reading identity";
     }
 
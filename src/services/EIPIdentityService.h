@@ -1,11 +1,20 @@
 #pragma once
 
 #include "IdentityService.h"
+#include "SessionPoolProvider.h"
 #include <memory>
 
 class EIPIdentityService : public IdentityService
 {
 public:
+    explicit EIPIdentityService(std::shared_ptr<SessionPool> sessions = SessionPoolProvider::instance())
+        : sessions_(std::move(sessions))
+    {
+    }
+
     std::optional<IdentityResult> readIdentity(const Device &device, std::string &error) override;
+
+private:
+    std::shared_ptr<SessionPool> sessions_;
 };
 
@@ -0,0 +1,338 @@
+#include "IOReactor.h"
+
+#include <algorithm>
+#include <alloca.h>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <system_error>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr int kMaxEvents = 64;
+
+void notify(int fd)
+{
+    const uint64_t one = 1;
+    // Only fails when the counter is saturated, in which case it is already readable.
+    if (::write(fd, &one, sizeof(one)) < 0)
+    {
+        return;
+    }
+}
+
+void drain(int fd)
+{
+    uint64_t count;
+    while (::read(fd, &count, sizeof(count)) == sizeof(count))
+    {
+    }
+}
+
+void touchStack(size_t bytes)
+{
+    // The pages stay mapped after the frame is popped (and locked under mlockall).
+    auto *stack = static_cast<volatile unsigned char *>(alloca(bytes));
+    const auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    for (size_t offset = 0; offset < bytes; offset += page)
+    {
+        stack[offset] = 0;
+    }
+}
+} // namespace
+
+IOReactor::IOReactor()
+{
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    timerFd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || timerFd_ < 0 || wakeFd_ < 0)
+    {
+        const int code = errno;
+        for (int fd : {epollFd_, timerFd_, wakeFd_})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+        throw std::system_error(code, std::generic_category(), "IOReactor");
+    }
+
+    for (int fd : {timerFd_, wakeFd_})
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    worker_ = std::thread([this]() { loop(); });
+}
+
+IOReactor::~IOReactor()
+{
+    running_ = false;
+    notify(wakeFd_);
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+    ::close(wakeFd_);
+    ::close(timerFd_);
+    ::close(epollFd_);
+}
+
+void IOReactor::attach(const std::string &name, Poll poll, std::chrono::microseconds period, int inputFd, Poll input)
+{
+    auto task = std::make_shared<Task>();
+    task->poll = std::move(poll);
+    task->period = std::max(period, std::chrono::microseconds(1));
+    if (inputFd >= 0 && input)
+    {
+        task->inputFd = inputFd;
+        task->input = std::move(input);
+    }
+    post({name, std::move(task), nullptr, nullptr});
+}
+
+void IOReactor::detach(const std::string &name)
+{
+    if (std::this_thread::get_id() == worker_.get_id())
+    {
+        post({name, nullptr, nullptr, nullptr});
+        return;
+    }
+
+    auto done = std::make_shared<std::promise<void>>();
+    auto finished = done->get_future();
+    post({name, nullptr, done, nullptr});
+    finished.wait();
+}
+
+bool IOReactor::pin(int cpu, std::string &error)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+        error = "CPU " + std::to_string(cpu) + " is out of range";
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    const int result = ::pthread_setaffinity_np(worker_.native_handle(), sizeof(set), &set);
+    if (result != 0)
+    {
+        error = "Cannot pin to CPU " + std::to_string(cpu) + ": " + std::strerror(result);
+        return false;
+    }
+    return true;
+}
+
+bool IOReactor::setRealtimePriority(int priority, std::string &error)
+{
+    sched_param param{};
+    param.sched_priority = priority;
+    const int result = ::pthread_setschedparam(worker_.native_handle(), SCHED_FIFO, &param);
+    if (result == EPERM)
+    {
+        error = "SCHED_FIFO priority " + std::to_string(priority) +
+                " needs CAP_SYS_NICE or an RLIMIT_RTPRIO of at least " + std::to_string(priority);
+        return false;
+    }
+    if (result != 0)
+    {
+        error = "Cannot set SCHED_FIFO priority " + std::to_string(priority) + ": " + std::strerror(result);
+        return false;
+    }
+    return true;
+}
+
+int IOReactor::realtimePriority()
+{
+    int policy = SCHED_OTHER;
+    sched_param param{};
+    if (::pthread_getschedparam(worker_.native_handle(), &policy, &param) != 0)
+    {
+        return 0;
+    }
+    return policy == SCHED_FIFO || policy == SCHED_RR ? param.sched_priority : 0;
+}
+
+std::chrono::microseconds IOReactor::cpuTime()
+{
+    clockid_t clock;
+    timespec now{};
+    if (::pthread_getcpuclockid(worker_.native_handle(), &clock) != 0 || ::clock_gettime(clock, &now) != 0)
+    {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::seconds(now.tv_sec) + std::chrono::duration_cast<std::chrono::microseconds>(
+                                                  std::chrono::nanoseconds(now.tv_nsec));
+}
+
+void IOReactor::prefaultStack(size_t bytes)
+{
+    if (bytes == 0 || std::this_thread::get_id() == worker_.get_id())
+    {
+        return;
+    }
+
+    auto done = std::make_shared<std::promise<void>>();
+    auto finished = done->get_future();
+    post({{}, nullptr, done, [bytes]() { touchStack(bytes); }});
+    finished.wait();
+}
+
+void IOReactor::post(Command command)
+{
+    {
+        std::lock_guard<std::mutex> lock(commandMutex_);
+        commands_.push_back(std::move(command));
+    }
+    notify(wakeFd_);
+}
+
+void IOReactor::loop()
+{
+    epoll_event events[kMaxEvents];
+    while (running_)
+    {
+        arm();
+        const int ready = ::epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (ready < 0 && errno != EINTR)
+        {
+            break;
+        }
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[i].data.fd == timerFd_ || events[i].data.fd == wakeFd_)
+            {
+                drain(events[i].data.fd);
+            }
+        }
+
+        // Commands first, so no input runs for a task that was just dropped.
+        applyCommands();
+        for (int i = 0; i < ready; ++i)
+        {
+            const auto it = inputs_.find(events[i].data.fd);
+            if (it != inputs_.end())
+            {
+                it->second->input();
+            }
+        }
+
+        const auto now = Clock::now();
+        for (auto &pair : tasks_)
+        {
+            if (pair.second.slot <= now)
+            {
+                service(pair.second, now);
+            }
+        }
+    }
+
+    // Release anyone still waiting in detach().
+    applyCommands();
+}
+
+void IOReactor::applyCommands()
+{
+    std::vector<Command> commands;
+    {
+        std::lock_guard<std::mutex> lock(commandMutex_);
+        commands.swap(commands_);
+    }
+
+    for (auto &command : commands)
+    {
+        if (command.call)
+        {
+            if (running_)
+            {
+                command.call();
+            }
+        }
+        else if (command.task)
+        {
+            auto &task = tasks_[command.name];
+            watch(task, false);
+            task = std::move(*command.task);
+            task.slot = Clock::now();
+            watch(task, true);
+        }
+        else
+        {
+            const auto it = tasks_.find(command.name);
+            if (it != tasks_.end())
+            {
+                watch(it->second, false);
+                tasks_.erase(it);
+            }
+        }
+        if (command.done)
+        {
+            command.done->set_value();
+        }
+    }
+}
+
+void IOReactor::watch(Task &task, bool add)
+{
+    if (task.inputFd < 0)
+    {
+        return;
+    }
+    if (add)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = task.inputFd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, task.inputFd, &event);
+        inputs_[task.inputFd] = &task;
+    }
+    else
+    {
+        ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, task.inputFd, nullptr);
+        inputs_.erase(task.inputFd);
+    }
+}
+
+void IOReactor::service(Task &task, Clock::time_point now)
+{
+    task.poll();
+
+    // Stay on the absolute schedule; after a stall resynchronise instead of
+    // bursting through the missed cycles.
+    task.slot += task.period;
+    if (task.slot <= now)
+    {
+        task.slot = now + task.period;
+    }
+}
+
+void IOReactor::arm()
+{
+    itimerspec spec{};
+    if (!tasks_.empty())
+    {
+        auto due = Clock::time_point::max();
+        for (const auto &pair : tasks_)
+        {
+            due = std::min(due, pair.second.slot);
+        }
+        // steady_clock is CLOCK_MONOTONIC; a zero it_value would disarm the timer.
+        const auto ns = std::max<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(due.time_since_epoch()).count(), 1);
+        spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+    ::timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
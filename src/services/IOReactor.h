@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Services cyclic connections from one thread that sleeps in epoll until the
+// next connection is due (timerfd), a connection has input waiting, or the
+// task set changes (eventfd). Each
+// task's poll runs exactly once per period on an absolute schedule, and never
+// between slots, so a poll that sends one packet sends at the period.
+class IOReactor
+{
+public:
+    using Poll = std::function<void()>;
+
+    IOReactor();
+    ~IOReactor();
+
+    IOReactor(const IOReactor &) = delete;
+    IOReactor &operator=(const IOReactor &) = delete;
+
+    // Replaces any task with the same name; the first poll runs immediately.
+    // With an `inputFd`, `input` also runs whenever the fd is readable and
+    // reads it until it would block; the fd stays open until the task is dropped.
+    void attach(const std::string &name, Poll poll, std::chrono::microseconds period, int inputFd = -1,
+                Poll input = {});
+    // Returns once the reactor thread has dropped the task, so its poll is no
+    // longer running. From inside a poll the removal is only queued.
+    void detach(const std::string &name);
+
+    // Restricts the reactor thread to one CPU.
+    bool pin(int cpu, std::string &error);
+    // Moves the reactor thread to SCHED_FIFO at the given priority.
+    bool setRealtimePriority(int priority, std::string &error);
+    // The thread's SCHED_FIFO/SCHED_RR priority, or 0 under the normal scheduler.
+    int realtimePriority();
+    // CPU time the reactor thread has used so far.
+    std::chrono::microseconds cpuTime();
+    // Touches the reactor thread's stack so a deep call during a cycle does not page fault.
+    void prefaultStack(size_t bytes);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task
+    {
+        Poll poll;
+        std::chrono::microseconds period;
+        Clock::time_point slot; // when the next poll is due
+        int inputFd{-1};
+        Poll input;
+    };
+
+    struct Command
+    {
+        std::string name;
+        std::shared_ptr<Task> task;
+        std::shared_ptr<std::promise<void>> done;
+        std::function<void()> call; // runs on the reactor thread instead of changing tasks
+    };
+
+    int epollFd_{-1};
+    int timerFd_{-1};
+    int wakeFd_{-1};
+    std::mutex commandMutex_;
+    std::vector<Command> commands_;
+    std::atomic<bool> running_{true};
+    std::map<std::string, Task> tasks_;
+    // Tasks by input fd, for the epoll events.
+    std::map<int, Task *> inputs_;
+    std::thread worker_;
+
+    void loop();
+    void post(Command command);
+    void applyCommands();
+    void watch(Task &task, bool add);
+    void service(Task &task, Clock::time_point now);
+    void arm();
+};
@@ -0,0 +1,159 @@
+#include "IOReactorPool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace
+{
+bool lockMemory(std::string &error)
+{
+    if (::mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+    {
+        return true;
+    }
+    const int code = errno;
+    error = code == EPERM || code == ENOMEM
+                ? "mlockall needs CAP_IPC_LOCK or an unlimited RLIMIT_MEMLOCK"
+                : std::string("mlockall failed: ") + std::strerror(code);
+    return false;
+}
+} // namespace
+
+IOReactorPool::IOReactorPool(const IoRuntimeConfig &config)
+{
+    const auto &realtime = config.realtime;
+    std::string memoryError;
+    if (realtime.enabled && realtime.lockMemory)
+    {
+        lockMemory(memoryError);
+    }
+
+    const auto count = config.threadCount();
+    threads_.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto &thread = threads_[i];
+        thread.reactor = std::make_unique<IOReactor>();
+        if (!config.cpus.empty())
+        {
+            thread.cpu = config.cpus[i % config.cpus.size()];
+            if (!thread.reactor->pin(thread.cpu, thread.affinityError))
+            {
+                thread.cpu = -1;
+            }
+        }
+        if (!realtime.enabled)
+        {
+            continue;
+        }
+
+        // Fault the stack in before leaving the normal scheduler; a failed
+        // priority change leaves the thread running, just not real-time.
+        std::vector<std::string> errors;
+        if (!memoryError.empty())
+        {
+            errors.push_back(memoryError);
+        }
+        thread.reactor->prefaultStack(realtime.prefaultStackKb * 1024);
+        std::string error;
+        if (!thread.reactor->setRealtimePriority(realtime.priority, error))
+        {
+            errors.push_back(error);
+        }
+        for (const auto &message : errors)
+        {
+            thread.realtimeError += (thread.realtimeError.empty() ? "" : "; ") + message;
+        }
+    }
+}
+
+size_t IOReactorPool::attach(const std::string &name, IOReactor::Poll poll, std::chrono::microseconds period,
+                             int inputFd, IOReactor::Poll input)
+{
+    const double load = 1e6 / static_cast<double>(std::max<int64_t>(period.count(), 1));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = placements_.find(name);
+    if (it == placements_.end())
+    {
+        size_t best = 0;
+        for (size_t i = 1; i < threads_.size(); ++i)
+        {
+            if (threads_[i].load < threads_[best].load)
+            {
+                best = i;
+            }
+        }
+        it = placements_.emplace(name, Placement{best, 0.0, false}).first;
+    }
+
+    auto &placement = it->second;
+    auto &thread = threads_[placement.thread];
+    if (!placement.attached)
+    {
+        placement.attached = true;
+        thread.connections++;
+    }
+    thread.load += load - placement.load;
+    placement.load = load;
+    thread.reactor->attach(name, std::move(poll), period, inputFd, std::move(input));
+    return placement.thread;
+}
+
+void IOReactorPool::detach(const std::string &name)
+{
+    release(name, false);
+}
+
+void IOReactorPool::forget(const std::string &name)
+{
+    release(name, true);
+}
+
+void IOReactorPool::release(const std::string &name, bool forget)
+{
+    IOReactor *reactor = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = placements_.find(name);
+        if (it == placements_.end())
+        {
+            return;
+        }
+        auto &placement = it->second;
+        auto &thread = threads_[placement.thread];
+        if (placement.attached)
+        {
+            thread.connections--;
+            thread.load = thread.connections > 0 ? thread.load - placement.load : 0.0;
+            reactor = thread.reactor.get();
+        }
+        placement.attached = false;
+        placement.load = 0.0;
+        if (forget)
+        {
+            placements_.erase(it);
+        }
+    }
+    if (reactor)
+    {
+        reactor->detach(name);
+    }
+}
+
+std::vector<IoThreadStatus> IOReactorPool::threads() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<IoThreadStatus> items;
+    items.reserve(threads_.size());
+    for (size_t i = 0; i < threads_.size(); ++i)
+    {
+        const auto &thread = threads_[i];
+        items.push_back({i, thread.cpu, thread.connections, thread.load, thread.affinityError,
+                         thread.reactor->realtimePriority(), thread.realtimeError,
+                         static_cast<uint64_t>(thread.reactor->cpuTime().count())});
+    }
+    return items;
+}
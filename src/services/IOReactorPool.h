@@ -0,0 +1,84 @@
+#pragma once
+
+#include "IOReactor.h"
+#include "models/IoRuntimeConfig.h"
+
+#include <json/json.h>
+
+struct IoThreadStatus
+{
+    size_t index{0};
+    int cpu{-1};
+    size_t connections{0};
+    double packetsPerSecond{0.0};
+    std::string affinityError;
+    // SCHED_FIFO priority the thread runs at; 0 under the normal scheduler.
+    int realtimePriority{0};
+    std::string realtimeError;
+    uint64_t cpuTimeUs{0};
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["index"] = static_cast<Json::UInt64>(index);
+        value["cpu"] = cpu;
+        value["connections"] = static_cast<Json::UInt64>(connections);
+        value["packetsPerSecond"] = packetsPerSecond;
+        if (!affinityError.empty())
+        {
+            value["affinityError"] = affinityError;
+        }
+        value["realtimePriority"] = realtimePriority;
+        if (!realtimeError.empty())
+        {
+            value["realtimeError"] = realtimeError;
+        }
+        value["cpuTimeUs"] = static_cast<Json::UInt64>(cpuTimeUs);
+        return value;
+    }
+};
+
+// A fixed set of IOReactor threads. Each connection goes to the thread with
+// the lowest cyclic load (packets per second, 1 / RPI) and stays there, so a
+// slow device only delays the connections sharing its thread.
+class IOReactorPool
+{
+public:
+    explicit IOReactorPool(const IoRuntimeConfig &config = {});
+
+    // Returns the index of the thread the task runs on. A name keeps its
+    // thread across re-attaches and detaches until it is forgotten.
+    size_t attach(const std::string &name, IOReactor::Poll poll, std::chrono::microseconds period, int inputFd = -1,
+                  IOReactor::Poll input = {});
+    void detach(const std::string &name);
+    // Detaches the name and drops its placement.
+    void forget(const std::string &name);
+
+    size_t size() const { return threads_.size(); }
+    std::vector<IoThreadStatus> threads() const;
+
+private:
+    struct Thread
+    {
+        std::unique_ptr<IOReactor> reactor;
+        int cpu{-1};
+        std::string affinityError;
+        std::string realtimeError;
+        size_t connections{0};
+        double load{0.0};
+    };
+
+    // Load is zero while the name is detached.
+    struct Placement
+    {
+        size_t thread;
+        double load;
+        bool attached;
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Thread> threads_;
+    std::map<std::string, Placement> placements_;
+
+    void release(const std::string &name, bool forget);
+};
@@ -1,6 +1,7 @@
 #include "IOSignalService.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <memory>
@@ -8,234 +9,784 @@
 
 namespace
 {
-uint16_t readLE16(const std::vector<uint8_t> &data, size_t offset)
+int64_t nowUs()
 {
-    if (offset + 2 > data.size())
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+bool exceedsDeadband(DeadbandMode mode, double band, double reported, double value)
+{
+    switch (mode)
     {
-        return 0;
+    case DeadbandMode::Absolute:
+        return std::fabs(value - reported) > band;
+    case DeadbandMode::Percent:
+        return std::fabs(value - reported) > std::fabs(reported) * band / 100.0;
+    case DeadbandMode::None:
+        break;
     }
-    return static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+    return value != reported;
+}
+
+// A random walk that fell further behind than this (the connection was idle)
+// jumps to the present instead of replaying every missed step on the I/O path.
+constexpr int64_t kMaxWalkCatchUp = 1024;
+
+uint64_t nextRandom(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
 }
 
-uint32_t readLE32(const std::vector<uint8_t> &data, size_t offset)
+YAML::Node jsonToYaml(const Json::Value &value)
 {
-    if (offset + 4 > data.size())
+    YAML::Node node;
+    if (value.isObject())
+    {
+        for (const auto &key : value.getMemberNames())
+        {
+            node[key] = jsonToYaml(value[key]);
+        }
+    }
+    else if (value.isArray())
+    {
+        for (const auto &entry : value)
+        {
+            node.push_back(jsonToYaml(entry));
+        }
+    }
+    else if (value.isBool())
+    {
+        node = value.asBool();
+    }
+    else if (value.isIntegral())
+    {
+        node = value.asInt64();
+    }
+    else if (value.isDouble())
+    {
+        node = value.asDouble();
+    }
+    else
     {
-        return 0;
+        node = value.asString();
     }
-    return static_cast<uint32_t>(data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) |
-                                 (data[offset + 3] << 24));
+    return node;
 }
 
-void writeLE16(uint16_t value, std::vector<uint8_t> &buffer, size_t offset)
+// Scalars become integers, then doubles, then strings, whichever parses first.
+Json::Value yamlToJson(const YAML::Node &node)
 {
-    if (offset + 2 > buffer.size())
+    if (node.IsMap())
     {
-        buffer.resize(offset + 2, 0);
+        Json::Value object(Json::objectValue);
+        for (const auto &kv : node)
+        {
+            object[kv.first.as<std::string>()] = yamlToJson(kv.second);
+        }
+        return object;
+    }
+    if (node.IsSequence())
+    {
+        Json::Value array(Json::arrayValue);
+        for (const auto &entry : node)
+        {
+            array.append(yamlToJson(entry));
+        }
+        return array;
     }
-    buffer[offset] = static_cast<uint8_t>(value & 0xFF);
-    buffer[offset + 1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    try
+    {
+        return node.as<int>();
+    }
+    catch (...)
+    {
+        try
+        {
+            return node.as<double>();
+        }
+        catch (...)
+        {
+            return node.as<std::string>();
+        }
+    }
+}
 }
 
-void writeLE32(uint32_t value, std::vector<uint8_t> &buffer, size_t offset)
+IOSignalService::DeviceRef IOSignalService::attach(const std::string &deviceName)
 {
-    if (offset + 4 > buffer.size())
+    if (auto device = find(deviceName))
     {
-        buffer.resize(offset + 4, 0);
+        return device;
     }
-    buffer[offset] = static_cast<uint8_t>(value & 0xFF);
-    buffer[offset + 1] = static_cast<uint8_t>((value >> 8) & 0xFF);
-    buffer[offset + 2] = static_cast<uint8_t>((value >> 16) & 0xFF);
-    buffer[offset + 3] = static_cast<uint8_t>((value >> 24) & 0xFF);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto &device = devices_[deviceName];
+    if (!device)
+    {
+        device = std::make_shared<DeviceSignals>();
+        resizeBuffers(*device, true);
+    }
+    return device;
 }
+
+void IOSignalService::configureAssemblies(const DeviceRef &device, const ConnectionConfig &config)
+{
+    std::lock_guard<std::mutex> lock(device->mutex);
+    if (device->inputBytes == config.inputAssembly.sizeBytes && device->outputBytes == config.outputAssembly.sizeBytes)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> readLock(device->readMutex);
+    device->inputBytes = config.inputAssembly.sizeBytes;
+    device->outputBytes = config.outputAssembly.sizeBytes;
+    resizeBuffers(*device, false);
+}
+
+IOSignalService::DeviceRef IOSignalService::find(const std::string &deviceName) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = devices_.find(deviceName);
+    return it == devices_.end() ? nullptr : it->second;
+}
+
+int64_t IOSignalService::generatorElapsedUs() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - generatorEpoch_)
+        .count();
 }
 
 void IOSignalService::applyMappings(const std::string &deviceName, const std::vector<SignalMapping> &mappings)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto &device = devices_[deviceName];
-    device.mappings = mappings;
-    device.inputs.clear();
-    device.outputs.clear();
-    for (const auto &mapping : mappings)
+    auto device = attach(deviceName);
     {
-        if (mapping.direction == SignalDirection::Output)
+        std::lock_guard<std::mutex> lock(device->mutex);
+        if (device->layout->mappings == mappings)
         {
-            device.outputs[mapping.name] = 0.0;
+            // Controllers re-apply mappings on most requests; keep the compiled plan and live values.
+            return;
         }
-        else
+
+        auto layout = std::make_shared<SignalLayout>();
+        layout->mappings = mappings;
+        for (size_t i = 0; i < mappings.size(); ++i)
+        {
+            layout->handles.emplace(mappings[i].name, static_cast<SignalHandle>(i));
+        }
+        layout->inputPlan = SignalDecodePlan::compile(mappings);
+        for (size_t i = 0; i < mappings.size(); ++i)
+        {
+            const auto &mapping = mappings[i];
+            if (mapping.direction == SignalDirection::Output)
+            {
+                layout->outputExtent = std::max<size_t>(layout->outputExtent, mapping.byteOffset + mapping.widthBytes());
+            }
+            else
+            {
+                layout->inputFilters.push_back({static_cast<SignalHandle>(i), mapping.deadbandMode, mapping.deadband});
+            }
+            std::string ignored;
+            if (mapping.direction == SignalDirection::Output && mapping.type != SignalType::String &&
+                mapping.generator.has_value() && mapping.generator->isValid(ignored))
+            {
+                layout->generators.push_back({static_cast<SignalHandle>(i), *mapping.generator});
+            }
+        }
+        device->outputValues.assign(mappings.size(), 0.0);
+        // Walks start midway at the current step, so a re-applied layout does not replay the time since startup.
+        device->walks.clear();
+        const auto elapsedUs = generatorElapsedUs();
+        for (const auto &output : layout->generators)
+        {
+            const auto &generator = output.generator;
+            WalkState walk;
+            walk.step = elapsedUs / generator.cycleUs();
+            walk.value = (generator.low + generator.high) / 2.0;
+            walk.rng = (static_cast<uint64_t>(generator.seed) << 32) | 0x9E3779B9u;
+            device->walks.push_back(walk);
+        }
+        device->outputDirty.assign(mappings.size(), 0);
+        device->dirtyOutputs.clear();
+        device->dirtyOutputs.reserve(mappings.size());
+        // Report the whole new layout as changed so change followers resynchronize.
+        device->reportedInputs.assign(mappings.size(), 0.0);
+        device->changedAt.assign(mappings.size(), ++device->changeVersion);
+
+        std::lock_guard<std::mutex> readLock(device->readMutex);
+        device->layout = std::move(layout);
+        resizeBuffers(*device, true);
+        allocateHistory(*device);
+    }
+    // Rules resolve handles across devices, so any layout change recompiles all of them.
+    rebuildRules();
+}
+
+void IOSignalService::forget(const std::string &deviceName)
+{
+    DeviceRef device;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = devices_.find(deviceName);
+        if (it == devices_.end())
+        {
+            return;
+        }
+        device = std::move(it->second);
+        devices_.erase(it);
+    }
+    {
+        std::lock_guard<std::mutex> budgetLock(historyBudgetMutex_);
+        std::lock_guard<std::mutex> historyLock(device->historyMutex);
+        historyBytes_ -= device->history.bytes();
+    }
+    rebuildRules();
+}
+
+// Compiles the rules on every device's outputs against the current layouts.
+// References to devices or inputs that do not exist yet leave their rule
+// inactive until a later layout change resolves them.
+void IOSignalService::rebuildRules()
+{
+    std::lock_guard<std::mutex> buildLock(rulesBuildMutex_);
+    std::map<std::string, DeviceRef> devices;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        devices = devices_;
+    }
+    std::unordered_map<const DeviceSignals *, std::shared_ptr<const SignalLayout>> layouts;
+    std::unordered_map<const DeviceSignals *, std::vector<double>> inputs;
+    for (const auto &[name, device] : devices)
+    {
+        std::lock_guard<std::mutex> lock(device->readMutex);
+        layouts[device.get()] = device->layout;
+        inputs[device.get()] = device->inputFrames.acquire().values;
+    }
+
+    auto set = std::make_shared<RuleSet>();
+    std::map<std::pair<const DeviceSignals *, SignalHandle>, uint32_t> registers;
+    std::vector<double> initial;
+    for (const auto &[name, device] : devices)
+    {
+        const auto &layout = layouts[device.get()];
+        for (size_t i = 0; i < layout->mappings.size(); ++i)
+        {
+            const auto &mapping = layout->mappings[i];
+            if (!mapping.rule || mapping.direction != SignalDirection::Output || mapping.type == SignalType::String ||
+                mapping.generator)
+            {
+                continue;
+            }
+            RuleSet::Rule rule;
+            rule.device = name;
+            rule.signal = mapping.name;
+            rule.source = *mapping.rule;
+            rule.target = device;
+            rule.layout = layout;
+            rule.slot = static_cast<SignalHandle>(i);
+
+            std::vector<std::pair<const DeviceSignals *, SignalHandle>> reads;
+            const RuleProgram::Resolver resolve = [&, owner = name](const std::string &deviceName,
+                                                                    const std::string &signal,
+                                                                    std::string &error) -> std::optional<uint32_t> {
+                const auto &sourceName = deviceName.empty() ? owner : deviceName;
+                const auto source = devices.find(sourceName);
+                if (source == devices.end())
+                {
+                    error = "unknown device " + sourceName;
+                    return std::nullopt;
+                }
+                const auto &sourceLayout = *layouts[source->second.get()];
+                const auto handle = sourceLayout.handles.find(signal);
+                if (handle == sourceLayout.handles.end() ||
+                    sourceLayout.mappings[handle->second].direction != SignalDirection::Input ||
+                    sourceLayout.mappings[handle->second].type == SignalType::String)
+                {
+                    error = sourceName + " has no numeric input " + signal;
+                    return std::nullopt;
+                }
+                const auto key = std::make_pair(static_cast<const DeviceSignals *>(source->second.get()), handle->second);
+                auto slot = registers.find(key);
+                if (slot == registers.end())
+                {
+                    const auto &values = inputs[key.first];
+                    initial.push_back(key.second < values.size() ? values[key.second] : 0.0);
+                    slot = registers.emplace(key, static_cast<uint32_t>(initial.size() - 1)).first;
+                }
+                reads.push_back(key);
+                return slot->second;
+            };
+
+            std::string error;
+            if ((!rule.source.when.empty() && !set->program.compile(rule.source.when, resolve, rule.when, error)) ||
+                !set->program.compile(rule.source.value, resolve, rule.value, error))
+            {
+                rule.error = error;
+            }
+            else if (reads.empty())
+            {
+                rule.error = "the rule reads no inputs";
+            }
+            else
+            {
+                const auto index = static_cast<uint32_t>(set->rules.size());
+                for (const auto &[source, handle] : reads)
+                {
+                    auto &entry = set->sources[source];
+                    entry.layout = layouts[source];
+                    entry.loads.emplace_back(handle, registers.at({source, handle}));
+                    if (entry.rules.empty() || entry.rules.back() != index)
+                    {
+                        entry.rules.push_back(index);
+                    }
+                }
+            }
+            set->rules.push_back(std::move(rule));
+        }
+    }
+    for (auto &[source, entry] : set->sources)
+    {
+        std::sort(entry.loads.begin(), entry.loads.end());
+        entry.loads.erase(std::unique(entry.loads.begin(), entry.loads.end()), entry.loads.end());
+    }
+    set->registers = std::make_unique<std::atomic<double>[]>(initial.size());
+    for (size_t i = 0; i < initial.size(); ++i)
+    {
+        set->registers[i].store(initial[i], std::memory_order_relaxed);
+    }
+    set->stack.resize(set->program.stackDepth());
+
+    // Carry edge state across recompiles so editing one device does not re-fire every rule.
+    if (const auto previous = std::atomic_load(&rules_))
+    {
+        std::lock_guard<std::mutex> lock(previous->mutex);
+        for (auto &rule : set->rules)
         {
-            device.inputs[mapping.name] = 0.0;
+            for (const auto &old : previous->rules)
+            {
+                if (old.target == rule.target && old.signal == rule.signal && old.source == rule.source)
+                {
+                    rule.lastWhen = old.lastWhen;
+                    rule.fired = old.fired;
+                    break;
+                }
+            }
         }
     }
+    std::atomic_store(&rules_, set->rules.empty() ? nullptr : set);
+}
+
+std::vector<IOSignalService::RuleStatus> IOSignalService::rules() const
+{
+    std::vector<RuleStatus> statuses;
+    const auto set = std::atomic_load(&rules_);
+    if (!set)
+    {
+        return statuses;
+    }
+    std::lock_guard<std::mutex> lock(set->mutex);
+    for (const auto &rule : set->rules)
+    {
+        RuleStatus status;
+        status.device = rule.device;
+        status.signal = rule.signal;
+        status.rule = rule.source;
+        status.active = rule.error.empty();
+        status.error = rule.error;
+        status.fired = rule.fired;
+        statuses.push_back(std::move(status));
+    }
+    return statuses;
+}
+
+void IOSignalService::setHistoryBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(historyBudgetMutex_);
+    historyBudget_ = bytes;
+}
+
+// Replaces the device's history for its current layout, shrinking every
+// depth by the same factor when the request does not fit the remaining budget.
+void IOSignalService::allocateHistory(DeviceSignals &device)
+{
+    const auto &mappings = device.layout->mappings;
+    std::vector<uint32_t> depths(mappings.size());
+    size_t requested = 0;
+    for (size_t i = 0; i < mappings.size(); ++i)
+    {
+        depths[i] = mappings[i].historyDepth > 0 ? mappings[i].historyDepth : kDefaultHistoryDepth;
+        requested += depths[i] * sizeof(HistorySample);
+    }
+
+    std::lock_guard<std::mutex> budgetLock(historyBudgetMutex_);
+    std::lock_guard<std::mutex> historyLock(device.historyMutex);
+    historyBytes_ -= device.history.bytes();
+    const size_t available = historyBudget_ > historyBytes_ ? historyBudget_ - historyBytes_ : 0;
+    if (requested > available)
+    {
+        const double factor = static_cast<double>(available) / static_cast<double>(requested);
+        for (auto &depth : depths)
+        {
+            depth = static_cast<uint32_t>(depth * factor);
+        }
+    }
+    device.history.reset(depths);
+    historyBytes_ += device.history.bytes();
 }
 
 std::vector<SignalMapping> IOSignalService::mappings(const std::string &deviceName)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = devices_.find(deviceName);
-    if (it == devices_.end())
+    auto device = find(deviceName);
+    if (!device)
     {
         return {};
     }
-    return it->second.mappings;
+    std::lock_guard<std::mutex> lock(device->readMutex);
+    return device->layout->mappings;
+}
+
+std::optional<IOSignalService::SignalHandle> IOSignalService::resolveHandle(const std::string &deviceName,
+                                                                          const std::string &signalName) const
+{
+    auto device = find(deviceName);
+    if (!device)
+    {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(device->readMutex);
+    const auto &handles = device->layout->handles;
+    auto handle = handles.find(signalName);
+    if (handle == handles.end())
+    {
+        return std::nullopt;
+    }
+    return handle->second;
 }
 
 std::vector<SignalValue> IOSignalService::snapshot(const std::string &deviceName)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<SignalValue> values;
-    auto it = devices_.find(deviceName);
-    if (it == devices_.end())
+    auto device = find(deviceName);
+    if (!device)
     {
         return values;
     }
 
-    values.reserve(it->second.mappings.size());
-    for (const auto &mapping : it->second.mappings)
+    std::shared_ptr<const SignalLayout> layout;
+    std::vector<double> inputs;
+    std::vector<double> outputs;
+    std::vector<uint8_t> inputBytes;
+    std::vector<uint8_t> outputBytes;
     {
-        SignalValue value;
-        value.mapping = mapping;
-        if (mapping.direction == SignalDirection::Output)
-        {
-            value.engineeringValue = it->second.outputs[mapping.name];
-        }
-        else
-        {
-            value.engineeringValue = it->second.inputs[mapping.name];
-        }
-        value.rawValue = mapping.scale != 0 ? (value.engineeringValue - mapping.engineeringOffset) / mapping.scale
-                                             : value.engineeringValue;
-        values.push_back(value);
+        std::lock_guard<std::mutex> lock(device->readMutex);
+        layout = device->layout;
+        const auto &input = device->inputFrames.acquire();
+        const auto &output = device->outputFrames.acquire();
+        inputs = input.values;
+        outputs = output.values;
+        inputBytes = input.bytes.toVector();
+        outputBytes = output.bytes.toVector();
+    }
+
+    const auto &mappings = layout->mappings;
+    values.reserve(mappings.size());
+    for (size_t i = 0; i < mappings.size(); ++i)
+    {
+        const bool output = mappings[i].direction == SignalDirection::Output;
+        const auto &bytes = output ? outputBytes : inputBytes;
+        values.push_back(makeValue(mappings[i], static_cast<SignalHandle>(i), output ? outputs[i] : inputs[i],
+                                   bytes.data(), bytes.size()));
     }
     return values;
 }
 
+std::optional<SignalValue> IOSignalService::snapshot(const std::string &deviceName, SignalHandle handle) const
+{
+    auto device = find(deviceName);
+    if (!device)
+    {
+        return std::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(device->readMutex);
+    const auto &mappings = device->layout->mappings;
+    if (handle >= mappings.size())
+    {
+        return std::nullopt;
+    }
+    const auto &frame = mappings[handle].direction == SignalDirection::Output ? device->outputFrames.acquire()
+                                                                              : device->inputFrames.acquire();
+    return makeValue(mappings[handle], handle, frame.values[handle], frame.bytes.data(), frame.bytes.size());
+}
+
 std::optional<IOSignalService::AssemblyData> IOSignalService::assemblies(const std::string &deviceName) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = devices_.find(deviceName);
-    if (it == devices_.end())
+    auto device = find(deviceName);
+    if (!device)
     {
         return std::nullopt;
     }
 
+    std::lock_guard<std::mutex> lock(device->readMutex);
+    const auto &input = device->inputFrames.acquire();
+    const auto &output = device->outputFrames.acquire();
     AssemblyData data;
-    data.input = it->second.lastInput;
-    data.output = it->second.lastOutput;
+    data.input = input.bytes.toVector();
+    data.output = output.bytes.toVector();
+    data.inputVersion = input.version;
+    data.outputVersion = output.version;
     return data;
 }
 
+std::optional<IOSignalService::ChangeSet> IOSignalService::changes(const std::string &deviceName, uint64_t since) const
+{
+    auto device = find(deviceName);
+    if (!device)
+    {
+        return std::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(device->readMutex);
+    const auto &mappings = device->layout->mappings;
+    const auto &frame = device->inputFrames.acquire();
+    ChangeSet changes;
+    changes.version = frame.changeVersion;
+    for (size_t i = 0; i < frame.changedAt.size(); ++i)
+    {
+        if (frame.changedAt[i] > since && mappings[i].direction == SignalDirection::Input)
+        {
+            changes.values.push_back(makeValue(mappings[i], static_cast<SignalHandle>(i), frame.values[i], frame.bytes.data(),
+                                                 frame.bytes.size()));
+        }
+    }
+    return changes;
+}
+
+std::optional<std::vector<HistorySample>> IOSignalService::history(const std::string &deviceName,
+                                                                   SignalHandle handle,
+                                                                   int64_t fromUs,
+                                                                   int64_t toUs) const
+{
+    auto device = find(deviceName);
+    if (!device)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<HistorySample> samples;
+    std::lock_guard<std::mutex> lock(device->historyMutex);
+    if (handle >= device->history.size())
+    {
+        return std::nullopt;
+    }
+    samples.reserve(device->history.depth(handle));
+    device->history.range(handle, fromUs, toUs, samples);
+    return samples;
+}
+
 bool IOSignalService::applyOutputBytes(const std::string &deviceName, const std::vector<uint8_t> &bytes)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = devices_.find(deviceName);
-    if (it == devices_.end())
+    auto device = find(deviceName);
+    if (!device)
     {
         return false;
     }
 
-    it->second.lastOutput = bytes;
-    for (const auto &mapping : it->second.mappings)
+    std::lock_guard<std::mutex> lock(device->mutex);
+    auto &frame = device->outputFrame;
+    const auto size = device->outputBytes > 0 ? device->outputBytes : std::max(device->layout->outputExtent, bytes.size());
+    frame.assign(bytes.data(), bytes.size());
+    frame.resize(size);
+    const auto &mappings = device->layout->mappings;
+    const auto now = nowUs();
+    std::lock_guard<std::mutex> historyLock(device->historyMutex);
+    for (size_t i = 0; i < mappings.size(); ++i)
     {
-        if (mapping.direction == SignalDirection::Output)
+        if (mappings[i].direction != SignalDirection::Output)
         {
-            it->second.outputs[mapping.name] = decodeValue(mapping, bytes);
+            continue;
+        }
+        const double value = decodeValue(mappings[i], frame.data(), frame.size());
+        if (value != device->outputValues[i])
+        {
+            device->outputValues[i] = value;
+            device->history.record(i, now, value);
         }
     }
+    // The raw bytes are authoritative now; pending re-encodes would overwrite them.
+    clearDirty(*device);
+    publishOutputs(*device);
     return true;
 }
 
 bool IOSignalService::setOutputValue(const std::string &deviceName, const std::string &signalName, double engineeringValue)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = devices_.find(deviceName);
-    if (it == devices_.end())
+    auto device = find(deviceName);
+    if (!device)
     {
         return false;
     }
 
-    for (const auto &mapping : it->second.mappings)
+    std::lock_guard<std::mutex> lock(device->mutex);
+    const auto &layout = *device->layout;
+    auto handle = layout.handles.find(signalName);
+    if (handle == layout.handles.end() || layout.mappings[handle->second].direction != SignalDirection::Output ||
+        layout.mappings[handle->second].type == SignalType::String || layout.mappings[handle->second].generator)
     {
-        if (mapping.name == signalName && mapping.direction == SignalDirection::Output)
-        {
-            it->second.outputs[signalName] = engineeringValue;
-            return true;
-        }
+        return false;
+    }
+    if (device->outputValues[handle->second] != engineeringValue)
+    {
+        device->outputValues[handle->second] = engineeringValue;
+        markDirty(*device, handle->second);
+        publishOutputs(*device);
+    }
+    return true;
+}
+
+bool IOSignalService::setOutputValue(const std::string &deviceName, SignalHandle handle, double engineeringValue)
+{
+    auto device = find(deviceName);
+    if (!device)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(device->mutex);
+    const auto &mappings = device->layout->mappings;
+    if (handle >= mappings.size() || mappings[handle].direction != SignalDirection::Output ||
+        mappings[handle].type == SignalType::String || mappings[handle].generator)
+    {
+        return false;
+    }
+    if (device->outputValues[handle] != engineeringValue)
+    {
+        device->outputValues[handle] = engineeringValue;
+        markDirty(*device, handle);
+        publishOutputs(*device);
     }
-    return false;
+    return true;
 }
 
 void IOSignalService::consumeInputBytes(const std::string &deviceName, const std::vector<uint8_t> &data)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto &device = devices_[deviceName];
-    device.lastInput = data;
-    for (const auto &mapping : device.mappings)
+    consumeInputBytes(attach(deviceName), data);
+}
+
+void IOSignalService::fillOutputBytes(const std::string &deviceName, std::vector<uint8_t> &buffer)
+{
+    fillOutputBytes(attach(deviceName), buffer);
+}
+
+void IOSignalService::consumeInputBytes(const DeviceRef &device, const std::vector<uint8_t> &data)
+{
+    const auto rules = std::atomic_load(&rules_);
+    const RuleSet::Source *source = nullptr;
+    if (rules)
     {
-        if (mapping.direction == SignalDirection::Input)
+        const auto it = rules->sources.find(device.get());
+        source = it == rules->sources.end() ? nullptr : &it->second;
+    }
+    {
+        std::lock_guard<std::mutex> lock(device->mutex);
+        auto &frame = device->inputFrames.back();
+        frame.version = ++device->inputVersion;
+        frame.bytes.assign(data.data(), data.size());
+        device->layout->inputPlan.run(data.data(), data.size(), frame.values.data());
+        detectChanges(*device, frame);
+        if (!frame.changes.empty())
         {
-            device.inputs[mapping.name] = decodeValue(mapping, data);
+            recordHistory(*device, frame.changes, frame.values.data());
         }
+        if (source && source->layout != device->layout)
+        {
+            // Mappings changed since the rules were compiled; a rebuild is on its way.
+            source = nullptr;
+        }
+        if (source)
+        {
+            for (const auto &[handle, slot] : source->loads)
+            {
+                rules->registers[slot].store(frame.values[handle], std::memory_order_relaxed);
+            }
+        }
+        device->inputFrames.publish();
+    }
+    // Outside the device lock: rules may write this device's outputs too.
+    if (source)
+    {
+        runRules(*rules, source->rules);
     }
 }
 
-void IOSignalService::fillOutputBytes(const std::string &deviceName, std::vector<uint8_t> &buffer)
+void IOSignalService::fillOutputBytes(const DeviceRef &device, std::vector<uint8_t> &buffer)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto &device = devices_[deviceName];
-    for (const auto &mapping : device.mappings)
+    std::lock_guard<std::mutex> lock(device->mutex);
+    if (!device->layout->generators.empty())
+    {
+        runGenerators(*device, generatorElapsedUs());
+    }
+    auto &frame = device->outputFrame;
+    if (!device->dirtyOutputs.empty())
     {
-        if (mapping.direction == SignalDirection::Output)
+        const auto &mappings = device->layout->mappings;
+        for (const auto handle : device->dirtyOutputs)
         {
-            const double eng = device.outputs[mapping.name];
-            encodeValue(mapping, eng, buffer);
+            encodeValue(mappings[handle], device->outputValues[handle], frame.data(), frame.size());
         }
+        recordHistory(*device, device->dirtyOutputs, device->outputValues.data());
+        clearDirty(*device);
+        publishOutputs(*device);
+    }
+    if (buffer.size() != frame.size())
+    {
+        buffer.resize(frame.size());
+    }
+    if (frame.size() > 0)
+    {
+        std::memcpy(buffer.data(), frame.data(), frame.size());
     }
-    device.lastOutput = buffer;
 }
 
 std::string IOSignalService::exportMappingsYaml(const std::string &deviceName) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
     YAML::Node root;
-    auto it = devices_.find(deviceName);
-    if (it == devices_.end())
+    auto device = find(deviceName);
+    if (!device)
     {
         return "";
     }
 
-    for (const auto &mapping : it->second.mappings)
+    std::shared_ptr<const SignalLayout> layout;
+    {
+        std::lock_guard<std::mutex> lock(device->readMutex);
+        layout = device->layout;
+    }
+    for (const auto &mapping : layout->mappings)
     {
         YAML::Node node;
         node["name"] = mapping.name;
         node["direction"] = mapping.direction == SignalDirection::Input ? "input" : "output";
-        switch (mapping.type)
-        {
-        case SignalType::Bool:
-            node["type"] = "bool";
-            break;
-        case SignalType::UInt8:
-            node["type"] = "uint8";
-            break;
-        case SignalType::UInt16:
-            node["type"] = "uint16";
-            break;
-        case SignalType::UInt32:
-            node["type"] = "uint32";
-            break;
-        case SignalType::SInt:
-            node["type"] = "sint";
-            break;
-        case SignalType::Real32:
-            node["type"] = "real32";
-            break;
-        }
+        node["type"] = signalTypeName(mapping.type);
         node["byteOffset"] = mapping.byteOffset;
         if (mapping.bitOffset.has_value())
         {
             node["bitOffset"] = *mapping.bitOffset;
         }
+        if (mapping.type == SignalType::Bits)
+        {
+            node["bitWidth"] = static_cast<unsigned>(mapping.bitWidth);
+        }
+        if (mapping.type == SignalType::String)
+        {
+            node["stringLength"] = mapping.stringLength;
+        }
+        if (mapping.byteOrder == ByteOrder::Big)
+        {
+            node["byteOrder"] = "big";
+        }
         node["scale"] = mapping.scale;
         node["engineeringOffset"] = mapping.engineeringOffset;
         node["units"] = mapping.units;
@@ -251,6 +802,19 @@ std::string IOSignalService::exportMappingsYaml(const std::string &deviceName) c
             }
             node["enums"] = enumsNode;
         }
+        if (mapping.deadbandMode != DeadbandMode::None)
+        {
+            node["deadbandMode"] = mapping.deadbandMode == DeadbandMode::Percent ? "percent" : "absolute";
+            node["deadband"] = mapping.deadband;
+        }
+        if (mapping.historyDepth > 0)
+        {
+            node["historyDepth"] = mapping.historyDepth;
+        }
+        if (mapping.generator.has_value())
+        {
+            node["generator"] = jsonToYaml(mapping.generator->toJson());
+        }
         root.push_back(node);
     }
 
@@ -262,13 +826,13 @@ std::string IOSignalService::exportMappingsYaml(const std::string &deviceName) c
 Json::Value IOSignalService::exportMappingsJson(const std::string &deviceName) const
 {
     Json::Value root(Json::arrayValue);
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = devices_.find(deviceName);
-    if (it == devices_.end())
+    auto device = find(deviceName);
+    if (!device)
     {
         return root;
     }
-    for (const auto &mapping : it->second.mappings)
+    std::lock_guard<std::mutex> lock(device->readMutex);
+    for (const auto &mapping : device->layout->mappings)
     {
         root.append(mapping.toJson());
     }
@@ -288,61 +852,7 @@ std::vector<SignalMapping> IOSignalService::importMappings(const std::string &se
         YAML::Node root = YAML::Load(serialized);
         for (const auto &entry : root)
         {
-            Json::Value json;
-            for (const auto &kv : entry)
-            {
-                const auto key = kv.first.as<std::string>();
-                const auto value = kv.second;
-                if (value.IsScalar())
-                {
-                    try
-                    {
-                        json[key] = value.as<int>();
-                    }
-                    catch (...)
-                    {
-                        try
-                        {
-                            json[key] = value.as<double>();
-                        }
-                        catch (...)
-                        {
-                            json[key] = value.as<std::string>();
-                        }
-                    }
-                }
-                else if (value.IsSequence())
-                {
-                    Json::Value arr(Json::arrayValue);
-                    for (const auto &inner : value)
-                    {
-                        Json::Value obj;
-                        for (const auto &innerKv : inner)
-                        {
-                            const auto innerKey = innerKv.first.as<std::string>();
-                            const auto scalar = innerKv.second;
-                            try
-                            {
-                                obj[innerKey] = scalar.as<int>();
-                            }
-                            catch (...)
-                            {
-                                try
-                                {
-                                    obj[innerKey] = scalar.as<double>();
-                                }
-                                catch (...)
-                                {
-                                    obj[innerKey] = scalar.as<std::string>();
-                                }
-                            }
-                        }
-                        arr.append(obj);
-                    }
-                    json[key] = arr;
-                }
-            }
-            mappings.push_back(SignalMapping::fromJson(json));
+            mappings.push_back(SignalMapping::fromJson(yamlToJson(entry)));
         }
     }
     else
@@ -367,108 +877,263 @@ std::vector<SignalMapping> IOSignalService::importMappings(const std::string &se
     return mappings;
 }
 
-double IOSignalService::decodeValue(const SignalMapping &mapping, const std::vector<uint8_t> &data)
+// Sizes the output frame and every published frame for the current layout and
+// connection. Callers hold both device locks. Unconfigured devices get room
+// for a standard Forward Open so inputs can arrive before a connection exists.
+void IOSignalService::resizeBuffers(DeviceSignals &device, bool layoutChanged)
 {
-    const auto offset = mapping.byteOffset;
-    switch (mapping.type)
-    {
-    case SignalType::Bool:
+    const auto extent = device.layout->outputExtent;
+    const size_t inputCapacity = device.inputBytes > 0 ? device.inputBytes : kForwardOpenMaxBytes;
+    const size_t outputCapacity = device.outputBytes > 0 ? device.outputBytes : std::max<size_t>(extent, kForwardOpenMaxBytes);
+    const size_t outputSize = device.outputBytes > 0 ? device.outputBytes : extent;
+
+    AssemblyBuffer output(outputCapacity);
+    output.assign(device.outputFrame.data(), device.outputFrame.size());
+    output.resize(outputSize);
+    device.outputFrame = std::move(output);
+    encodeOutputs(device);
+
+    const auto count = device.layout->mappings.size();
+    auto reset = [&](TripleBuffer<SignalFrame> &frames, size_t capacity, const AssemblyBuffer *bytes) {
+        const auto latest = frames.acquire();
+        frames.reset([&](SignalFrame &frame) {
+            frame.version = latest.version;
+            if (layoutChanged || latest.values.size() != count)
+            {
+                frame.values.assign(count, 0.0);
+            }
+            else
+            {
+                frame.values = latest.values;
+            }
+            frame.bytes.reserve(capacity);
+            const auto &source = bytes ? *bytes : latest.bytes;
+            frame.bytes.assign(source.data(), source.size());
+            frame.changes.clear();
+            if (!bytes)
+            {
+                // Input frames carry the change state.
+                frame.changeVersion = device.changeVersion;
+                frame.changedAt = device.changedAt;
+                frame.changes.reserve(count);
+            }
+        });
+    };
+    reset(device.inputFrames, inputCapacity, nullptr);
+    reset(device.outputFrames, outputCapacity, &device.outputFrame);
+}
+
+void IOSignalService::encodeOutputs(DeviceSignals &device)
+{
+    const auto &mappings = device.layout->mappings;
+    for (size_t i = 0; i < mappings.size(); ++i)
     {
-        if (offset >= data.size())
+        if (mappings[i].direction == SignalDirection::Output)
         {
-            return 0.0;
+            encodeValue(mappings[i], device.outputValues[i], device.outputFrame.data(), device.outputFrame.size());
         }
-        uint8_t byte = data[offset];
-        if (mapping.bitOffset.has_value())
+    }
+    clearDirty(device);
+}
+
+void IOSignalService::markDirty(DeviceSignals &device, SignalHandle handle)
+{
+    if (!device.outputDirty[handle])
+    {
+        device.outputDirty[handle] = 1;
+        device.dirtyOutputs.push_back(handle);
+    }
+}
+
+void IOSignalService::clearDirty(DeviceSignals &device)
+{
+    for (const auto handle : device.dirtyOutputs)
+    {
+        device.outputDirty[handle] = 0;
+    }
+    device.dirtyOutputs.clear();
+}
+
+void IOSignalService::publishOutputs(DeviceSignals &device)
+{
+    auto &frame = device.outputFrames.back();
+    frame.version = ++device.outputVersion;
+    frame.values.assign(device.outputValues.begin(), device.outputValues.end());
+    frame.bytes.assign(device.outputFrame.data(), device.outputFrame.size());
+    device.outputFrames.publish();
+}
+
+// Evaluates every generator of the layout at one instant and marks the outputs
+// that moved. Called on the send path with the device mutex held; never allocates.
+void IOSignalService::runGenerators(DeviceSignals &device, int64_t elapsedUs)
+{
+    const auto &generators = device.layout->generators;
+    for (size_t i = 0; i < generators.size(); ++i)
+    {
+        const auto &generator = generators[i].generator;
+        double value;
+        if (generator.type == GeneratorType::RandomWalk)
         {
-            const uint8_t bit = *mapping.bitOffset;
-            if (bit < 8)
+            auto &walk = device.walks[i];
+            const auto step = elapsedUs / generator.cycleUs();
+            walk.step = std::max(walk.step, step - kMaxWalkCatchUp);
+            for (; walk.step < step; ++walk.step)
             {
-                byte = (byte >> bit) & 0x01;
+                const double unit = static_cast<double>(nextRandom(walk.rng) >> 11) / static_cast<double>(1ull << 53);
+                walk.value = std::clamp(walk.value + (2.0 * unit - 1.0) * generator.stepSize, generator.low, generator.high);
             }
+            value = walk.value;
         }
-        return byte ? 1.0 : 0.0;
-    }
-    case SignalType::UInt8:
-        return offset < data.size() ? static_cast<double>(data[offset]) * mapping.scale + mapping.engineeringOffset : 0.0;
-    case SignalType::UInt16:
-        return (offset + 1 < data.size())
-                   ? static_cast<double>(readLE16(data, offset)) * mapping.scale + mapping.engineeringOffset
-                   : 0.0;
-    case SignalType::UInt32:
-        return (offset + 3 < data.size())
-                   ? static_cast<double>(readLE32(data, offset)) * mapping.scale + mapping.engineeringOffset
-                   : 0.0;
-    case SignalType::SInt:
-        return offset < data.size()
-                   ? static_cast<double>(static_cast<int8_t>(data[offset])) * mapping.scale + mapping.engineeringOffset
-                   : 0.0;
-    case SignalType::Real32:
-        if (offset + 3 >= data.size())
+        else
+        {
+            value = generator.valueAt(elapsedUs);
+        }
+
+        const auto slot = generators[i].slot;
+        if (device.outputValues[slot] != value)
         {
-            return 0.0;
+            device.outputValues[slot] = value;
+            markDirty(device, slot);
         }
-        float realVal = 0.0f;
-        std::memcpy(&realVal, data.data() + offset, sizeof(float));
-        return static_cast<double>(realVal) * mapping.scale + mapping.engineeringOffset;
     }
-    return 0.0;
 }
 
-void IOSignalService::encodeValue(const SignalMapping &mapping, double engineeringValue, std::vector<uint8_t> &buffer)
+// Evaluates the rules a packet triggered and writes their outputs, which go
+// out with each target's next O->T frame. A device's rules are compiled next
+// to each other, so each target is locked and published once. Never allocates.
+void IOSignalService::runRules(RuleSet &rules, const std::vector<uint32_t> &triggered)
 {
-    const double raw = mapping.scale != 0.0 ? (engineeringValue - mapping.engineeringOffset) / mapping.scale : engineeringValue;
-    const auto offset = mapping.byteOffset;
-    if (buffer.size() < offset + mapping.widthBytes())
-    {
-        buffer.resize(offset + mapping.widthBytes(), 0);
-    }
-    switch (mapping.type)
-    {
-    case SignalType::Bool:
+    std::lock_guard<std::mutex> lock(rules.mutex);
+    DeviceSignals *target = nullptr;
+    std::unique_lock<std::mutex> targetLock;
+    bool changed = false;
+    auto release = [&]() {
+        if (changed)
+        {
+            publishOutputs(*target);
+            changed = false;
+        }
+        if (targetLock.owns_lock())
+        {
+            targetLock.unlock();
+        }
+    };
+
+    for (const auto index : triggered)
     {
-        uint8_t byte = buffer[offset];
-        const bool set = std::fabs(raw) >= 0.5;
-        if (mapping.bitOffset.has_value())
+        auto &rule = rules.rules[index];
+        const bool edge = !rule.source.when.empty();
+        if (edge)
         {
-            const uint8_t bit = *mapping.bitOffset;
-            if (bit < 8)
+            const bool active = rules.program.run(rule.when, rules.registers.get(), rules.stack.data()) != 0.0;
+            const bool rising = active && !rule.lastWhen;
+            rule.lastWhen = active;
+            if (!rising)
             {
-                if (set)
-                {
-                    byte |= static_cast<uint8_t>(1u << bit);
-                }
-                else
-                {
-                    byte &= static_cast<uint8_t>(~(1u << bit));
-                }
-                buffer[offset] = byte;
+                continue;
             }
         }
-        else
+        const double value = rules.program.run(rule.value, rules.registers.get(), rules.stack.data());
+        if (!std::isfinite(value))
         {
-            buffer[offset] = set ? 1 : 0;
+            continue;
+        }
+
+        if (rule.target.get() != target)
+        {
+            release();
+            target = rule.target.get();
+            targetLock = std::unique_lock<std::mutex>(target->mutex);
+        }
+        if (target->layout != rule.layout)
+        {
+            continue;
+        }
+        if (target->outputValues[rule.slot] != value)
+        {
+            target->outputValues[rule.slot] = value;
+            markDirty(*target, rule.slot);
+            changed = true;
+            rule.fired++;
+        }
+        else if (edge)
+        {
+            rule.fired++;
         }
-        break;
     }
-    case SignalType::UInt8:
-        buffer[offset] = static_cast<uint8_t>(std::clamp(raw, 0.0, 255.0));
-        break;
-    case SignalType::UInt16:
-        writeLE16(static_cast<uint16_t>(std::clamp(raw, 0.0, 65535.0)), buffer, offset);
-        break;
-    case SignalType::UInt32:
-        writeLE32(static_cast<uint32_t>(std::max(0.0, raw)), buffer, offset);
-        break;
-    case SignalType::SInt:
-        buffer[offset] = static_cast<uint8_t>(static_cast<int8_t>(std::round(raw)));
-        break;
-    case SignalType::Real32:
+    release();
+}
+
+// Compares a freshly decoded input frame against the last reported values and
+// records the handles that moved past their deadband. Called on the I/O path
+// with the device mutex held; never allocates.
+void IOSignalService::detectChanges(DeviceSignals &device, SignalFrame &frame)
+{
+    frame.changes.clear();
+    for (const auto &filter : device.layout->inputFilters)
     {
-        float real = static_cast<float>(raw);
-        std::memcpy(buffer.data() + offset, &real, sizeof(float));
-        break;
+        const double value = frame.values[filter.slot];
+        if (exceedsDeadband(filter.mode, filter.band, device.reportedInputs[filter.slot], value))
+        {
+            device.reportedInputs[filter.slot] = value;
+            frame.changes.push_back(filter.slot);
+        }
     }
+    if (!frame.changes.empty())
+    {
+        ++device.changeVersion;
+        for (const auto handle : frame.changes)
+        {
+            device.changedAt[handle] = device.changeVersion;
+        }
+    }
+    if (frame.changeVersion != device.changeVersion)
+    {
+        frame.changedAt.assign(device.changedAt.begin(), device.changedAt.end());
+        frame.changeVersion = device.changeVersion;
+    }
+}
+
+void IOSignalService::recordHistory(DeviceSignals &device, const std::vector<SignalHandle> &handles, const double *values)
+{
+    const auto now = nowUs();
+    std::lock_guard<std::mutex> lock(device.historyMutex);
+    for (const auto handle : handles)
+    {
+        device.history.record(handle, now, values[handle]);
+    }
+}
+
+SignalValue IOSignalService::makeValue(const SignalMapping &mapping,
+                                       SignalHandle handle,
+                                       double engineeringValue,
+                                       const uint8_t *bytes,
+                                       size_t size)
+{
+    SignalValue value;
+    value.mapping = mapping;
+    value.handle = handle;
+    value.engineeringValue = engineeringValue;
+    if (mapping.type == SignalType::String && mapping.byteOffset + mapping.widthBytes() <= size)
+    {
+        value.textValue = SignalCodec::decodeText(bytes + mapping.byteOffset, mapping.stringLength);
     }
+    value.rawValue = mapping.scale != 0 ? (engineeringValue - mapping.engineeringOffset) / mapping.scale : engineeringValue;
+    return value;
 }
 
+double IOSignalService::decodeValue(const SignalMapping &mapping, const uint8_t *data, size_t size)
+{
+    if (mapping.byteOffset + mapping.widthBytes() > size)
+    {
+        return 0.0;
+    }
+    return SignalCodec::decodeRaw(mapping, data, size) * mapping.scale + mapping.engineeringOffset;
+}
+
+void IOSignalService::encodeValue(const SignalMapping &mapping, double engineeringValue, uint8_t *buffer, size_t size)
+{
+    const double raw = mapping.scale != 0.0 ? (engineeringValue - mapping.engineeringOffset) / mapping.scale : engineeringValue;
+    // Signals outside the assembly are never sent.
+    SignalCodec::encodeRaw(mapping, raw, buffer, size);
+}
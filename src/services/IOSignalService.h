@@ -1,48 +1,263 @@
 #pragma once
 
 #include "models/Device.h"
-#include "models/SignalMapping.h"
+#include "models/SignalCodec.h"
+#include "AssemblyBuffer.h"
+#include "RuleProgram.h"
+#include "SignalHistory.h"
+#include "SignalPlan.h"
+#include "TripleBuffer.h"
+#include <chrono>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <unordered_map>
 #include <yaml-cpp/yaml.h>
 
+// History depth for mappings that do not set one, and the cap on history
+// memory across all devices. Devices that would exceed the cap get
+// proportionally shallower histories.
+constexpr uint32_t kDefaultHistoryDepth = 600;
+constexpr size_t kDefaultHistoryBudgetBytes = 16 * 1024 * 1024;
+
 class IOSignalService
 {
 public:
+    // Handles are positions in the applied mapping list and stay valid until
+    // a different mapping list is applied to the device.
+    using SignalHandle = uint32_t;
+
+    // Per-device signal state with its own lock. Connections keep a reference
+    // so the I/O path never touches the service-level device map.
+    struct DeviceSignals;
+    using DeviceRef = std::shared_ptr<DeviceSignals>;
+
+    DeviceRef attach(const std::string &deviceName);
+    // Preallocates the device's frame buffers for a connection's assembly sizes.
+    void configureAssemblies(const DeviceRef &device, const ConnectionConfig &config);
     void applyMappings(const std::string &deviceName, const std::vector<SignalMapping> &mappings);
+    // Drops the device, its history budget and the rules on its outputs. References
+    // still held keep working but are no longer reachable by name.
+    void forget(const std::string &deviceName);
     std::vector<SignalMapping> mappings(const std::string &deviceName);
+    std::optional<SignalHandle> resolveHandle(const std::string &deviceName, const std::string &signalName) const;
     std::vector<SignalValue> snapshot(const std::string &deviceName);
+    std::optional<SignalValue> snapshot(const std::string &deviceName, SignalHandle handle) const;
     struct AssemblyData
     {
         std::vector<uint8_t> input;
         std::vector<uint8_t> output;
+        uint64_t inputVersion{0};
+        uint64_t outputVersion{0};
     };
     std::optional<AssemblyData> assemblies(const std::string &deviceName) const;
+    // Inputs whose last reported change is newer than `since`. Every packet that
+    // moves at least one input past its deadband advances `version` by one.
+    struct ChangeSet
+    {
+        uint64_t version{0};
+        std::vector<SignalValue> values;
+    };
+    std::optional<ChangeSet> changes(const std::string &deviceName, uint64_t since) const;
+    // Recorded samples of one signal between two wall-clock times, oldest first.
+    std::optional<std::vector<HistorySample>> history(const std::string &deviceName,
+                                                      SignalHandle handle,
+                                                      int64_t fromUs,
+                                                      int64_t toUs) const;
+    // Applies to histories allocated after the call.
+    void setHistoryBudget(size_t bytes);
     bool applyOutputBytes(const std::string &deviceName, const std::vector<uint8_t> &bytes);
+    // Outputs driven by a generator are not writable.
     bool setOutputValue(const std::string &deviceName, const std::string &signalName, double engineeringValue);
+    bool setOutputValue(const std::string &deviceName, SignalHandle handle, double engineeringValue);
     void consumeInputBytes(const std::string &deviceName, const std::vector<uint8_t> &data);
     void fillOutputBytes(const std::string &deviceName, std::vector<uint8_t> &buffer);
+    void consumeInputBytes(const DeviceRef &device, const std::vector<uint8_t> &data);
+    void fillOutputBytes(const DeviceRef &device, std::vector<uint8_t> &buffer);
+
+    // Output rules of every device as last compiled; rules whose references do
+    // not resolve yet are listed inactive with the reason.
+    struct RuleStatus
+    {
+        std::string device;
+        std::string signal;
+        SignalRule rule;
+        bool active{false};
+        std::string error;
+        uint64_t fired{0};
+
+        Json::Value toJson() const
+        {
+            Json::Value value;
+            value["device"] = device;
+            value["signal"] = signal;
+            value["rule"] = rule.toJson();
+            value["active"] = active;
+            if (!error.empty())
+            {
+                value["error"] = error;
+            }
+            value["fired"] = static_cast<Json::UInt64>(fired);
+            return value;
+        }
+    };
+    std::vector<RuleStatus> rules() const;
 
     std::string exportMappingsYaml(const std::string &deviceName) const;
     Json::Value exportMappingsJson(const std::string &deviceName) const;
     std::vector<SignalMapping> importMappings(const std::string &serialized, bool yaml);
 
 private:
-    struct DeviceSignals
+    // Guards the device map only; lookups share it, attach takes it exclusively.
+    mutable std::shared_mutex mutex_;
+    std::map<std::string, DeviceRef> devices_;
+
+    std::mutex historyBudgetMutex_;
+    size_t historyBudget_{kDefaultHistoryBudgetBytes};
+    size_t historyBytes_{0};
+    struct RuleSet;
+    // Replaced whole by rebuildRules; I/O threads take it with std::atomic_load.
+    std::shared_ptr<RuleSet> rules_;
+    std::mutex rulesBuildMutex_;
+    // Every generator's phase counts from here, so equal waveforms stay in step across devices.
+    const std::chrono::steady_clock::time_point generatorEpoch_{std::chrono::steady_clock::now()};
+
+    struct ChangeFilter
+    {
+        SignalHandle slot;
+        DeadbandMode mode;
+        double band;
+    };
+
+    struct OutputGenerator
+    {
+        SignalHandle slot;
+        SignalGenerator generator;
+    };
+
+    // Where a random walk is: steps taken since the generator epoch, its value
+    // and its xorshift state.
+    struct WalkState
+    {
+        int64_t step{0};
+        double value{0.0};
+        uint64_t rng{0};
+    };
+
+    struct SignalLayout
     {
         std::vector<SignalMapping> mappings;
-        std::map<std::string, double> outputs;
-        std::map<std::string, double> inputs;
-        std::vector<uint8_t> lastInput;
-        std::vector<uint8_t> lastOutput;
+        std::unordered_map<std::string, SignalHandle> handles;
+        SignalDecodePlan inputPlan;
+        std::vector<ChangeFilter> inputFilters;
+        std::vector<OutputGenerator> generators;
+        size_t outputExtent{0};
     };
 
-    mutable std::mutex mutex_;
-    std::map<std::string, DeviceSignals> devices_;
+    // A published copy of one direction's values and assembly bytes. Input
+    // frames also carry the handles that changed in their packet and the
+    // change version at which each signal last changed.
+    struct SignalFrame
+    {
+        uint64_t version{0};
+        std::vector<double> values;
+        AssemblyBuffer bytes;
+        uint64_t changeVersion{0};
+        std::vector<uint64_t> changedAt;
+        std::vector<SignalHandle> changes;
+    };
+
+    DeviceRef find(const std::string &deviceName) const;
+    void rebuildRules();
+    static void runRules(RuleSet &rules, const std::vector<uint32_t> &triggered);
+    int64_t generatorElapsedUs() const;
+    void allocateHistory(DeviceSignals &device);
+    static void resizeBuffers(DeviceSignals &device, bool layoutChanged);
+    static void encodeOutputs(DeviceSignals &device);
+    static void markDirty(DeviceSignals &device, SignalHandle handle);
+    static void clearDirty(DeviceSignals &device);
+    static void publishOutputs(DeviceSignals &device);
+    static void runGenerators(DeviceSignals &device, int64_t elapsedUs);
+    static void detectChanges(DeviceSignals &device, SignalFrame &frame);
+    static void recordHistory(DeviceSignals &device, const std::vector<SignalHandle> &handles, const double *values);
+    static SignalValue makeValue(const SignalMapping &mapping,
+                                 SignalHandle handle,
+                                 double engineeringValue,
+                                 const uint8_t *bytes,
+                                 size_t size);
+    static double decodeValue(const SignalMapping &mapping, const uint8_t *data, size_t size);
+    static void encodeValue(const SignalMapping &mapping, double engineeringValue, uint8_t *buffer, size_t size);
+};
+
+// The I/O path and output writers hold `mutex`; HTTP readers only take
+// `readMutex` and copy the latest published frames, so a slow reader never
+// delays packet handling. The layout is swapped under both.
+struct IOSignalService::DeviceSignals
+{
+    mutable std::mutex mutex;
+    mutable std::mutex readMutex;
+    std::shared_ptr<const SignalLayout> layout{std::make_shared<SignalLayout>()};
+    // Assembly sizes from the connection; zero until a connection is configured.
+    size_t inputBytes{0};
+    size_t outputBytes{0};
+    std::vector<double> outputValues;
+    // Encoded O->T frame. Only outputs listed in dirtyOutputs are re-encoded
+    // before the next send; otherwise sending is a plain copy.
+    AssemblyBuffer outputFrame;
+    std::vector<uint8_t> outputDirty;
+    std::vector<SignalHandle> dirtyOutputs;
+    // One per layout generator; only random walks use theirs.
+    std::vector<WalkState> walks;
+    uint64_t inputVersion{0};
+    uint64_t outputVersion{0};
+    // Last value reported per input, for deadband comparison.
+    std::vector<double> reportedInputs;
+    std::vector<uint64_t> changedAt;
+    uint64_t changeVersion{0};
+    // Filled from the I/O path on change; readers hold historyMutex only while copying.
+    mutable std::mutex historyMutex;
+    SignalHistory history;
+    TripleBuffer<SignalFrame> inputFrames;
+    TripleBuffer<SignalFrame> outputFrames;
+};
+
+struct IOSignalService::RuleSet
+{
+    struct Rule
+    {
+        std::string device;
+        std::string signal;
+        SignalRule source;
+        DeviceRef target;
+        // The target's handles are only valid for the layout they were resolved against.
+        std::shared_ptr<const SignalLayout> layout;
+        SignalHandle slot{0};
+        RuleProgram::Entry when;
+        RuleProgram::Entry value;
+        std::string error;
+        bool lastWhen{false};
+        uint64_t fired{0};
+    };
+
+    // Inputs of one device that rules read, and the rules its packets trigger.
+    struct Source
+    {
+        std::shared_ptr<const SignalLayout> layout;
+        std::vector<std::pair<SignalHandle, uint32_t>> loads;
+        std::vector<uint32_t> rules;
+    };
 
-    static double decodeValue(const SignalMapping &mapping, const std::vector<uint8_t> &data);
-    static void encodeValue(const SignalMapping &mapping, double engineeringValue, std::vector<uint8_t> &buffer);
+    RuleProgram program;
+    std::vector<Rule> rules;
+    std::unordered_map<const DeviceSignals *, Source> sources;
+    // Latest value of every referenced input, written by the I/O thread of its device.
+    std::unique_ptr<std::atomic<double>[]> registers;
+    // Evaluation is serialized; rule edge state and the stack are guarded by `mutex`,
+    // which is taken before any device mutex and never while holding one.
+    mutable std::mutex mutex;
+    std::vector<double> stack;
 };
 
 class IOSignalServiceProvider
@@ -0,0 +1,265 @@
+#include "LoadTestService.h"
+
+#include <algorithm>
+#include <future>
+#include <random>
+#include <set>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Originator serials for virtual originators start here; the simulator's own connections use 0x00010001.
+constexpr uint32_t kOriginatorSerialBase = 0x00020000;
+
+struct Sample
+{
+    Clock::time_point at;
+    uint64_t packets{0};
+    uint64_t cpuUs{0};
+};
+} // namespace
+
+LoadTestService::LoadTestService(ConnectionLifecycleService &connections) : connections_(connections)
+{
+}
+
+LoadTestService::~LoadTestService()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
+
+bool LoadTestService::start(const Device &device, const LoadTestSpec &spec, std::string &error)
+{
+    if (!device.connection.has_value())
+    {
+        error = "Device has no connection configuration";
+        return false;
+    }
+    if (!spec.isValid(error))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (report_.state == "running")
+    {
+        error = "A load test is already running";
+        return false;
+    }
+    // The previous run set its final state as its last step, so it is about to exit.
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+
+    report_ = LoadTestReport();
+    report_.state = "running";
+    report_.deviceName = device.name;
+    report_.spec = spec;
+    stopping_ = false;
+    worker_ = std::thread([this, originators = expand(device, spec), spec]() { run(originators, spec); });
+    return true;
+}
+
+bool LoadTestService::stop(std::string &error)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (report_.state != "running")
+        {
+            error = "No load test is running";
+            return false;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    return true;
+}
+
+LoadTestReport LoadTestService::report() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return report_;
+}
+
+std::vector<Device> LoadTestService::expand(const Device &device, const LoadTestSpec &spec)
+{
+    // A random base keeps connection serials from a previous run, which the
+    // target may still hold open, from colliding with this one.
+    thread_local std::mt19937 rng(std::random_device{}());
+    const auto base = std::uniform_int_distribution<uint32_t>(0, 0xFFFE)(rng);
+
+    std::vector<Device> originators;
+    originators.reserve(spec.count);
+    for (uint32_t i = 0; i < spec.count; ++i)
+    {
+        Device originator = device;
+        originator.name = device.name + "#" + std::to_string(i);
+        originator.group.reset();
+        originator.signals.clear();
+        auto &connection = *originator.connection;
+        connection.connectionSerial = static_cast<uint16_t>(1 + (base + i) % 0xFFFF);
+        connection.originatorSerial = kOriginatorSerialBase + i;
+        if (!spec.rpiUs.empty())
+        {
+            connection.rpiUs = spec.rpiUs[i % spec.rpiUs.size()];
+        }
+        originators.push_back(std::move(originator));
+    }
+    return originators;
+}
+
+void LoadTestService::run(std::vector<Device> originators, LoadTestSpec spec)
+{
+    auto sample = [&](size_t opened) {
+        Sample value;
+        value.at = Clock::now();
+        for (size_t i = 0; i < opened; ++i)
+        {
+            if (auto status = connections_.status(originators[i].name))
+            {
+                value.packets += status->packetsSent + status->packetsReceived;
+            }
+        }
+        for (const auto &thread : connections_.ioThreads())
+        {
+            value.cpuUs += thread.cpuTimeUs;
+        }
+        return value;
+    };
+
+    std::set<std::string> connected;
+    size_t opened = 0;
+    while (opened < originators.size())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_)
+            {
+                break;
+            }
+        }
+
+        const auto end = std::min<size_t>(opened + spec.step, originators.size());
+        const std::vector<Device> batch(originators.begin() + opened, originators.begin() + end);
+        LoadTestStep step;
+        std::string error;
+        for (const auto &status : openBatch(batch, spec.parallelism))
+        {
+            if (!status.connected)
+            {
+                step.openFailures++;
+                if (error.empty())
+                {
+                    error = status.lastError;
+                }
+            }
+        }
+        opened = end;
+        step.connections = static_cast<uint32_t>(opened);
+
+        const auto before = sample(opened);
+        const bool interrupted = !hold(std::chrono::milliseconds(spec.holdMs));
+        const auto after = sample(opened);
+
+        for (size_t i = 0; i < opened; ++i)
+        {
+            const auto &name = originators[i].name;
+            const auto status = connections_.status(name);
+            if (status && status->connected)
+            {
+                step.connected++;
+                step.packetsLost += status->encapsulationLost;
+                connected.insert(name);
+            }
+            else if (connected.erase(name) > 0)
+            {
+                step.dropped++;
+                if (error.empty() && status)
+                {
+                    error = status->lastError;
+                }
+            }
+        }
+        const double seconds = std::chrono::duration<double>(after.at - before.at).count();
+        if (seconds > 0.0)
+        {
+            step.packetsPerSecond = static_cast<double>(after.packets - before.packets) / seconds;
+            if (step.connected > 0)
+            {
+                step.cpuPercentPerConnection =
+                    static_cast<double>(after.cpuUs - before.cpuUs) / 1e4 / seconds / step.connected;
+            }
+        }
+
+        const bool clean = step.openFailures == 0 && step.dropped == 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            report_.steps.push_back(step);
+            if (clean)
+            {
+                report_.maxStable = step.connected;
+            }
+            else if (!report_.saturationAt)
+            {
+                report_.saturationAt = step.connections;
+                report_.firstError = error.empty() ? "Connection dropped" : error;
+            }
+        }
+        if (interrupted || (!clean && spec.stopOnDrop))
+        {
+            break;
+        }
+    }
+
+    closeAll(std::vector<Device>(originators.begin(), originators.begin() + opened));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    report_.state = stopping_ ? "stopped" : "finished";
+}
+
+std::vector<ConnectionStatus> LoadTestService::openBatch(const std::vector<Device> &batch, uint32_t parallelism)
+{
+    std::promise<std::vector<ConnectionStatus>> done;
+    auto results = done.get_future();
+    connections_.openAll(batch, parallelism,
+                         [&done](const std::vector<ConnectionStatus> &statuses) { done.set_value(statuses); });
+    return results.get();
+}
+
+void LoadTestService::closeAll(const std::vector<Device> &originators)
+{
+    std::vector<std::string> names;
+    names.reserve(originators.size());
+    for (const auto &originator : originators)
+    {
+        names.push_back(originator.name);
+    }
+
+    std::promise<void> done;
+    auto finished = done.get_future();
+    connections_.closeAll(names, 0, [&done](const std::vector<ConnectionStatus> &) { done.set_value(); });
+    finished.wait();
+
+    // Originators are never reopened, so nothing of them outlives the run.
+    for (const auto &name : names)
+    {
+        std::string error;
+        connections_.forget(name, error);
+    }
+}
+
+bool LoadTestService::hold(std::chrono::milliseconds duration)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return !wake_.wait_for(lock, duration, [this]() { return stopping_; });
+}
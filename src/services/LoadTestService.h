@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ConnectionLifecycleService.h"
+#include "models/LoadTestSpec.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+struct LoadTestStep
+{
+    // Originators opened so far, and how many of them were connected at the end of the step.
+    uint32_t connections{0};
+    uint32_t connected{0};
+    uint32_t openFailures{0};
+    // Connected at the end of an earlier step but not at the end of this one.
+    uint32_t dropped{0};
+    // Gaps in the encapsulation sequence numbers, which count every datagram.
+    uint64_t packetsLost{0};
+    double packetsPerSecond{0.0};
+    // Share of one core the I/O threads spent per connected originator.
+    double cpuPercentPerConnection{0.0};
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["connections"] = connections;
+        value["connected"] = connected;
+        value["openFailures"] = openFailures;
+        value["dropped"] = dropped;
+        value["packetsLost"] = static_cast<Json::UInt64>(packetsLost);
+        value["packetsPerSecond"] = packetsPerSecond;
+        value["cpuPercentPerConnection"] = cpuPercentPerConnection;
+        return value;
+    }
+};
+
+struct LoadTestReport
+{
+    std::string state{"idle"}; // idle, running, finished or stopped
+    std::string deviceName;
+    LoadTestSpec spec;
+    std::vector<LoadTestStep> steps;
+    // Originators opened at the first step that lost one, and connected at the last clean step.
+    std::optional<uint32_t> saturationAt;
+    uint32_t maxStable{0};
+    std::string firstError;
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["state"] = state;
+        value["deviceName"] = deviceName;
+        value["spec"] = spec.toJson();
+        Json::Value items(Json::arrayValue);
+        for (const auto &step : steps)
+        {
+            items.append(step.toJson());
+        }
+        value["steps"] = items;
+        value["saturationAt"] = saturationAt ? Json::Value(*saturationAt) : Json::Value();
+        value["maxStable"] = maxStable;
+        if (!firstError.empty())
+        {
+            value["firstError"] = firstError;
+        }
+        return value;
+    }
+};
+
+// Expands one device into virtual originators, each with its own connection
+// and originator serial, and ramps them up through the connection service
+// step by step, measuring throughput and I/O CPU after each step until the
+// target starts refusing or dropping connections. One test runs at a time.
+class LoadTestService
+{
+public:
+    explicit LoadTestService(ConnectionLifecycleService &connections);
+    ~LoadTestService();
+
+    bool start(const Device &device, const LoadTestSpec &spec, std::string &error);
+    // Ends the ramp after the current step and closes every originator.
+    bool stop(std::string &error);
+    LoadTestReport report() const;
+
+    // Originator i is named "<device>#<i>".
+    static std::vector<Device> expand(const Device &device, const LoadTestSpec &spec);
+
+private:
+    ConnectionLifecycleService &connections_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    LoadTestReport report_;
+    std::thread worker_;
+
+    void run(std::vector<Device> originators, LoadTestSpec spec);
+    std::vector<ConnectionStatus> openBatch(const std::vector<Device> &batch, uint32_t parallelism);
+    void closeAll(const std::vector<Device> &originators);
+    bool hold(std::chrono::milliseconds duration);
+};
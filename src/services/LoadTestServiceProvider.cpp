@@ -0,0 +1,8 @@
+#include "LoadTestServiceProvider.h"
+#include "ConnectionLifecycleServiceProvider.h"
+
+LoadTestService *LoadTestServiceProvider::instance()
+{
+    static LoadTestService service(*ConnectionLifecycleServiceProvider::instance());
+    return &service;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "LoadTestService.h"
+
+class LoadTestServiceProvider
+{
+public:
+    static LoadTestService *instance();
+};
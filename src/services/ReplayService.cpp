@@ -0,0 +1,221 @@
+#include "ReplayService.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <set>
+
+namespace
+{
+constexpr int64_t kNsPerSecond = 1000000000;
+// Sleeps are cut into slices this long so stop() takes effect promptly.
+constexpr int64_t kStopCheckNs = 20000000;
+
+timespec addNs(timespec at, int64_t ns)
+{
+    const int64_t total = at.tv_nsec + ns % kNsPerSecond;
+    at.tv_sec += static_cast<time_t>(ns / kNsPerSecond + total / kNsPerSecond);
+    at.tv_nsec = static_cast<long>(total % kNsPerSecond);
+    return at;
+}
+
+int64_t diffNs(const timespec &later, const timespec &earlier)
+{
+    return static_cast<int64_t>(later.tv_sec - earlier.tv_sec) * kNsPerSecond + (later.tv_nsec - earlier.tv_nsec);
+}
+
+timespec monotonicNow()
+{
+    timespec now{};
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return now;
+}
+} // namespace
+
+ReplayService::ReplayService(IOSignalService &signals, std::shared_ptr<TrafficRecorder> recorder)
+    : signals_(signals), recorder_(std::move(recorder))
+{
+}
+
+ReplayService::~ReplayService()
+{
+    stopping_ = true;
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
+
+bool ReplayService::start(const ReplaySpec &spec, std::string &error)
+{
+    if (!spec.isValid(error))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (report_.state == "running")
+    {
+        error = "A replay is already running";
+        return false;
+    }
+    // The previous run set its final state as its last step, so it is about to exit.
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+
+    uint64_t truncated = 0;
+    auto frames = load(spec, truncated);
+    if (frames.empty())
+    {
+        error = "No recorded " + spec.direction + " frames for " + spec.source;
+        return false;
+    }
+
+    report_ = ReplayReport();
+    report_.state = "running";
+    report_.spec = spec;
+    report_.frames = frames.size();
+    report_.truncated = truncated;
+    stopping_ = false;
+    worker_ = std::thread([this, frames = std::move(frames), spec]() mutable { run(std::move(frames), spec); });
+    return true;
+}
+
+bool ReplayService::stop(std::string &error)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (report_.state != "running")
+    {
+        error = "No replay is running";
+        return false;
+    }
+    stopping_ = true;
+    return true;
+}
+
+ReplayReport ReplayService::report() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return report_;
+}
+
+std::vector<ReplayService::Frame> ReplayService::load(const ReplaySpec &spec, uint64_t &truncated) const
+{
+    const auto direction =
+        spec.direction == "output" ? TrafficRecorder::Direction::Output : TrafficRecorder::Direction::Input;
+    // A device that reconnected while recording has one stream per connection; they replay as one.
+    std::set<uint32_t> streams;
+    std::vector<Frame> frames;
+    uint64_t firstNs = 0;
+    TrafficRecorder::readLogs(
+        recorder_->stats().files,
+        [&](const TrafficRecorder::LoggedStream &stream) {
+            if (stream.name == spec.source)
+            {
+                streams.insert(stream.id);
+            }
+        },
+        [&](const TrafficRecorder::LoggedFrame &logged) {
+            if (logged.direction != direction || streams.count(logged.stream) == 0)
+            {
+                return;
+            }
+            if (frames.empty())
+            {
+                firstNs = logged.timestampNs;
+            }
+            Frame frame;
+            // The wall clock can step backwards between frames; never schedule earlier than the last one.
+            const auto previous = frames.empty() ? 0 : frames.back().offsetNs;
+            frame.offsetNs = std::max(previous, logged.timestampNs - std::min(logged.timestampNs, firstNs));
+            frame.data.assign(logged.data, logged.data + logged.captured);
+            if (logged.captured < logged.length)
+            {
+                frame.data.resize(logged.length, 0);
+                truncated++;
+            }
+            frames.push_back(std::move(frame));
+        });
+    return frames;
+}
+
+void ReplayService::run(std::vector<Frame> frames, ReplaySpec spec)
+{
+    const bool outputs = spec.mode == "outputs";
+    // One loop lasts through the last frame plus the gap before it, so the seam keeps the recorded rhythm.
+    const uint64_t lastGap = frames.size() > 1 ? frames.back().offsetNs - frames[frames.size() - 2].offsetNs : 1000000;
+    const auto loopNs = static_cast<int64_t>(static_cast<double>(frames.back().offsetNs + lastGap) / spec.speed);
+
+    double lateSumUs = 0.0;
+    std::string error;
+    auto base = monotonicNow();
+    bool interrupted = false;
+    while (!interrupted && error.empty())
+    {
+        for (const auto &frame : frames)
+        {
+            const auto due = addNs(base, static_cast<int64_t>(static_cast<double>(frame.offsetNs) / spec.speed));
+            if (!sleepUntil(due))
+            {
+                interrupted = true;
+                break;
+            }
+            const auto lateUs = static_cast<uint64_t>(std::max<int64_t>(diffNs(monotonicNow(), due), 0) / 1000);
+
+            if (outputs)
+            {
+                if (!signals_.applyOutputBytes(spec.target, frame.data))
+                {
+                    error = "Device " + spec.target + " has no signal state";
+                    break;
+                }
+            }
+            else
+            {
+                signals_.consumeInputBytes(spec.target, frame.data);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            report_.applied++;
+            report_.maxLateUs = std::max(report_.maxLateUs, lateUs);
+            lateSumUs += static_cast<double>(lateUs);
+            report_.meanLateUs = lateSumUs / static_cast<double>(report_.applied);
+        }
+        if (interrupted || !error.empty())
+        {
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            report_.loops++;
+        }
+        if (!spec.loop)
+        {
+            break;
+        }
+        base = addNs(base, loopNs);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    report_.error = error;
+    report_.state = !error.empty() ? "failed" : interrupted ? "stopped" : "finished";
+}
+
+bool ReplayService::sleepUntil(const timespec &due) const
+{
+    while (!stopping_.load(std::memory_order_relaxed))
+    {
+        const auto now = monotonicNow();
+        if (diffNs(due, now) <= 0)
+        {
+            return true;
+        }
+        const auto wake = diffNs(due, now) > kStopCheckNs ? addNs(now, kStopCheckNs) : due;
+        // Absolute deadlines: a late wake-up shortens the next sleep instead of shifting every later frame.
+        while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR)
+        {
+        }
+    }
+    return false;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "IOSignalService.h"
+#include "TrafficRecorder.h"
+#include "models/ReplaySpec.h"
+
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct ReplayReport
+{
+    std::string state{"idle"}; // idle, running, finished, stopped or failed
+    ReplaySpec spec;
+    // Frames in the selected stream, and frames applied so far across loops.
+    uint64_t frames{0};
+    uint64_t applied{0};
+    uint64_t loops{0};
+    // Frames recorded past the snap length, replayed zero-padded.
+    uint64_t truncated{0};
+    // How far behind its scheduled time a frame was applied.
+    uint64_t maxLateUs{0};
+    double meanLateUs{0.0};
+    std::string error;
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["state"] = state;
+        value["spec"] = spec.toJson();
+        value["frames"] = static_cast<Json::UInt64>(frames);
+        value["applied"] = static_cast<Json::UInt64>(applied);
+        value["loops"] = static_cast<Json::UInt64>(loops);
+        value["truncated"] = static_cast<Json::UInt64>(truncated);
+        value["maxLateUs"] = static_cast<Json::UInt64>(maxLateUs);
+        value["meanLateUs"] = meanLateUs;
+        if (!error.empty())
+        {
+            value["error"] = error;
+        }
+        return value;
+    }
+};
+
+// Replays one recorded stream from the traffic recorder's logs into a
+// device's output assembly, or into its input decoding, keeping the recorded
+// spacing between frames (divided by the speed factor). A dedicated thread
+// sleeps to each frame's absolute due time on CLOCK_MONOTONIC, so timing
+// errors do not accumulate over a long replay. One replay runs at a time.
+class ReplayService
+{
+public:
+    ReplayService(IOSignalService &signals, std::shared_ptr<TrafficRecorder> recorder);
+    ~ReplayService();
+
+    bool start(const ReplaySpec &spec, std::string &error);
+    bool stop(std::string &error);
+    ReplayReport report() const;
+
+private:
+    struct Frame
+    {
+        // Since the first frame of the stream, at recorded speed.
+        uint64_t offsetNs{0};
+        std::vector<uint8_t> data;
+    };
+
+    IOSignalService &signals_;
+    std::shared_ptr<TrafficRecorder> recorder_;
+    mutable std::mutex mutex_;
+    ReplayReport report_;
+    std::atomic<bool> stopping_{false};
+    std::thread worker_;
+
+    std::vector<Frame> load(const ReplaySpec &spec, uint64_t &truncated) const;
+    void run(std::vector<Frame> frames, ReplaySpec spec);
+    bool sleepUntil(const timespec &due) const;
+};
@@ -0,0 +1,8 @@
+#include "ReplayServiceProvider.h"
+#include "TrafficRecorderProvider.h"
+
+ReplayService *ReplayServiceProvider::instance()
+{
+    static ReplayService service(*IOSignalServiceProvider::instance(), TrafficRecorderProvider::instance());
+    return &service;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "ReplayService.h"
+
+class ReplayServiceProvider
+{
+public:
+    static ReplayService *instance();
+};
@@ -0,0 +1,385 @@
+#include "RuleProgram.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace
+{
+enum class Op : uint8_t
+{
+    Const,
+    Load,
+    Not,
+    Neg,
+    Or,
+    And,
+    Eq,
+    Ne,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Add,
+    Sub,
+    Mul,
+    Div
+};
+
+constexpr uint32_t kMaxOperand = (1u << 24) - 1;
+
+struct BinaryOperator
+{
+    const char *token;
+    Op op;
+    int level;
+};
+
+// Longer tokens first so "<=" is not read as "<".
+constexpr BinaryOperator kBinaryOperators[] = {
+    {"||", Op::Or, 0}, {"&&", Op::And, 1}, {"==", Op::Eq, 2}, {"!=", Op::Ne, 2}, {"<=", Op::Le, 3}, {">=", Op::Ge, 3},
+    {"<", Op::Lt, 3},  {">", Op::Gt, 3},   {"+", Op::Add, 4}, {"-", Op::Sub, 4}, {"*", Op::Mul, 5}, {"/", Op::Div, 5},
+};
+constexpr int kBinaryLevels = 6;
+
+bool isNameStart(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+bool isNameChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_' || c == '.';
+}
+
+double truth(bool value)
+{
+    return value ? 1.0 : 0.0;
+}
+
+// Recursive descent straight to postfix code, tracking the stack depth it needs.
+class Parser
+{
+public:
+    Parser(const std::string &text,
+           const RuleProgram::Resolver &resolve,
+           std::vector<uint32_t> &code,
+           std::vector<double> &constants)
+        : text_(text), resolve_(resolve), code_(code), constants_(constants)
+    {
+    }
+
+    bool parse(size_t &maxDepth, std::string &error)
+    {
+        parseLevel(0);
+        skipSpace();
+        if (error_.empty() && pos_ < text_.size())
+        {
+            fail("unexpected '" + text_.substr(pos_, 1) + "'");
+        }
+        if (error_.empty() && code_.empty())
+        {
+            fail("empty expression");
+        }
+        error = error_;
+        maxDepth = maxDepth_;
+        return error_.empty();
+    }
+
+private:
+    const std::string &text_;
+    const RuleProgram::Resolver &resolve_;
+    std::vector<uint32_t> &code_;
+    std::vector<double> &constants_;
+    size_t pos_{0};
+    size_t depth_{0};
+    size_t maxDepth_{0};
+    std::string error_;
+
+    void fail(const std::string &message)
+    {
+        if (error_.empty())
+        {
+            error_ = message + " at position " + std::to_string(pos_ + 1);
+        }
+    }
+
+    void skipSpace()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])) != 0)
+        {
+            ++pos_;
+        }
+    }
+
+    bool accept(char c)
+    {
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c)
+        {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void emit(Op op, uint32_t operand = 0)
+    {
+        if (operand > kMaxOperand)
+        {
+            fail("expression too large");
+            return;
+        }
+        code_.push_back(static_cast<uint32_t>(op) | operand << 8);
+        if (op == Op::Const || op == Op::Load)
+        {
+            maxDepth_ = std::max(maxDepth_, ++depth_);
+        }
+        else if (op != Op::Not && op != Op::Neg)
+        {
+            --depth_;
+        }
+    }
+
+    const BinaryOperator *matchBinary(int level)
+    {
+        skipSpace();
+        for (const auto &candidate : kBinaryOperators)
+        {
+            const std::string token = candidate.token;
+            if (candidate.level == level && text_.compare(pos_, token.size(), token) == 0)
+            {
+                pos_ += token.size();
+                return &candidate;
+            }
+        }
+        return nullptr;
+    }
+
+    void parseLevel(int level)
+    {
+        if (level == kBinaryLevels)
+        {
+            parseUnary();
+            return;
+        }
+        parseLevel(level + 1);
+        while (error_.empty())
+        {
+            const auto *binary = matchBinary(level);
+            if (!binary)
+            {
+                break;
+            }
+            parseLevel(level + 1);
+            emit(binary->op);
+        }
+    }
+
+    void parseUnary()
+    {
+        if (accept('!'))
+        {
+            parseUnary();
+            emit(Op::Not);
+        }
+        else if (accept('-'))
+        {
+            parseUnary();
+            emit(Op::Neg);
+        }
+        else
+        {
+            parsePrimary();
+        }
+    }
+
+    // An identifier, or any text between single quotes.
+    bool parseName(std::string &name, bool &quoted)
+    {
+        quoted = accept('\'');
+        if (quoted)
+        {
+            const auto close = text_.find('\'', pos_);
+            if (close == std::string::npos || close == pos_)
+            {
+                fail("unterminated or empty quoted name");
+                return false;
+            }
+            name = text_.substr(pos_, close - pos_);
+            pos_ = close + 1;
+            return true;
+        }
+        if (pos_ >= text_.size() || !isNameStart(text_[pos_]))
+        {
+            fail("expected a value");
+            return false;
+        }
+        const auto start = pos_;
+        while (pos_ < text_.size() && isNameChar(text_[pos_]))
+        {
+            ++pos_;
+        }
+        name = text_.substr(start, pos_ - start);
+        return true;
+    }
+
+    void parsePrimary()
+    {
+        if (accept('('))
+        {
+            parseLevel(0);
+            if (error_.empty() && !accept(')'))
+            {
+                fail("expected ')'");
+            }
+            return;
+        }
+
+        skipSpace();
+        if (pos_ < text_.size() && (std::isdigit(static_cast<unsigned char>(text_[pos_])) != 0 || text_[pos_] == '.'))
+        {
+            const char *start = text_.c_str() + pos_;
+            char *stop = nullptr;
+            const double value = std::strtod(start, &stop);
+            if (stop == start)
+            {
+                fail("malformed number");
+                return;
+            }
+            pos_ += static_cast<size_t>(stop - start);
+            constant(value);
+            return;
+        }
+
+        std::string device;
+        std::string signal;
+        bool quoted = false;
+        if (!parseName(signal, quoted))
+        {
+            return;
+        }
+        if (accept(':'))
+        {
+            device = signal;
+            if (!parseName(signal, quoted))
+            {
+                return;
+            }
+        }
+        else if (!quoted && (signal == "true" || signal == "false"))
+        {
+            constant(truth(signal == "true"));
+            return;
+        }
+
+        std::string error;
+        const auto slot = resolve_(device, signal, error);
+        if (!slot)
+        {
+            error_ = error;
+            return;
+        }
+        emit(Op::Load, *slot);
+    }
+
+    void constant(double value)
+    {
+        emit(Op::Const, static_cast<uint32_t>(constants_.size()));
+        constants_.push_back(value);
+    }
+};
+
+double apply(Op op, double lhs, double rhs)
+{
+    switch (op)
+    {
+    case Op::Or:
+        return truth(lhs != 0.0 || rhs != 0.0);
+    case Op::And:
+        return truth(lhs != 0.0 && rhs != 0.0);
+    case Op::Eq:
+        return truth(lhs == rhs);
+    case Op::Ne:
+        return truth(lhs != rhs);
+    case Op::Lt:
+        return truth(lhs < rhs);
+    case Op::Le:
+        return truth(lhs <= rhs);
+    case Op::Gt:
+        return truth(lhs > rhs);
+    case Op::Ge:
+        return truth(lhs >= rhs);
+    case Op::Add:
+        return lhs + rhs;
+    case Op::Sub:
+        return lhs - rhs;
+    case Op::Mul:
+        return lhs * rhs;
+    case Op::Div:
+        return lhs / rhs;
+    default:
+        break;
+    }
+    return 0.0;
+}
+} // namespace
+
+bool RuleProgram::compile(const std::string &expression, const Resolver &resolve, Entry &entry, std::string &error)
+{
+    const auto codeSize = code_.size();
+    const auto constantCount = constants_.size();
+    std::vector<uint32_t> code;
+    size_t depth = 0;
+    Parser parser(expression, resolve, code, constants_);
+    if (!parser.parse(depth, error) || code_.size() + code.size() > UINT32_MAX)
+    {
+        constants_.resize(constantCount);
+        return false;
+    }
+    code_.insert(code_.end(), code.begin(), code.end());
+    entry.begin = static_cast<uint32_t>(codeSize);
+    entry.end = static_cast<uint32_t>(code_.size());
+    stackDepth_ = std::max(stackDepth_, depth);
+    return true;
+}
+
+bool RuleProgram::check(const std::string &expression, std::string &error)
+{
+    RuleProgram program;
+    Entry entry;
+    return program.compile(
+        expression, [](const std::string &, const std::string &, std::string &) { return std::optional<uint32_t>(0); },
+        entry, error);
+}
+
+double RuleProgram::run(Entry entry, const std::atomic<double> *registers, double *stack) const
+{
+    double *top = stack;
+    for (auto i = entry.begin; i < entry.end; ++i)
+    {
+        const uint32_t word = code_[i];
+        const auto op = static_cast<Op>(word & 0xFF);
+        const uint32_t operand = word >> 8;
+        switch (op)
+        {
+        case Op::Const:
+            *top++ = constants_[operand];
+            break;
+        case Op::Load:
+            *top++ = registers[operand].load(std::memory_order_relaxed);
+            break;
+        case Op::Not:
+            top[-1] = truth(top[-1] == 0.0);
+            break;
+        case Op::Neg:
+            top[-1] = -top[-1];
+            break;
+        default:
+            --top;
+            top[-1] = apply(op, top[-1], top[0]);
+            break;
+        }
+    }
+    return stack[0];
+}
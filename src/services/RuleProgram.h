@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Stack bytecode for rule expressions, one 32-bit word per instruction: the
+// opcode in the low byte and a constant or register index above it. Grammar,
+// loosest binding first:
+//
+//   ||   &&   == !=   < <= > >=   + -   * /   unary ! -   ( ) number true false reference
+//
+// A reference is `signal` on the rule's own device or `device:signal`; device
+// names that are not identifiers are quoted, as in 'door-1':door_closed.
+// Comparisons and logic yield 1 or 0, and any non-zero value is true.
+class RuleProgram
+{
+public:
+    // Maps a reference to a register index. The device is empty for the rule's own device.
+    using Resolver =
+        std::function<std::optional<uint32_t>(const std::string &device, const std::string &signal, std::string &error)>;
+
+    // A compiled expression: a range of the code.
+    struct Entry
+    {
+        uint32_t begin{0};
+        uint32_t end{0};
+    };
+
+    // Appends the code for `expression`. On failure the program is unchanged.
+    bool compile(const std::string &expression, const Resolver &resolve, Entry &entry, std::string &error);
+    // Syntax check only; every reference resolves.
+    static bool check(const std::string &expression, std::string &error);
+
+    // `stack` needs stackDepth() slots. Never allocates.
+    double run(Entry entry, const std::atomic<double> *registers, double *stack) const;
+    size_t stackDepth() const { return stackDepth_; }
+    size_t size() const { return code_.size(); }
+
+private:
+    std::vector<uint32_t> code_;
+    std::vector<double> constants_;
+    size_t stackDepth_{0};
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// Classifies the sequence numbers of received Class 1 packets: the 16-bit CIP
+// sequence count or the 32-bit encapsulation sequence number. Both wrap, so
+// order is judged with serial-number arithmetic: a packet up to half the range
+// ahead of the newest one seen is new, and any gap before it is counted lost.
+// Anything else is a duplicate if it was already seen within the last 64
+// numbers, otherwise stale; a stale packet that fills a gap is taken back out
+// of the lost count. One writer (the I/O thread); reads are lock-free.
+template <typename Count>
+class BasicSequenceTracker
+{
+public:
+    void observe(Count sequence)
+    {
+        if (!started_)
+        {
+            started_ = true;
+            window_ = 1;
+            span_ = 1;
+            store(last_, sequence);
+            return;
+        }
+
+        const auto newest = static_cast<Count>(last_.load(std::memory_order_relaxed));
+        const auto ahead = static_cast<Count>(sequence - newest);
+        if (ahead == 0)
+        {
+            bump(duplicates_);
+        }
+        else if (ahead < kHalfRange)
+        {
+            if (ahead > 1)
+            {
+                store(lost_, lost_.load(std::memory_order_relaxed) + ahead - 1);
+            }
+            window_ = ahead < kWindow ? (window_ << ahead) | 1 : 1;
+            span_ = static_cast<uint32_t>(std::min<uint64_t>(uint64_t{span_} + ahead, kWindow));
+            store(last_, sequence);
+        }
+        else
+        {
+            const auto behind = static_cast<Count>(newest - sequence);
+            const uint64_t bit = behind < span_ ? uint64_t{1} << behind : 0;
+            if (window_ & bit)
+            {
+                bump(duplicates_);
+                return;
+            }
+            bump(stale_);
+            if (bit)
+            {
+                window_ |= bit;
+                store(lost_, lost_.load(std::memory_order_relaxed) - 1);
+            }
+        }
+    }
+
+    uint64_t lastSequence() const { return last_.load(std::memory_order_relaxed); }
+    uint64_t lost() const { return lost_.load(std::memory_order_relaxed); }
+    uint64_t duplicates() const { return duplicates_.load(std::memory_order_relaxed); }
+    uint64_t stale() const { return stale_.load(std::memory_order_relaxed); }
+
+private:
+    static_assert(std::is_unsigned<Count>::value && sizeof(Count) <= sizeof(uint32_t), "16- or 32-bit counts");
+    static constexpr uint32_t kWindow = 64;
+    static constexpr Count kHalfRange = static_cast<Count>(Count{1} << (8 * sizeof(Count) - 1));
+
+    static void store(std::atomic<uint64_t> &counter, uint64_t value)
+    {
+        counter.store(value, std::memory_order_relaxed);
+    }
+    static void bump(std::atomic<uint64_t> &counter)
+    {
+        store(counter, counter.load(std::memory_order_relaxed) + 1);
+    }
+
+    // Bit i set: newest - i has been received. span_ is how many of those
+    // counts follow the first packet. Only the writer touches these.
+    uint64_t window_{0};
+    uint32_t span_{0};
+    bool started_{false};
+    std::atomic<uint64_t> last_{0};
+    std::atomic<uint64_t> lost_{0};
+    std::atomic<uint64_t> duplicates_{0};
+    std::atomic<uint64_t> stale_{0};
+};
+
+// The CIP sequence count moves when the target produces new data; the
+// encapsulation sequence number moves with every datagram it sends.
+using SequenceTracker = BasicSequenceTracker<uint16_t>;
+using EncapsulationSequenceTracker = BasicSequenceTracker<uint32_t>;
@@ -0,0 +1,74 @@
+#include "SerialExecutor.h"
+
+SerialExecutor::SerialExecutor(size_t threads)
+{
+    threads_.reserve(threads > 0 ? threads : 1);
+    for (size_t i = 0; i < (threads > 0 ? threads : 1); ++i)
+    {
+        threads_.emplace_back([this]() { run(); });
+    }
+}
+
+SerialExecutor::~SerialExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void SerialExecutor::post(const std::string &key, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &queue = queues_[key];
+        queue.tasks.push_back(std::move(task));
+        if (queue.scheduled)
+        {
+            return;
+        }
+        queue.scheduled = true;
+        ready_.push_back(key);
+    }
+    wake_.notify_one();
+}
+
+void SerialExecutor::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        wake_.wait(lock, [this]() { return stopping_ || !ready_.empty(); });
+        if (stopping_)
+        {
+            return;
+        }
+
+        const auto key = std::move(ready_.front());
+        ready_.pop_front();
+        auto task = std::move(queues_[key].tasks.front());
+        queues_[key].tasks.pop_front();
+
+        lock.unlock();
+        task();
+        task = nullptr;
+        lock.lock();
+
+        // The key stays scheduled while it has work, so no other thread picks it up meanwhile.
+        auto it = queues_.find(key);
+        if (it->second.tasks.empty())
+        {
+            queues_.erase(it);
+        }
+        else
+        {
+            ready_.push_back(key);
+            wake_.notify_one();
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs tasks on a small thread pool. Tasks posted under the same key run one
+// at a time in posting order; different keys run in parallel. Tasks still
+// queued at destruction are dropped, running ones are waited for.
+class SerialExecutor
+{
+public:
+    explicit SerialExecutor(size_t threads);
+    ~SerialExecutor();
+
+    SerialExecutor(const SerialExecutor &) = delete;
+    SerialExecutor &operator=(const SerialExecutor &) = delete;
+
+    void post(const std::string &key, std::function<void()> task);
+
+private:
+    struct Queue
+    {
+        std::deque<std::function<void()>> tasks;
+        bool scheduled{false}; // in ready_ or running
+    };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::map<std::string, Queue> queues_;
+    std::deque<std::string> ready_;
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+
+    void run();
+};
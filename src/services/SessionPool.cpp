@@ -0,0 +1,222 @@
+#include "SessionPool.h"
+
+#include <EIPScanner/SessionInfo.h>
+#include <EIPScanner/eip/EncapsPacket.h>
+#include <algorithm>
+#include <vector>
+
+SessionPool::Lease::Lease(SessionPool *pool, std::string key, Session session, bool reused)
+    : pool_(pool), key_(std::move(key)), session_(std::move(session)), reused_(reused)
+{
+}
+
+SessionPool::Lease::Lease(Lease &&other) noexcept
+    : pool_(other.pool_),
+      key_(std::move(other.key_)),
+      session_(std::move(other.session_)),
+      reused_(other.reused_),
+      valid_(other.valid_)
+{
+    other.pool_ = nullptr;
+}
+
+SessionPool::Lease::~Lease()
+{
+    if (pool_)
+    {
+        pool_->release(key_, std::move(session_), valid_);
+    }
+}
+
+SessionPool::SessionPool(const SessionPoolConfig &config, Factory factory)
+    : config_(config), factory_(std::move(factory))
+{
+    if (!factory_)
+    {
+        factory_ = [](const std::string &host, uint16_t port, std::chrono::milliseconds timeout) -> Session {
+            return std::make_shared<eipScanner::SessionInfo>(host, port, timeout);
+        };
+    }
+    worker_ = std::thread([this]() { maintain(); });
+}
+
+SessionPool::~SessionPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+SessionPool::Lease SessionPool::acquire(const std::string &host, uint16_t port, std::chrono::milliseconds timeout)
+{
+    auto key = host + ":" + std::to_string(port);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = idle_.find(key);
+        if (it != idle_.end() && !it->second.empty())
+        {
+            auto session = std::move(it->second.back().session);
+            it->second.pop_back();
+            stats_.leased++;
+            stats_.reused++;
+            return Lease(this, std::move(key), std::move(session), true);
+        }
+    }
+
+    auto session = factory_(host, port, timeout);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.leased++;
+    stats_.created++;
+    return Lease(this, std::move(key), std::move(session), false);
+}
+
+SessionPoolStats SessionPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats.idle = 0;
+    for (const auto &pair : idle_)
+    {
+        stats.idle += pair.second.size();
+    }
+    return stats;
+}
+
+void SessionPool::release(const std::string &key, Session session, bool valid)
+{
+    // Unregistering sends on the socket, so sessions are dropped outside the lock.
+    Session dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.leased--;
+        if (!valid || stopping_)
+        {
+            dropped = std::move(session);
+            stats_.dropped++;
+        }
+        else
+        {
+            auto &queue = idle_[key];
+            const auto now = Clock::now();
+            queue.push_back({std::move(session), now, now});
+            if (queue.size() > config_.maxIdlePerTarget)
+            {
+                dropped = std::move(queue.front().session);
+                queue.pop_front();
+                stats_.dropped++;
+            }
+        }
+    }
+}
+
+void SessionPool::maintain()
+{
+    const auto keepalive = std::chrono::milliseconds(config_.keepaliveMs);
+    const auto idleTimeout = std::chrono::milliseconds(config_.idleTimeoutMs);
+    const auto tick = std::max<std::chrono::milliseconds>(std::min(keepalive, idleTimeout) / 4,
+                                                          std::chrono::milliseconds(10));
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        wake_.wait_for(lock, tick);
+        if (stopping_)
+        {
+            break;
+        }
+
+        // Pull out what needs attention so callers cannot lease it meanwhile.
+        const auto now = Clock::now();
+        std::vector<Session> expired;
+        std::vector<std::pair<std::string, Idle>> due;
+        for (auto it = idle_.begin(); it != idle_.end();)
+        {
+            auto &queue = it->second;
+            for (auto entry = queue.begin(); entry != queue.end();)
+            {
+                if (now - entry->lastUsed >= idleTimeout)
+                {
+                    expired.push_back(std::move(entry->session));
+                    entry = queue.erase(entry);
+                }
+                else if (now - entry->lastChecked >= keepalive)
+                {
+                    due.emplace_back(it->first, std::move(*entry));
+                    entry = queue.erase(entry);
+                }
+                else
+                {
+                    ++entry;
+                }
+            }
+            it = queue.empty() ? idle_.erase(it) : std::next(it);
+        }
+        stats_.dropped += expired.size();
+        if (expired.empty() && due.empty())
+        {
+            continue;
+        }
+
+        lock.unlock();
+        expired.clear();
+        for (auto &pair : due)
+        {
+            if (!probe(pair.second.session))
+            {
+                pair.second.session.reset();
+            }
+            pair.second.lastChecked = Clock::now();
+        }
+        lock.lock();
+
+        for (auto &pair : due)
+        {
+            if (!pair.second.session)
+            {
+                stats_.dropped++;
+                continue;
+            }
+            // Sessions returned meanwhile are more recent; keep the queue ordered by last use.
+            auto &queue = idle_[pair.first];
+            auto position = std::find_if(queue.begin(), queue.end(), [&](const Idle &idle) {
+                return idle.lastUsed > pair.second.lastUsed;
+            });
+            queue.insert(position, std::move(pair.second));
+            if (queue.size() > config_.maxIdlePerTarget)
+            {
+                expired.push_back(std::move(queue.front().session));
+                queue.pop_front();
+                stats_.dropped++;
+            }
+        }
+        if (!expired.empty())
+        {
+            lock.unlock();
+            expired.clear();
+            lock.lock();
+        }
+    }
+
+    auto remaining = std::move(idle_);
+    idle_.clear();
+    lock.unlock();
+}
+
+bool SessionPool::probe(const Session &session)
+{
+    try
+    {
+        eipScanner::eip::EncapsPacket packet;
+        packet.setCommand(eipScanner::eip::EncapsCommands::LIST_SERVICES);
+        packet.setSessionHandle(session->getSessionHandle());
+        session->sendAndReceive(packet);
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
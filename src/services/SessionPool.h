@@ -0,0 +1,127 @@
+#pragma once
+
+#include <EIPScanner/SessionInfoIf.h>
+#include <json/json.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct SessionPoolConfig
+{
+    // Idle sessions not used or checked for this long are probed with ListServices.
+    uint32_t keepaliveMs{5000};
+    // Idle sessions unused for this long are unregistered and closed.
+    uint32_t idleTimeoutMs{60000};
+    // Extra idle sessions per target beyond this are closed, least recently used first.
+    uint32_t maxIdlePerTarget{4};
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["keepaliveMs"] = keepaliveMs;
+        value["idleTimeoutMs"] = idleTimeoutMs;
+        value["maxIdlePerTarget"] = maxIdlePerTarget;
+        return value;
+    }
+
+    static SessionPoolConfig fromJson(const Json::Value &value)
+    {
+        SessionPoolConfig config;
+        if (!value.isObject())
+        {
+            return config;
+        }
+        config.keepaliveMs = value.get("keepaliveMs", config.keepaliveMs).asUInt();
+        config.idleTimeoutMs = value.get("idleTimeoutMs", config.idleTimeoutMs).asUInt();
+        config.maxIdlePerTarget = value.get("maxIdlePerTarget", config.maxIdlePerTarget).asUInt();
+        return config;
+    }
+};
+
+struct SessionPoolStats
+{
+    size_t idle{0};
+    size_t leased{0};
+    uint64_t created{0};
+    uint64_t reused{0};
+    uint64_t dropped{0};
+};
+
+// Registered EtherNet/IP sessions kept open per ip:port. A lease gives one
+// caller exclusive use of a session, since requests on one socket cannot be
+// interleaved; returning it makes the session available to the next caller
+// for the same target. A background thread probes idle sessions with
+// ListServices and closes those that fail or sit unused too long. Leases
+// must not outlive the pool.
+class SessionPool
+{
+public:
+    using Session = eipScanner::SessionInfoIf::SPtr;
+    using Factory = std::function<Session(const std::string &host, uint16_t port, std::chrono::milliseconds timeout)>;
+
+    class Lease
+    {
+    public:
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&) = delete;
+        ~Lease();
+
+        const Session &session() const { return session_; }
+        // False when the session was registered for this lease.
+        bool reused() const { return reused_; }
+        // Discards the session on return instead of pooling it; call after a transport error.
+        void invalidate() { valid_ = false; }
+
+    private:
+        friend class SessionPool;
+        Lease(SessionPool *pool, std::string key, Session session, bool reused);
+
+        SessionPool *pool_;
+        std::string key_;
+        Session session_;
+        bool reused_;
+        bool valid_{true};
+    };
+
+    // The default factory registers a real eipScanner::SessionInfo.
+    explicit SessionPool(const SessionPoolConfig &config = {}, Factory factory = {});
+    ~SessionPool();
+
+    SessionPool(const SessionPool &) = delete;
+    SessionPool &operator=(const SessionPool &) = delete;
+
+    // Takes the most recently used idle session for the target or registers a
+    // new one, in which case it throws whatever registration throws.
+    Lease acquire(const std::string &host, uint16_t port, std::chrono::milliseconds timeout);
+
+    SessionPoolStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Idle
+    {
+        Session session;
+        Clock::time_point lastUsed;
+        Clock::time_point lastChecked;
+    };
+
+    SessionPoolConfig config_;
+    Factory factory_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::map<std::string, std::deque<Idle>> idle_; // most recently used at the back
+    SessionPoolStats stats_;
+    std::thread worker_;
+
+    void release(const std::string &key, Session session, bool valid);
+    void maintain();
+    static bool probe(const Session &session);
+};
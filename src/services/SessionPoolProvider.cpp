@@ -0,0 +1,19 @@
+#include "SessionPoolProvider.h"
+
+#include <drogon/drogon.h>
+
+std::shared_ptr<SessionPool> SessionPoolProvider::pool_ = nullptr;
+
+std::shared_ptr<SessionPool> SessionPoolProvider::instance()
+{
+    if (!pool_)
+    {
+        pool_ = std::make_shared<SessionPool>(SessionPoolConfig::fromJson(drogon::app().getCustomConfig()["sessionPool"]));
+    }
+    return pool_;
+}
+
+void SessionPoolProvider::use(const std::shared_ptr<SessionPool> &pool)
+{
+    pool_ = pool;
+}
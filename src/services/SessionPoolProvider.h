@@ -0,0 +1,14 @@
+#pragma once
+
+#include "SessionPool.h"
+#include <memory>
+
+class SessionPoolProvider
+{
+public:
+    static std::shared_ptr<SessionPool> instance();
+    static void use(const std::shared_ptr<SessionPool> &pool);
+
+private:
+    static std::shared_ptr<SessionPool> pool_;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct HistorySample
+{
+    int64_t timestampUs;
+    double value;
+};
+
+// Per-signal ring buffers of recent samples carved out of one allocation made
+// when the layout is applied. Recording overwrites the oldest sample and never
+// allocates.
+class SignalHistory
+{
+public:
+    void reset(const std::vector<uint32_t> &depths)
+    {
+        rings_.assign(depths.size(), Ring{});
+        size_t total = 0;
+        for (size_t i = 0; i < depths.size(); ++i)
+        {
+            rings_[i].start = total;
+            rings_[i].depth = depths[i];
+            total += depths[i];
+        }
+        std::vector<HistorySample>(total, HistorySample{0, 0.0}).swap(samples_);
+    }
+
+    void record(size_t slot, int64_t timestampUs, double value)
+    {
+        auto &ring = rings_[slot];
+        if (ring.depth == 0)
+        {
+            return;
+        }
+        samples_[ring.start + ring.head] = {timestampUs, value};
+        if (++ring.head == ring.depth)
+        {
+            ring.head = 0;
+        }
+        if (ring.count < ring.depth)
+        {
+            ++ring.count;
+        }
+    }
+
+    // Appends the samples of `slot` within [fromUs, toUs], oldest first.
+    void range(size_t slot, int64_t fromUs, int64_t toUs, std::vector<HistorySample> &out) const
+    {
+        const auto &ring = rings_[slot];
+        size_t index = (ring.head + ring.depth - ring.count) % (ring.depth ? ring.depth : 1);
+        for (uint32_t i = 0; i < ring.count; ++i)
+        {
+            const auto &sample = samples_[ring.start + index];
+            if (sample.timestampUs >= fromUs && sample.timestampUs <= toUs)
+            {
+                out.push_back(sample);
+            }
+            if (++index == ring.depth)
+            {
+                index = 0;
+            }
+        }
+    }
+
+    size_t size() const { return rings_.size(); }
+    uint32_t depth(size_t slot) const { return rings_[slot].depth; }
+    size_t bytes() const { return samples_.capacity() * sizeof(HistorySample); }
+
+private:
+    struct Ring
+    {
+        size_t start{0};
+        uint32_t depth{0};
+        uint32_t head{0};
+        uint32_t count{0};
+    };
+
+    std::vector<Ring> rings_;
+    std::vector<HistorySample> samples_;
+};
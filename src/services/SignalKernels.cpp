@@ -0,0 +1,177 @@
+#include "SignalKernels.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+void unpackBitsScalar(const uint8_t *data, size_t count, double *values)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = (data[i >> 3] >> (i & 7)) & 0x01 ? 1.0 : 0.0;
+    }
+}
+
+void unpackWordsScalar(const uint8_t *data, size_t count, double scale, double offset, double *values)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto word = static_cast<uint16_t>(data[2 * i] | (data[2 * i + 1] << 8));
+        values[i] = static_cast<double>(word) * scale + offset;
+    }
+}
+
+#if defined(__x86_64__)
+// One input byte per iteration: broadcast it, test each lane against its bit
+// and turn the all-ones compare result into 0/1 before converting to double.
+void unpackBitsSse2(const uint8_t *data, size_t count, double *values)
+{
+    const __m128i lowMask = _mm_setr_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i highMask = _mm_setr_epi32(0x10, 0x20, 0x40, 0x80);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i byte = _mm_set1_epi32(data[i >> 3]);
+        const __m128i low = _mm_srli_epi32(_mm_cmpeq_epi32(_mm_and_si128(byte, lowMask), lowMask), 31);
+        const __m128i high = _mm_srli_epi32(_mm_cmpeq_epi32(_mm_and_si128(byte, highMask), highMask), 31);
+        _mm_storeu_pd(values + i, _mm_cvtepi32_pd(low));
+        _mm_storeu_pd(values + i + 2, _mm_cvtepi32_pd(_mm_srli_si128(low, 8)));
+        _mm_storeu_pd(values + i + 4, _mm_cvtepi32_pd(high));
+        _mm_storeu_pd(values + i + 6, _mm_cvtepi32_pd(_mm_srli_si128(high, 8)));
+    }
+    unpackBitsScalar(data + (i >> 3), count - i, values + i);
+}
+
+void unpackWordsSse2(const uint8_t *data, size_t count, double scale, double offset, double *values)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128d scales = _mm_set1_pd(scale);
+    const __m128d offsets = _mm_set1_pd(offset);
+    auto store = [&](double *out, __m128i words) {
+        _mm_storeu_pd(out, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(words), scales), offsets));
+        _mm_storeu_pd(out + 2, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(words, 8)), scales), offsets));
+    };
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 2 * i));
+        store(values + i, _mm_unpacklo_epi16(words, zero));
+        store(values + i + 4, _mm_unpackhi_epi16(words, zero));
+    }
+    unpackWordsScalar(data + 2 * i, count - i, scale, offset, values + i);
+}
+
+__attribute__((target("avx2"))) void unpackBitsAvx2(const uint8_t *data, size_t count, double *values)
+{
+    const __m256i mask = _mm256_setr_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i byte = _mm256_set1_epi32(data[i >> 3]);
+        const __m256i bits = _mm256_srli_epi32(_mm256_cmpeq_epi32(_mm256_and_si256(byte, mask), mask), 31);
+        _mm256_storeu_pd(values + i, _mm256_cvtepi32_pd(_mm256_castsi256_si128(bits)));
+        _mm256_storeu_pd(values + i + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(bits, 1)));
+    }
+    unpackBitsScalar(data + (i >> 3), count - i, values + i);
+}
+
+__attribute__((target("avx2"))) void unpackWordsAvx2(const uint8_t *data, size_t count, double scale, double offset,
+                                                     double *values)
+{
+    const __m256d scales = _mm256_set1_pd(scale);
+    const __m256d offsets = _mm256_set1_pd(offset);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i words =
+            _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 2 * i)));
+        const __m256d low = _mm256_cvtepi32_pd(_mm256_castsi256_si128(words));
+        const __m256d high = _mm256_cvtepi32_pd(_mm256_extracti128_si256(words, 1));
+        _mm256_storeu_pd(values + i, _mm256_add_pd(_mm256_mul_pd(low, scales), offsets));
+        _mm256_storeu_pd(values + i + 4, _mm256_add_pd(_mm256_mul_pd(high, scales), offsets));
+    }
+    unpackWordsScalar(data + 2 * i, count - i, scale, offset, values + i);
+}
+#elif defined(__aarch64__)
+inline void storeWidened(double *out, uint32x4_t lanes)
+{
+    vst1q_f64(out, vcvtq_f64_u64(vmovl_u32(vget_low_u32(lanes))));
+    vst1q_f64(out + 2, vcvtq_f64_u64(vmovl_u32(vget_high_u32(lanes))));
+}
+
+void unpackBitsNeon(const uint8_t *data, size_t count, double *values)
+{
+    static const uint32_t lowBits[4] = {0x01, 0x02, 0x04, 0x08};
+    static const uint32_t highBits[4] = {0x10, 0x20, 0x40, 0x80};
+    const uint32x4_t lowMask = vld1q_u32(lowBits);
+    const uint32x4_t highMask = vld1q_u32(highBits);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const uint32x4_t byte = vdupq_n_u32(data[i >> 3]);
+        storeWidened(values + i, vshrq_n_u32(vtstq_u32(byte, lowMask), 31));
+        storeWidened(values + i + 4, vshrq_n_u32(vtstq_u32(byte, highMask), 31));
+    }
+    unpackBitsScalar(data + (i >> 3), count - i, values + i);
+}
+
+void unpackWordsNeon(const uint8_t *data, size_t count, double scale, double offset, double *values)
+{
+    const float64x2_t scales = vdupq_n_f64(scale);
+    const float64x2_t offsets = vdupq_n_f64(offset);
+    auto store = [&](double *out, uint32x4_t words) {
+        const float64x2_t low = vcvtq_f64_u64(vmovl_u32(vget_low_u32(words)));
+        const float64x2_t high = vcvtq_f64_u64(vmovl_u32(vget_high_u32(words)));
+        vst1q_f64(out, vaddq_f64(vmulq_f64(low, scales), offsets));
+        vst1q_f64(out + 2, vaddq_f64(vmulq_f64(high, scales), offsets));
+    };
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const uint16x8_t words = vreinterpretq_u16_u8(vld1q_u8(data + 2 * i));
+        store(values + i, vmovl_u16(vget_low_u16(words)));
+        store(values + i + 4, vmovl_u16(vget_high_u16(words)));
+    }
+    unpackWordsScalar(data + 2 * i, count - i, scale, offset, values + i);
+}
+#endif
+
+const SignalKernels kScalar{"scalar", unpackBitsScalar, unpackWordsScalar};
+#if defined(__x86_64__)
+const SignalKernels kSse2{"sse2", unpackBitsSse2, unpackWordsSse2};
+const SignalKernels kAvx2{"avx2", unpackBitsAvx2, unpackWordsAvx2};
+#elif defined(__aarch64__)
+const SignalKernels kNeon{"neon", unpackBitsNeon, unpackWordsNeon};
+#endif
+} // namespace
+
+const SignalKernels &SignalKernels::scalar()
+{
+    return kScalar;
+}
+
+const SignalKernels &SignalKernels::active()
+{
+    static const SignalKernels *kernels = available().back();
+    return *kernels;
+}
+
+std::vector<const SignalKernels *> SignalKernels::available()
+{
+    // Ordered slowest to fastest.
+    std::vector<const SignalKernels *> kernels{&kScalar};
+#if defined(__x86_64__)
+    kernels.push_back(&kSse2);
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels.push_back(&kAvx2);
+    }
+#elif defined(__aarch64__)
+    kernels.push_back(&kNeon);
+#endif
+    return kernels;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bulk decode kernels for runs of packed signals: consecutive BOOL bits and
+// consecutive UINT16 words that land in consecutive value slots. All kernel
+// sets decode to the same values; active() is the fastest one the CPU
+// supports and is chosen once on first use.
+struct SignalKernels
+{
+    const char *name;
+    // Expands `count` bits, least significant bit of data[0] first, to 0.0/1.0.
+    void (*unpackBits)(const uint8_t *data, size_t count, double *values);
+    // Decodes `count` little-endian UINT16 words as word * scale + offset.
+    void (*unpackWords)(const uint8_t *data, size_t count, double scale, double offset, double *values);
+
+    static const SignalKernels &scalar();
+    static const SignalKernels &active();
+    static std::vector<const SignalKernels *> available();
+};
@@ -0,0 +1,254 @@
+#include "SignalPlan.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// Runs shorter than this are cheaper to decode signal by signal.
+constexpr size_t kMinBitRun = 16;
+constexpr size_t kMinWordRun = 8;
+
+bool isInput(const SignalMapping &mapping, SignalType type)
+{
+    return mapping.direction == SignalDirection::Input && mapping.type == type;
+}
+
+// Bit n of a run is bit n % 8 of byte n / 8 counted from the run's first byte.
+size_t bitRunLength(const std::vector<SignalMapping> &mappings, size_t first)
+{
+    const auto &start = mappings[first];
+    if (!isInput(start, SignalType::Bool) || start.bitOffset.value_or(8) != 0)
+    {
+        return 0;
+    }
+    size_t count = 1;
+    for (; first + count < mappings.size(); ++count)
+    {
+        const auto &next = mappings[first + count];
+        if (!isInput(next, SignalType::Bool) || next.bitOffset.value_or(8) != count % 8 ||
+            next.byteOffset != start.byteOffset + count / 8)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+size_t wordRunLength(const std::vector<SignalMapping> &mappings, size_t first)
+{
+    const auto &start = mappings[first];
+    if (!isInput(start, SignalType::UInt16) || start.byteOrder != ByteOrder::Little)
+    {
+        return 0;
+    }
+    size_t count = 1;
+    for (; first + count < mappings.size(); ++count)
+    {
+        const auto &next = mappings[first + count];
+        if (!isInput(next, SignalType::UInt16) || next.byteOrder != ByteOrder::Little ||
+            next.byteOffset != start.byteOffset + 2 * count ||
+            next.scale != start.scale || next.engineeringOffset != start.engineeringOffset)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+template <typename Codec, typename Op>
+void runScaled(const std::vector<Op> &ops, const uint8_t *data, double *values)
+{
+    for (const auto &op : ops)
+    {
+        values[op.slot] = Codec::decode(data + op.byteOffset) * op.scale + op.offset;
+    }
+}
+
+template <typename Codec, typename Op>
+void runScaledChecked(const std::vector<Op> &ops, const uint8_t *data, size_t size, double *values)
+{
+    for (const auto &op : ops)
+    {
+        values[op.slot] = op.byteOffset + Codec::kWidth <= size ? Codec::decode(data + op.byteOffset) * op.scale + op.offset : 0.0;
+    }
+}
+
+// One loop per scalar codec, each with its load inlined.
+template <typename Groups, size_t... Index>
+void runAllScaled(const Groups &groups, const uint8_t *data, double *values, std::index_sequence<Index...>)
+{
+    (runScaled<SignalCodec::ScalarCodecAt<Index>>(groups[Index], data, values), ...);
+}
+
+template <typename Groups, size_t... Index>
+void runAllScaledChecked(const Groups &groups, const uint8_t *data, size_t size, double *values, std::index_sequence<Index...>)
+{
+    (runScaledChecked<SignalCodec::ScalarCodecAt<Index>>(groups[Index], data, size, values), ...);
+}
+} // namespace
+
+SignalDecodePlan SignalDecodePlan::compile(const std::vector<SignalMapping> &mappings, const SignalKernels *kernels)
+{
+    SignalDecodePlan plan;
+    plan.kernels_ = kernels;
+    std::vector<bool> inRun(mappings.size(), false);
+    for (size_t i = 0; kernels && i < mappings.size(); ++i)
+    {
+        const auto &mapping = mappings[i];
+        const auto slot = static_cast<uint32_t>(i);
+        const auto bits = bitRunLength(mappings, i);
+        const auto words = wordRunLength(mappings, i);
+        size_t count = 0;
+        if (bits >= kMinBitRun)
+        {
+            count = bits;
+            plan.bitRuns_.push_back({slot, mapping.byteOffset, static_cast<uint32_t>(count), 1.0, 0.0});
+            plan.extent_ = std::max(plan.extent_, mapping.byteOffset + (count + 7) / 8);
+        }
+        else if (words >= kMinWordRun)
+        {
+            count = words;
+            plan.wordRuns_.push_back(
+                {slot, mapping.byteOffset, static_cast<uint32_t>(count), mapping.scale, mapping.engineeringOffset});
+            plan.extent_ = std::max(plan.extent_, mapping.byteOffset + 2 * count);
+        }
+        if (count > 0)
+        {
+            std::fill(inRun.begin() + i, inRun.begin() + i + count, true);
+            i += count - 1;
+        }
+    }
+
+    for (size_t i = 0; i < mappings.size(); ++i)
+    {
+        const auto &mapping = mappings[i];
+        if (mapping.direction != SignalDirection::Input || inRun[i])
+        {
+            continue;
+        }
+
+        const auto slot = static_cast<uint32_t>(i);
+        switch (mapping.type)
+        {
+        case SignalType::Bool:
+        {
+            uint8_t mask = 0xFF;
+            if (mapping.bitOffset.has_value() && *mapping.bitOffset < 8)
+            {
+                mask = static_cast<uint8_t>(1u << *mapping.bitOffset);
+            }
+            plan.bools_.push_back({slot, mapping.byteOffset, mask});
+            break;
+        }
+        case SignalType::Bits:
+            plan.bitfields_.push_back({slot, mapping.byteOffset, static_cast<uint8_t>(mapping.widthBytes()),
+                                       mapping.bitOffset.value_or(0), mapping.byteOrder, SignalCodec::bitMask(mapping),
+                                       mapping.scale, mapping.engineeringOffset});
+            break;
+        case SignalType::String:
+            // Text is decoded from the published frame bytes when read.
+            continue;
+        default:
+            plan.scaled_[SignalCodec::scalarCodecIndex(mapping.type, mapping.byteOrder)].push_back(
+                {slot, mapping.byteOffset, mapping.scale, mapping.engineeringOffset});
+            break;
+        }
+        plan.extent_ = std::max(plan.extent_, static_cast<size_t>(mapping.byteOffset) + mapping.widthBytes());
+    }
+
+    // Walking the assembly front to back keeps the per-packet loops cache friendly.
+    auto byOffset = [](const auto &lhs, const auto &rhs) { return lhs.byteOffset < rhs.byteOffset; };
+    std::sort(plan.bools_.begin(), plan.bools_.end(), byOffset);
+    std::sort(plan.bitfields_.begin(), plan.bitfields_.end(), byOffset);
+    for (auto &group : plan.scaled_)
+    {
+        std::sort(group.begin(), group.end(), byOffset);
+    }
+    return plan;
+}
+
+size_t SignalDecodePlan::size() const
+{
+    size_t runs = 0;
+    for (const auto &run : bitRuns_)
+    {
+        runs += run.count;
+    }
+    for (const auto &run : wordRuns_)
+    {
+        runs += run.count;
+    }
+    size_t scaled = 0;
+    for (const auto &group : scaled_)
+    {
+        scaled += group.size();
+    }
+    return runs + bools_.size() + bitfields_.size() + scaled;
+}
+
+void SignalDecodePlan::run(const uint8_t *data, size_t size, double *values) const
+{
+    if (size < extent_)
+    {
+        runChecked(data, size, values);
+        return;
+    }
+
+    for (const auto &run : bitRuns_)
+    {
+        kernels_->unpackBits(data + run.byteOffset, run.count, values + run.slot);
+    }
+    for (const auto &run : wordRuns_)
+    {
+        kernels_->unpackWords(data + run.byteOffset, run.count, run.scale, run.offset, values + run.slot);
+    }
+    for (const auto &op : bools_)
+    {
+        values[op.slot] = (data[op.byteOffset] & op.mask) ? 1.0 : 0.0;
+    }
+    for (const auto &op : bitfields_)
+    {
+        values[op.slot] = static_cast<double>(SignalCodec::loadBits(data + op.byteOffset, op.width, op.order, op.shift, op.mask)) *
+                              op.scale +
+                          op.offset;
+    }
+    runAllScaled(scaled_, data, values, std::make_index_sequence<SignalCodec::kScalarCodecCount>{});
+}
+
+void SignalDecodePlan::runChecked(const uint8_t *data, size_t size, double *values) const
+{
+    // Decode the part of each run that fits and zero the rest.
+    for (const auto &run : bitRuns_)
+    {
+        const size_t fits = size > run.byteOffset ? std::min<size_t>(run.count, (size - run.byteOffset) * 8) : 0;
+        if (fits > 0)
+        {
+            kernels_->unpackBits(data + run.byteOffset, fits, values + run.slot);
+        }
+        std::fill(values + run.slot + fits, values + run.slot + run.count, 0.0);
+    }
+    for (const auto &run : wordRuns_)
+    {
+        const size_t fits = size > run.byteOffset ? std::min<size_t>(run.count, (size - run.byteOffset) / 2) : 0;
+        if (fits > 0)
+        {
+            kernels_->unpackWords(data + run.byteOffset, fits, run.scale, run.offset, values + run.slot);
+        }
+        std::fill(values + run.slot + fits, values + run.slot + run.count, 0.0);
+    }
+    for (const auto &op : bools_)
+    {
+        values[op.slot] = op.byteOffset < size && (data[op.byteOffset] & op.mask) ? 1.0 : 0.0;
+    }
+    for (const auto &op : bitfields_)
+    {
+        values[op.slot] = op.byteOffset + op.width <= size
+                              ? static_cast<double>(SignalCodec::loadBits(data + op.byteOffset, op.width, op.order,
+                                                                          op.shift, op.mask)) *
+                                        op.scale +
+                                    op.offset
+                              : 0.0;
+    }
+    runAllScaledChecked(scaled_, data, size, values, std::make_index_sequence<SignalCodec::kScalarCodecCount>{});
+}
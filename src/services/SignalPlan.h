@@ -0,0 +1,75 @@
+#pragma once
+
+#include "models/SignalCodec.h"
+#include "SignalKernels.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Flat decode program compiled from a device's input mappings. Operations are
+// grouped by wire codec so decoding a packet is one branch-free loop per codec,
+// and each result lands in a dense value array at the slot of its mapping.
+// Long runs of packed bits and words are decoded in bulk by `kernels`; pass
+// nullptr to decode every signal individually.
+class SignalDecodePlan
+{
+public:
+    static SignalDecodePlan compile(const std::vector<SignalMapping> &mappings,
+                                    const SignalKernels *kernels = &SignalKernels::active());
+
+    // Number of bytes a packet needs for every operation to be in range.
+    size_t extent() const { return extent_; }
+    size_t size() const;
+
+    void run(const uint8_t *data, size_t size, double *values) const;
+
+private:
+    struct BitOp
+    {
+        uint32_t slot;
+        uint16_t byteOffset;
+        uint8_t mask;
+    };
+
+    struct ScaledOp
+    {
+        uint32_t slot;
+        uint16_t byteOffset;
+        double scale;
+        double offset;
+    };
+
+    // Consecutive signals stored back to back in the assembly and in the value array.
+    struct Run
+    {
+        uint32_t slot;
+        uint16_t byteOffset;
+        uint32_t count;
+        double scale;
+        double offset;
+    };
+
+    const SignalKernels *kernels_{nullptr};
+    std::vector<Run> bitRuns_;
+    std::vector<Run> wordRuns_;
+    struct BitfieldOp
+    {
+        uint32_t slot;
+        uint16_t byteOffset;
+        uint8_t width;
+        uint8_t shift;
+        ByteOrder order;
+        uint64_t mask;
+        double scale;
+        double offset;
+    };
+
+    std::vector<BitOp> bools_;
+    std::vector<BitfieldOp> bitfields_;
+    std::array<std::vector<ScaledOp>, SignalCodec::kScalarCodecCount> scaled_;
+    size_t extent_{0};
+
+    void runChecked(const uint8_t *data, size_t size, double *values) const;
+};
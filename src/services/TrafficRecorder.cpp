@@ -0,0 +1,580 @@
+#include "TrafficRecorder.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+// Log layout: a 16-byte file header, then 8-byte aligned records, each a
+// 24-byte header and its payload. The preallocated tail is zero, and a zero
+// kind ends the log, so a file cut short by a crash still reads back. A
+// stream record holds the device address, the O->T and T->O connection ids,
+// then the name.
+constexpr char kMagic[8] = {'C', 'I', 'P', 'R', 'E', 'C', '2', '\0'};
+constexpr size_t kFileHeaderBytes = 16;
+constexpr size_t kRecordHeaderBytes = 24;
+constexpr size_t kStreamHeaderBytes = 12;
+constexpr const char *kFilePrefix = "traffic-";
+constexpr const char *kFileSuffix = ".ciprec";
+
+// Synthetic framing: IPv4 and UDP between the I/O ports, then the CPF items of a Class 1 packet.
+constexpr uint16_t kIoPort = 2222;
+constexpr size_t kFramingBytes = 20 + 8 + 2 + 4 + 8 + 4 + 2;
+
+size_t padded(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void putLe(uint8_t *at, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        at[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t getLe(const uint8_t *at, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        value |= static_cast<uint64_t>(at[i]) << (8 * i);
+    }
+    return value;
+}
+
+class Block
+{
+public:
+    Block &u8(uint8_t value)
+    {
+        bytes_.push_back(static_cast<char>(value));
+        return *this;
+    }
+    Block &le16(uint16_t value) { return u8(value & 0xFF).u8(value >> 8); }
+    Block &le32(uint32_t value) { return le16(value & 0xFFFF).le16(value >> 16); }
+    Block &be16(uint16_t value) { return u8(value >> 8).u8(value & 0xFF); }
+    Block &be32(uint32_t value) { return be16(value >> 16).be16(value & 0xFFFF); }
+    Block &raw(const uint8_t *data, size_t size)
+    {
+        bytes_.append(reinterpret_cast<const char *>(data), size);
+        return *this;
+    }
+    size_t size() const { return bytes_.size(); }
+    uint8_t &at(size_t index) { return reinterpret_cast<uint8_t &>(bytes_[index]); }
+
+    // Pads to 32 bits and wraps the body as a pcapng block.
+    std::string wrap(uint32_t type)
+    {
+        bytes_.resize(padded(bytes_.size(), 4), '\0');
+        const auto total = static_cast<uint32_t>(bytes_.size() + 12);
+        Block block;
+        block.le32(type).le32(total);
+        block.bytes_ += bytes_;
+        block.le32(total);
+        return block.bytes_;
+    }
+
+private:
+    std::string bytes_;
+};
+
+struct StreamInfo
+{
+    uint32_t address{0}; // network order
+    uint32_t connectionId[2]{0, 0}; // T->O, O->T
+    uint32_t encapsulationSequence[2]{0, 0};
+};
+
+std::string packetBlock(uint64_t timestampNs, StreamInfo &stream, uint8_t direction, uint16_t sequence,
+                        const uint8_t *data, size_t captured, size_t length)
+{
+    Block packet;
+    const auto cpfBytes = static_cast<uint16_t>(kFramingBytes - 28 + length);
+    // IPv4; the originator's own address is not recorded, so that side is 0.0.0.0.
+    const uint32_t device = ntohl(stream.address);
+    packet.u8(0x45).u8(0).be16(static_cast<uint16_t>(28 + cpfBytes)).be16(0).be16(0x4000).u8(64).u8(17).be16(0);
+    packet.be32(direction == 0 ? device : 0).be32(direction == 0 ? 0 : device);
+    uint32_t sum = 0;
+    for (size_t i = 0; i < 20; i += 2)
+    {
+        sum += (packet.at(i) << 8) | packet.at(i + 1);
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    packet.at(10) = static_cast<uint8_t>(~sum >> 8);
+    packet.at(11) = static_cast<uint8_t>(~sum);
+    packet.be16(kIoPort).be16(kIoPort).be16(static_cast<uint16_t>(8 + cpfBytes)).be16(0);
+    // Sequenced address item and connected data item.
+    packet.le16(2).le16(0x8002).le16(8).le32(stream.connectionId[direction]);
+    packet.le32(++stream.encapsulationSequence[direction]);
+    packet.le16(0x00B1).le16(static_cast<uint16_t>(2 + length)).le16(sequence).raw(data, captured);
+
+    Block block;
+    block.le32(0).le32(static_cast<uint32_t>(timestampNs >> 32)).le32(static_cast<uint32_t>(timestampNs));
+    block.le32(static_cast<uint32_t>(packet.size())).le32(static_cast<uint32_t>(kFramingBytes + length));
+    block.raw(&packet.at(0), packet.size());
+    return block.wrap(6);
+}
+} // namespace
+
+TrafficRecorder::TrafficRecorder(TrafficRecorderConfig config) : config_(std::move(config))
+{
+}
+
+TrafficRecorder::~TrafficRecorder()
+{
+    stop();
+}
+
+bool TrafficRecorder::start(std::string &error)
+{
+    if (recording())
+    {
+        error = "Recorder is already running";
+        return false;
+    }
+    if (writer_.joinable())
+    {
+        writer_.join();
+    }
+    // The queue is only allocated once recording is first started; it stays empty between runs.
+    if (!slots_)
+    {
+        size_t capacity = 2;
+        while (capacity < config_.queueFrames)
+        {
+            capacity <<= 1;
+        }
+        slots_.reset(new Slot[capacity]);
+        mask_ = capacity - 1;
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            slots_[i].turn.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+    if (ec)
+    {
+        error = "Cannot create " + config_.directory + ": " + ec.message();
+        return false;
+    }
+
+    // Continue numbering after logs from earlier runs, which count towards maxFiles.
+    std::vector<std::filesystem::path> existing;
+    for (const auto &entry : std::filesystem::directory_iterator(config_.directory, ec))
+    {
+        const auto name = entry.path().filename().string();
+        if (name.rfind(kFilePrefix, 0) == 0 && entry.path().extension() == kFileSuffix)
+        {
+            existing.push_back(entry.path());
+        }
+    }
+    std::sort(existing.begin(), existing.end());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        files_.clear();
+        for (const auto &path : existing)
+        {
+            files_.push_back(path.string());
+        }
+        lastError_.clear();
+    }
+    fileIndex_ = 0;
+    if (!existing.empty())
+    {
+        const auto stem = existing.back().stem().string();
+        fileIndex_ = std::stoull(stem.substr(std::strlen(kFilePrefix))) + 1;
+    }
+
+    if (!openFile(error))
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastError_ = error;
+        return false;
+    }
+    recording_.store(true, std::memory_order_release);
+    writer_ = std::thread([this]() { write(); });
+    return true;
+}
+
+void TrafficRecorder::stop()
+{
+    if (!recording_.exchange(false))
+    {
+        if (writer_.joinable())
+        {
+            // The writer stopped itself after an I/O error.
+            writer_.join();
+        }
+        return;
+    }
+    writer_.join();
+}
+
+uint32_t TrafficRecorder::openStream(const std::string &name, const std::string &ipAddress, uint32_t o2tConnectionId,
+                                     uint32_t t2oConnectionId)
+{
+    const auto id = nextStream_.fetch_add(1);
+    std::vector<uint8_t> payload(kStreamHeaderBytes, 0);
+    in_addr address{};
+    if (::inet_pton(AF_INET, ipAddress.c_str(), &address) == 1)
+    {
+        std::memcpy(payload.data(), &address.s_addr, 4);
+    }
+    putLe(payload.data() + 4, o2tConnectionId, 4);
+    putLe(payload.data() + 8, t2oConnectionId, 4);
+    payload.insert(payload.end(), name.begin(),
+                   name.begin() + std::min(name.size(), kSnapBytes - kStreamHeaderBytes));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams_[id] = payload;
+    }
+    if (recording())
+    {
+        push(Kind::Stream, id, Direction::Input, 0, payload.data(), payload.size());
+    }
+    return id;
+}
+
+void TrafficRecorder::record(uint32_t stream, Direction direction, uint16_t sequence,
+                             const std::vector<uint8_t> &data)
+{
+    if (!recording())
+    {
+        return;
+    }
+    if (push(Kind::Frame, stream, direction, sequence, data.data(), data.size()))
+    {
+        frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool TrafficRecorder::push(Kind kind, uint32_t stream, Direction direction, uint16_t sequence,
+                           const uint8_t *data, size_t size)
+{
+    // Bounded multi-producer queue: a slot is free for position p when its turn is p,
+    // and holds a frame for the writer when its turn is p + 1.
+    size_t position = enqueue_.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true)
+    {
+        slot = &slots_[position & mask_];
+        const auto turn = slot->turn.load(std::memory_order_acquire);
+        const auto lag = static_cast<std::ptrdiff_t>(turn - position);
+        if (lag == 0)
+        {
+            if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (lag < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = enqueue_.load(std::memory_order_relaxed);
+        }
+    }
+
+    timespec now{};
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    slot->kind = kind;
+    slot->direction = direction;
+    slot->sequence = sequence;
+    slot->stream = stream;
+    slot->timestampNs = static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+    slot->length = static_cast<uint16_t>(std::min<size_t>(size, 0xFFFF));
+    slot->captured = static_cast<uint16_t>(std::min(size, kSnapBytes));
+    std::memcpy(slot->data.data(), data, slot->captured);
+    slot->turn.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+void TrafficRecorder::write()
+{
+    while (true)
+    {
+        const bool wasRecording = recording();
+        if (!drain() && !wasRecording)
+        {
+            break;
+        }
+        if (wasRecording)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    closeFile();
+}
+
+bool TrafficRecorder::drain()
+{
+    bool any = false;
+    while (true)
+    {
+        auto &slot = slots_[dequeue_ & mask_];
+        if (slot.turn.load(std::memory_order_acquire) != dequeue_ + 1)
+        {
+            return any;
+        }
+        if (map_ && !append(slot))
+        {
+            recording_.store(false, std::memory_order_release);
+        }
+        slot.turn.store(dequeue_ + mask_ + 1, std::memory_order_release);
+        dequeue_++;
+        any = true;
+    }
+}
+
+bool TrafficRecorder::append(const Slot &slot)
+{
+    const size_t size = kRecordHeaderBytes + padded(slot.captured, 8);
+    const size_t capacity = static_cast<size_t>(config_.fileKb) * 1024;
+    if (used_ + size > capacity)
+    {
+        closeFile();
+        std::string error;
+        if (!openFile(error))
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lastError_ = error;
+            return false;
+        }
+        if (used_ + size > capacity)
+        {
+            return true;
+        }
+    }
+
+    uint8_t *record = map_ + used_;
+    record[1] = static_cast<uint8_t>(slot.direction);
+    putLe(record + 2, slot.captured, 2);
+    putLe(record + 4, slot.stream, 4);
+    putLe(record + 8, slot.timestampNs, 8);
+    putLe(record + 16, slot.sequence, 2);
+    putLe(record + 18, slot.length, 2);
+    std::memcpy(record + kRecordHeaderBytes, slot.data.data(), slot.captured);
+    // The kind goes in last so an export reading the live file never sees half a record.
+    std::atomic_thread_fence(std::memory_order_release);
+    record[0] = static_cast<uint8_t>(slot.kind);
+    used_ += size;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytesWritten_ += size;
+    return true;
+}
+
+bool TrafficRecorder::openFile(std::string &error)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s%06llu%s", kFilePrefix, static_cast<unsigned long long>(fileIndex_++),
+                  kFileSuffix);
+    const auto path = (std::filesystem::path(config_.directory) / name).string();
+    const size_t capacity = static_cast<size_t>(config_.fileKb) * 1024;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        error = "Cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    // Reserve the blocks up front so the writer never waits on allocation or hits ENOSPC mid-file.
+    const int status = ::posix_fallocate(fd_, 0, static_cast<off_t>(capacity));
+    void *map = status == 0 ? ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0) : MAP_FAILED;
+    if (map == MAP_FAILED)
+    {
+        error = "Cannot preallocate " + path + ": " + std::strerror(status != 0 ? status : errno);
+        ::close(fd_);
+        ::unlink(path.c_str());
+        fd_ = -1;
+        return false;
+    }
+    map_ = static_cast<uint8_t *>(map);
+    std::memcpy(map_, kMagic, sizeof(kMagic));
+    putLe(map_ + 8, config_.fileKb, 4);
+    used_ = kFileHeaderBytes;
+
+    std::map<uint32_t, std::vector<uint8_t>> streams;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams = streams_;
+        files_.push_back(path);
+        while (files_.size() > config_.maxFiles)
+        {
+            ::unlink(files_.front().c_str());
+            files_.pop_front();
+        }
+    }
+    for (const auto &stream : streams)
+    {
+        Slot slot;
+        slot.kind = Kind::Stream;
+        slot.stream = stream.first;
+        slot.length = slot.captured = static_cast<uint16_t>(stream.second.size());
+        std::memcpy(slot.data.data(), stream.second.data(), stream.second.size());
+        if (used_ + kRecordHeaderBytes + padded(slot.captured, 8) <= capacity)
+        {
+            append(slot);
+        }
+    }
+    return true;
+}
+
+void TrafficRecorder::closeFile()
+{
+    if (!map_)
+    {
+        return;
+    }
+    const size_t capacity = static_cast<size_t>(config_.fileKb) * 1024;
+    ::munmap(map_, capacity);
+    // Give back the unused preallocation; the log ends where the file does.
+    if (::ftruncate(fd_, static_cast<off_t>(used_)) != 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastError_ = std::string("Cannot truncate log: ") + std::strerror(errno);
+    }
+    ::close(fd_);
+    map_ = nullptr;
+    fd_ = -1;
+    used_ = 0;
+}
+
+TrafficRecorderStats TrafficRecorder::stats() const
+{
+    TrafficRecorderStats stats;
+    stats.recording = recording();
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.bytesWritten = bytesWritten_;
+    stats.files.assign(files_.begin(), files_.end());
+    stats.lastError = lastError_;
+    return stats;
+}
+
+bool TrafficRecorder::exportPcapng(const std::string &path, std::string &error) const
+{
+    std::vector<std::string> logs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        logs.assign(files_.begin(), files_.end());
+    }
+    return exportPcapng(logs, path, error);
+}
+
+bool TrafficRecorder::exportPcapng(const std::vector<std::string> &logs, const std::string &path,
+                                   std::string &error)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        error = "Cannot write " + path;
+        return false;
+    }
+
+    // Section header, then one raw-IPv4 interface with nanosecond timestamps.
+    Block section;
+    section.le32(0x1A2B3C4D).le16(1).le16(0).le32(0xFFFFFFFF).le32(0xFFFFFFFF);
+    out << section.wrap(0x0A0D0D0A);
+    Block interface;
+    interface.le16(101).le16(0).le32(0);
+    interface.le16(9).le16(1).u8(9).u8(0).u8(0).u8(0); // if_tsresol: 10^-9
+    interface.le16(0).le16(0);
+    out << interface.wrap(1);
+
+    std::map<uint32_t, StreamInfo> streams;
+    readLogs(
+        logs,
+        [&streams](const LoggedStream &logged) {
+            auto &stream = streams[logged.id];
+            stream.address = logged.address;
+            stream.connectionId[static_cast<uint8_t>(Direction::Input)] = logged.t2oConnectionId;
+            stream.connectionId[static_cast<uint8_t>(Direction::Output)] = logged.o2tConnectionId;
+        },
+        [&](const LoggedFrame &frame) {
+            out << packetBlock(frame.timestampNs, streams[frame.stream], static_cast<uint8_t>(frame.direction),
+                               frame.sequence, frame.data, frame.captured, frame.length);
+        });
+
+    out.flush();
+    if (!out)
+    {
+        error = "Cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+void TrafficRecorder::readLogs(const std::vector<std::string> &logs, const StreamVisitor &onStream,
+                               const FrameVisitor &onFrame)
+{
+    for (const auto &log : logs)
+    {
+        std::ifstream in(log, std::ios::binary);
+        const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (bytes.size() < kFileHeaderBytes || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0)
+        {
+            // Rotated away while reading, or not a log.
+            continue;
+        }
+        size_t offset = kFileHeaderBytes;
+        while (offset + kRecordHeaderBytes <= bytes.size())
+        {
+            const uint8_t *record = bytes.data() + offset;
+            const auto kind = static_cast<Kind>(record[0]);
+            const auto captured = static_cast<size_t>(getLe(record + 2, 2));
+            const auto size = kRecordHeaderBytes + padded(captured, 8);
+            if ((kind != Kind::Stream && kind != Kind::Frame) || offset + size > bytes.size())
+            {
+                break;
+            }
+            const auto id = static_cast<uint32_t>(getLe(record + 4, 4));
+            const uint8_t *payload = record + kRecordHeaderBytes;
+            if (kind == Kind::Stream && captured >= kStreamHeaderBytes)
+            {
+                LoggedStream stream;
+                stream.id = id;
+                std::memcpy(&stream.address, payload, 4);
+                stream.o2tConnectionId = static_cast<uint32_t>(getLe(payload + 4, 4));
+                stream.t2oConnectionId = static_cast<uint32_t>(getLe(payload + 8, 4));
+                stream.name.assign(payload + kStreamHeaderBytes, payload + captured);
+                onStream(stream);
+            }
+            else if (kind == Kind::Frame)
+            {
+                LoggedFrame frame;
+                frame.timestampNs = getLe(record + 8, 8);
+                frame.stream = id;
+                frame.direction = (record[1] & 1) ? Direction::Output : Direction::Input;
+                frame.sequence = static_cast<uint16_t>(getLe(record + 16, 2));
+                frame.length = static_cast<uint16_t>(getLe(record + 18, 2));
+                frame.data = payload;
+                frame.captured = captured;
+                onFrame(frame);
+            }
+            offset += size;
+        }
+    }
+}
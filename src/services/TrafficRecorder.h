@@ -0,0 +1,208 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The "recorder" block of custom_config.
+struct TrafficRecorderConfig
+{
+    // Start recording when the server starts; it can also be started over HTTP.
+    bool enabled{false};
+    std::string directory{"recordings"};
+    // Each log file is preallocated to this size and rotated when full.
+    uint32_t fileKb{65536};
+    // Older files beyond this count are deleted, bounding disk use to fileKb * maxFiles.
+    uint32_t maxFiles{8};
+    // Frames buffered between the I/O threads and the writer; rounded up to a power of two.
+    uint32_t queueFrames{8192};
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["enabled"] = enabled;
+        value["directory"] = directory;
+        value["fileKb"] = fileKb;
+        value["maxFiles"] = maxFiles;
+        value["queueFrames"] = queueFrames;
+        return value;
+    }
+
+    static TrafficRecorderConfig fromJson(const Json::Value &value)
+    {
+        TrafficRecorderConfig config;
+        if (!value.isObject())
+        {
+            return config;
+        }
+        config.enabled = value.get("enabled", false).asBool();
+        config.directory = value.get("directory", config.directory).asString();
+        config.fileKb = std::max(value.get("fileKb", config.fileKb).asUInt(), 4u);
+        config.maxFiles = std::max(value.get("maxFiles", config.maxFiles).asUInt(), 1u);
+        config.queueFrames = std::max(value.get("queueFrames", config.queueFrames).asUInt(), 2u);
+        return config;
+    }
+};
+
+struct TrafficRecorderStats
+{
+    bool recording{false};
+    uint64_t frames{0};
+    // Frames lost because the writer fell behind and the queue was full.
+    uint64_t dropped{0};
+    uint64_t bytesWritten{0};
+    std::vector<std::string> files;
+    std::string lastError;
+
+    Json::Value toJson() const
+    {
+        Json::Value value;
+        value["recording"] = recording;
+        value["frames"] = static_cast<Json::UInt64>(frames);
+        value["dropped"] = static_cast<Json::UInt64>(dropped);
+        value["bytesWritten"] = static_cast<Json::UInt64>(bytesWritten);
+        Json::Value list(Json::arrayValue);
+        for (const auto &file : files)
+        {
+            list.append(file);
+        }
+        value["files"] = list;
+        if (!lastError.empty())
+        {
+            value["lastError"] = lastError;
+        }
+        return value;
+    }
+};
+
+// Records the assembly bytes of every Class 1 packet sent and received.
+// I/O threads copy each frame into a preallocated lock-free queue and never
+// wait; a writer thread appends the frames to memory-mapped, preallocated log
+// files, starting a new file when one is full and deleting the oldest beyond
+// maxFiles. The retained logs export as pcapng with synthetic IPv4/UDP and
+// ENIP common packet framing, so Wireshark decodes them as Class 1 traffic.
+class TrafficRecorder
+{
+public:
+    enum class Direction : uint8_t
+    {
+        Input = 0,  // T->O, received from the device
+        Output = 1, // O->T, sent to the device
+    };
+
+    // Frames longer than this keep only their first kSnapBytes, like a pcap snaplen.
+    static constexpr size_t kSnapBytes = 1500;
+
+    explicit TrafficRecorder(TrafficRecorderConfig config = {});
+    ~TrafficRecorder();
+
+    TrafficRecorder(const TrafficRecorder &) = delete;
+    TrafficRecorder &operator=(const TrafficRecorder &) = delete;
+
+    bool start(std::string &error);
+    // Writes out queued frames and closes the current file.
+    void stop();
+    bool recording() const { return recording_.load(std::memory_order_acquire); }
+
+    // Names a connection for the log, with the connection ids its ForwardOpen
+    // reply assigned; pass the returned id to record().
+    uint32_t openStream(const std::string &name, const std::string &ipAddress, uint32_t o2tConnectionId,
+                        uint32_t t2oConnectionId);
+    // Safe from any thread and never blocks. Does nothing unless recording.
+    void record(uint32_t stream, Direction direction, uint16_t sequence, const std::vector<uint8_t> &data);
+
+    // A frame read back from the logs; data points into the reader's buffer.
+    struct LoggedFrame
+    {
+        uint64_t timestampNs{0};
+        uint32_t stream{0};
+        Direction direction{Direction::Input};
+        uint16_t sequence{0};
+        // Length on the wire; only `captured` bytes were kept.
+        uint16_t length{0};
+        const uint8_t *data{nullptr};
+        size_t captured{0};
+    };
+    // A connection named in the logs; the address is IPv4 in network order, 0 if the device had none.
+    struct LoggedStream
+    {
+        uint32_t id{0};
+        std::string name;
+        uint32_t address{0};
+        uint32_t o2tConnectionId{0};
+        uint32_t t2oConnectionId{0};
+    };
+    using StreamVisitor = std::function<void(const LoggedStream &stream)>;
+    using FrameVisitor = std::function<void(const LoggedFrame &frame)>;
+
+    const TrafficRecorderConfig &config() const { return config_; }
+    TrafficRecorderStats stats() const;
+    // Exports the retained log files, oldest first.
+    bool exportPcapng(const std::string &path, std::string &error) const;
+    static bool exportPcapng(const std::vector<std::string> &logs, const std::string &path, std::string &error);
+    // Visits the logs in order, skipping files that are missing or not logs.
+    static void readLogs(const std::vector<std::string> &logs, const StreamVisitor &onStream,
+                         const FrameVisitor &onFrame);
+
+private:
+    enum class Kind : uint8_t
+    {
+        Stream = 1,
+        Frame = 2,
+    };
+
+    struct Slot
+    {
+        std::atomic<size_t> turn{0};
+        Kind kind{Kind::Frame};
+        Direction direction{Direction::Input};
+        uint16_t sequence{0};
+        uint16_t length{0};
+        uint16_t captured{0};
+        uint32_t stream{0};
+        uint64_t timestampNs{0};
+        std::array<uint8_t, kSnapBytes> data{};
+    };
+
+    TrafficRecorderConfig config_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_{0};
+    alignas(64) std::atomic<size_t> enqueue_{0};
+    alignas(64) size_t dequeue_{0};
+    std::atomic<bool> recording_{false};
+    std::atomic<uint32_t> nextStream_{1};
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::thread writer_;
+
+    // Owned by the writer thread while recording.
+    int fd_{-1};
+    uint8_t *map_{nullptr};
+    size_t used_{0};
+    uint64_t fileIndex_{0};
+
+    mutable std::mutex mutex_;
+    // Stream records by id, repeated at the head of every file so each file decodes on its own.
+    std::map<uint32_t, std::vector<uint8_t>> streams_;
+    std::deque<std::string> files_;
+    uint64_t bytesWritten_{0};
+    std::string lastError_;
+
+    bool push(Kind kind, uint32_t stream, Direction direction, uint16_t sequence, const uint8_t *data, size_t size);
+    void write();
+    bool drain();
+    bool append(const Slot &slot);
+    bool openFile(std::string &error);
+    void closeFile();
+};
@@ -0,0 +1,26 @@
+#include "TrafficRecorderProvider.h"
+
+#include <drogon/drogon.h>
+
+std::shared_ptr<TrafficRecorder> TrafficRecorderProvider::recorder_ = nullptr;
+
+std::shared_ptr<TrafficRecorder> TrafficRecorderProvider::instance()
+{
+    if (!recorder_)
+    {
+        const auto config = TrafficRecorderConfig::fromJson(drogon::app().getCustomConfig()["recorder"]);
+        recorder_ = std::make_shared<TrafficRecorder>(config);
+        std::string error;
+        if (config.enabled)
+        {
+            // A failure shows up as lastError in GET /api/recorder.
+            recorder_->start(error);
+        }
+    }
+    return recorder_;
+}
+
+void TrafficRecorderProvider::use(const std::shared_ptr<TrafficRecorder> &recorder)
+{
+    recorder_ = recorder;
+}
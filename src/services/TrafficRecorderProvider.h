@@ -0,0 +1,14 @@
+#pragma once
+
+#include "TrafficRecorder.h"
+#include <memory>
+
+class TrafficRecorderProvider
+{
+public:
+    static std::shared_ptr<TrafficRecorder> instance();
+    static void use(const std::shared_ptr<TrafficRecorder> &recorder);
+
+private:
+    static std::shared_ptr<TrafficRecorder> recorder_;
+};
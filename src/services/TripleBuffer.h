@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single-producer triple buffer. The producer fills back() and publishes it
+// with one atomic exchange; a consumer picks up the latest published frame
+// with another. Neither side ever waits on the other, and frames are reused
+// so publishing does not allocate. Consumers must be serialized externally.
+template <typename Frame>
+class TripleBuffer
+{
+public:
+    Frame &back() { return frames_[back_]; }
+
+    void publish()
+    {
+        const auto previous = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+        back_ = previous & kIndexMask;
+    }
+
+    const Frame &acquire()
+    {
+        if (middle_.load(std::memory_order_relaxed) & kFresh)
+        {
+            const auto previous = middle_.exchange(front_, std::memory_order_acq_rel);
+            front_ = previous & kIndexMask;
+        }
+        return frames_[front_];
+    }
+
+    // Only valid while both producer and consumers are excluded.
+    template <typename Fn>
+    void reset(Fn &&fn)
+    {
+        for (auto &frame : frames_)
+        {
+            fn(frame);
+        }
+        back_ = 0;
+        middle_.store(1, std::memory_order_release);
+        front_ = 2;
+    }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x03;
+    static constexpr uint8_t kFresh = 0x04;
+
+    std::array<Frame, 3> frames_{};
+    uint8_t back_{0};
+    std::atomic<uint8_t> middle_{1};
+    uint8_t front_{2};
+};
@@ -0,0 +1,168 @@
+#include "services/ConnectionLifecycleService.h"
+#include <cassert>
+#include <condition_variable>
+#include <iostream>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+Device makeDevice(const std::string &name, uint16_t port)
+{
+    Device device;
+    device.name = name;
+    device.ipAddress = "127.0.0.1";
+    device.port = port;
+    device.timeoutMs = 500;
+    ConnectionConfig connection;
+    connection.outputAssembly = {150, 8};
+    connection.inputAssembly = {100, 8};
+    connection.rpiUs = 10000;
+    device.connection = connection;
+    return device;
+}
+
+struct Waiter
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<ConnectionStatus> results;
+
+    ConnectionLifecycleService::Completion callback()
+    {
+        return [this](const ConnectionStatus &status) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(status);
+            cv.notify_all();
+        };
+    }
+
+    bool waitFor(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&]() { return results.size() >= count; });
+    }
+};
+} // namespace
+
+int main()
+{
+    {
+        // Same-key tasks run in order; other keys are not held up behind them.
+        SerialExecutor executor(2);
+        std::mutex mutex;
+        std::vector<int> order;
+        std::atomic<bool> release{false};
+        std::atomic<bool> otherRan{false};
+        executor.post("slow", [&]() {
+            while (!release)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(1);
+        });
+        executor.post("slow", [&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(2);
+        });
+        executor.post("fast", [&]() { otherRan = true; });
+        const auto start = Clock::now();
+        while (!otherRan && Clock::now() - start < std::chrono::seconds(2))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(otherRan);
+        release = true;
+        while (true)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (order.size() == 2)
+            {
+                break;
+            }
+        }
+        assert(order == std::vector<int>({1, 2}));
+    }
+
+    {
+        // Open returns before the session attempt; the failure arrives through status and the completion.
+        IoRuntimeConfig io;
+        io.threads = 1;
+        ConnectionLifecycleService service(io, std::make_shared<SessionPool>());
+        Waiter waiter;
+        std::string error;
+
+        Device missing = makeDevice("missing", 1);
+        missing.connection.reset();
+        assert(!service.open(missing, error) && !error.empty());
+
+        const auto start = Clock::now();
+        assert(service.open(makeDevice("refused", 1), error, waiter.callback()));
+        assert(Clock::now() - start < std::chrono::milliseconds(100));
+        assert(waiter.waitFor(1));
+        assert(!waiter.results[0].connected && !waiter.results[0].opening);
+        assert(!waiter.results[0].lastError.empty());
+
+        auto status = service.status("refused");
+        assert(status && !status->connected && !status->opening && !status->lastError.empty());
+
+        assert(service.close("refused", error, waiter.callback()));
+        assert(waiter.waitFor(2));
+        assert(!waiter.results[1].connected && !waiter.results[1].closing);
+        assert(!service.close("unknown", error));
+    }
+
+    {
+        // Bulk requests report one status per device in input order, including rejected ones.
+        IoRuntimeConfig io;
+        io.threads = 1;
+        io.controlThreads = 2;
+        ConnectionLifecycleService service(io, std::make_shared<SessionPool>());
+
+        std::vector<Device> devices;
+        for (int i = 0; i < 5; ++i)
+        {
+            devices.push_back(makeDevice("fleet-" + std::to_string(i), 1));
+        }
+        devices[2].connection.reset();
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::optional<std::vector<ConnectionStatus>> results;
+        auto collect = [&](const std::vector<ConnectionStatus> &statuses) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results = statuses;
+            cv.notify_all();
+        };
+        auto wait = [&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            assert(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return results.has_value(); }));
+            auto statuses = std::move(*results);
+            results.reset();
+            return statuses;
+        };
+
+        service.openAll(devices, 2, collect);
+        auto opened = wait();
+        assert(opened.size() == devices.size());
+        for (size_t i = 0; i < devices.size(); ++i)
+        {
+            assert(opened[i].deviceName == devices[i].name);
+            assert(!opened[i].connected && !opened[i].opening && !opened[i].lastError.empty());
+        }
+        assert(opened[2].lastError == "Device has no connection configuration");
+
+        service.closeAll({"fleet-0", "fleet-1", "unknown"}, 0, collect);
+        auto closed = wait();
+        assert(closed.size() == 3);
+        assert(!closed[0].connected && closed[0].lastError.empty());
+        assert(closed[2].deviceName == "unknown" && !closed[2].lastError.empty());
+
+        service.openAll({}, 4, collect);
+        assert(wait().empty());
+    }
+
+    std::cout << "Connection lifecycle tests passed" << std::endl;
+    return 0;
+}
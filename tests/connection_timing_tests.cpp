@@ -0,0 +1,134 @@
+#include "services/ConnectionRuntime.h"
+#include <cassert>
+#include <iostream>
+
+int main()
+{
+    {
+        // Buckets tile the range without gaps and hold the values they claim.
+        for (size_t i = 0; i + 1 < TimingHistogram::kBucketCount; ++i)
+        {
+            assert(TimingHistogram::bucketHigh(i) + 1 == TimingHistogram::bucketLow(i + 1));
+            assert(TimingHistogram::bucketOf(TimingHistogram::bucketLow(i)) == i);
+            assert(TimingHistogram::bucketOf(TimingHistogram::bucketHigh(i)) == i);
+        }
+        assert(TimingHistogram::bucketOf(63) == 63);
+        assert(TimingHistogram::bucketOf(uint64_t{1} << 40) == TimingHistogram::kBucketCount - 1);
+
+        // Resolution stays within about 3% of the value.
+        for (uint64_t value : {100u, 1000u, 10000u, 123456u})
+        {
+            const auto bucket = TimingHistogram::bucketOf(value);
+            const auto width = TimingHistogram::bucketHigh(bucket) - TimingHistogram::bucketLow(bucket) + 1;
+            assert(width * 32 <= value);
+        }
+    }
+
+    {
+        TimingHistogram histogram;
+        assert(histogram.percentile(0.5) == 0);
+        for (uint64_t i = 1; i <= 1000; ++i)
+        {
+            histogram.record(i < 990 ? 10000 : 25000);
+        }
+        assert(histogram.count() == 1000);
+        assert(histogram.percentile(0.5) >= 10000 && histogram.percentile(0.5) < 10300);
+        assert(histogram.percentile(0.999) == 25000);
+
+        const auto json = histogram.toJson();
+        assert(json["minUs"].asUInt64() == 10000);
+        assert(json["maxUs"].asUInt64() == 25000);
+        assert(json["buckets"].size() == 2);
+        assert(json["buckets"][1]["count"].asUInt64() == 11);
+    }
+
+    {
+        // Deviation follows O->T sends against the configured RPI.
+        ConnectionTiming timing(10000);
+        ConnectionTiming::Clock::time_point start{std::chrono::seconds(5)};
+        timing.sent(start);
+        timing.sent(start + std::chrono::microseconds(10040));
+        timing.sent(start + std::chrono::microseconds(19990));
+        timing.received(start + std::chrono::microseconds(500));
+        timing.received(start + std::chrono::microseconds(10600));
+
+        const auto json = timing.toJson();
+        assert(json["rpiUs"].asUInt() == 10000);
+        assert(json["interSend"]["count"].asUInt64() == 2);
+        assert(json["interArrival"]["count"].asUInt64() == 1);
+        assert(json["interArrival"]["minUs"].asUInt64() == 10100);
+        assert(json["rpiDeviation"]["minUs"].asUInt64() == 40);
+        assert(json["rpiDeviation"]["maxUs"].asUInt64() == 50);
+    }
+
+    {
+        // The timing view handed to the timing route keeps the runtime alive.
+        auto runtime = std::make_shared<ConnectionRuntime>(2000);
+        auto timing = ConnectionRuntime::timing(runtime);
+        assert(!runtime->lastActivity().has_value());
+        const auto now = ConnectionRuntime::Clock::now();
+        runtime->sent(now);
+        runtime->received(now, 1, 8);
+        runtime->received(now + std::chrono::microseconds(2000), 2, 9);
+        assert(runtime->packetsSent() == 1 && runtime->packetsReceived() == 2);
+        runtime.reset();
+
+        assert(timing->toJson()["interArrival"]["count"].asUInt64() == 1);
+        assert(!ConnectionRuntime::timing(nullptr));
+    }
+
+    {
+        ConnectionRuntime runtime(2000);
+        runtime.received(ConnectionRuntime::Clock::now(), 7, 4);
+        assert(runtime.packetsReceived() == 1 && runtime.sequence().lastSequence() == 4);
+        assert(runtime.encapsulationSequence().lastSequence() == 7);
+        const auto age = std::chrono::system_clock::now() - *runtime.lastActivity();
+        assert(age >= std::chrono::seconds(-1) && age < std::chrono::seconds(1));
+        assert(!runtime.isClosedByTarget());
+        runtime.closedByTarget();
+        assert(runtime.isClosedByTarget());
+    }
+
+    {
+        // Gaps count as lost until a late packet fills them; repeats are duplicates.
+        SequenceTracker tracker;
+        for (uint16_t sequence : {10, 11, 14, 12, 12, 11, 15})
+        {
+            tracker.observe(sequence);
+        }
+        assert(tracker.lastSequence() == 15);
+        assert(tracker.lost() == 1 && tracker.stale() == 1 && tracker.duplicates() == 2);
+
+        // The count wraps; packets from before the first one or beyond the window are only stale.
+        SequenceTracker wrapping;
+        for (uint16_t sequence : {65534, 65535, 0, 2, 65000, 65533})
+        {
+            wrapping.observe(sequence);
+        }
+        assert(wrapping.lastSequence() == 2);
+        assert(wrapping.lost() == 1 && wrapping.stale() == 2 && wrapping.duplicates() == 0);
+
+        // The encapsulation sequence number wraps at 32 bits.
+        EncapsulationSequenceTracker encapsulation;
+        for (uint32_t sequence : {0xFFFFFFFEu, 0xFFFFFFFFu, 1u, 0u, 0u, 0x90000000u})
+        {
+            encapsulation.observe(sequence);
+        }
+        assert(encapsulation.lastSequence() == 1);
+        assert(encapsulation.lost() == 0 && encapsulation.stale() == 2 && encapsulation.duplicates() == 1);
+    }
+
+    {
+        // A target repeating its CIP count for unchanged data still numbers every datagram.
+        ConnectionRuntime runtime(2000);
+        const auto now = ConnectionRuntime::Clock::now();
+        runtime.received(now, 10, 3);
+        runtime.received(now, 11, 3);
+        runtime.received(now, 13, 4);
+        assert(runtime.sequence().duplicates() == 1 && runtime.sequence().lost() == 0);
+        assert(runtime.encapsulationSequence().duplicates() == 0 && runtime.encapsulationSequence().lost() == 1);
+    }
+
+    std::cout << "Connection timing tests passed" << std::endl;
+    return 0;
+}
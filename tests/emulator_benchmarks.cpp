@@ -0,0 +1,130 @@
+#include "emulator/AdapterEmulator.h"
+#include "services/ConnectionLifecycleService.h"
+#include "services/EIPExplicitMessageService.h"
+#include "services/LoadTestService.h"
+#include <algorithm>
+#include <cassert>
+#include <future>
+#include <iostream>
+
+// End-to-end numbers against the loopback emulator, so CI tracks the whole
+// stack (sessions, encapsulation, UDP reactor) and not just the codecs.
+int main()
+{
+    constexpr int kRequests = 2000;
+    constexpr uint32_t kConnections = 8;
+    constexpr uint32_t kRpiUs = 2000;
+    constexpr auto kHold = std::chrono::seconds(2);
+
+    AdapterEmulatorConfig config;
+    config.assemblies = {{100, 64}, {150, 64}};
+    AdapterEmulator emulator(config);
+    std::string error;
+    assert(emulator.start(error));
+
+    Device device;
+    device.name = "bench";
+    device.ipAddress = "127.0.0.1";
+    device.port = emulator.tcpPort();
+    device.timeoutMs = 1000;
+    ConnectionConfig connection;
+    connection.outputAssembly = {150, 64};
+    connection.inputAssembly = {100, 64};
+    connection.rpiUs = kRpiUs;
+    // A 32 ms timeout keeps a scheduling stall on a shared runner from dropping connections mid-run.
+    connection.timeoutMultiplier = 2;
+    device.connection = connection;
+    auto sessions = std::make_shared<SessionPool>();
+
+    {
+        EIPExplicitMessageService explicitMessages(sessions);
+        ExplicitMessageRequest request;
+        request.serviceCode = 0x0E;
+        request.classId = 0x04;
+        request.instanceId = 100;
+        request.attributeId = 3;
+        assert(explicitMessages.sendExplicit(device, request, error));
+
+        std::vector<int64_t> latencies;
+        latencies.reserve(kRequests);
+        for (int i = 0; i < kRequests; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const auto result = explicitMessages.sendExplicit(device, request, error);
+            latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count());
+            assert(result && result->generalStatus == 0);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "explicit get_attribute_single (" << kRequests << " requests): p50 "
+                  << latencies[latencies.size() / 2] << " us, p99 " << latencies[latencies.size() * 99 / 100]
+                  << " us" << std::endl;
+    }
+
+    {
+        IoRuntimeConfig io;
+        io.threads = 2;
+        ConnectionLifecycleService connections(io, sessions);
+        LoadTestSpec spec;
+        spec.count = kConnections;
+        const auto originators = LoadTestService::expand(device, spec);
+
+        std::promise<std::vector<ConnectionStatus>> opened;
+        connections.openAll(originators, 0,
+                            [&opened](const std::vector<ConnectionStatus> &statuses) { opened.set_value(statuses); });
+        for (const auto &status : opened.get_future().get())
+        {
+            assert(status.connected);
+        }
+
+        struct Totals
+        {
+            uint64_t sent{0};
+            uint64_t received{0};
+            uint64_t lost{0};
+        };
+        auto totals = [&]() {
+            Totals sum;
+            for (const auto &originator : originators)
+            {
+                const auto status = *connections.status(originator.name);
+                sum.sent += status.packetsSent;
+                sum.received += status.packetsReceived;
+                sum.lost += status.encapsulationLost;
+            }
+            return sum;
+        };
+        const auto before = totals();
+        const auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(kHold);
+        const auto after = totals();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // T->O is paced by the emulator, so only the O->T rate measures the I/O threads.
+        const double sendRate = static_cast<double>(after.sent - before.sent) / seconds;
+        const double receiveRate = static_cast<double>(after.received - before.received) / seconds;
+        const double expected = kConnections * 1e6 / kRpiUs;
+        std::cout << "class 1 (" << kConnections << " connections, " << kRpiUs << " us RPI, 64 bytes): O->T "
+                  << sendRate << " and T->O " << receiveRate << " packets/s of " << expected << " expected, "
+                  << after.lost << " lost, " << emulator.stats().timeouts << " timeouts" << std::endl;
+        assert(emulator.stats().timeouts == 0);
+        assert(sendRate >= expected * 0.9);
+        for (const auto &originator : originators)
+        {
+            assert(connections.status(originator.name)->packetsReceived > 0);
+        }
+
+        std::vector<std::string> names;
+        for (const auto &originator : originators)
+        {
+            names.push_back(originator.name);
+        }
+        std::promise<void> closed;
+        connections.closeAll(names, 0, [&closed](const std::vector<ConnectionStatus> &) { closed.set_value(); });
+        closed.get_future().wait();
+    }
+
+    emulator.stop();
+    return 0;
+}
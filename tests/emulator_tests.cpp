@@ -0,0 +1,363 @@
+#include "emulator/AdapterEmulator.h"
+#include "services/ConnectionLifecycleService.h"
+#include "services/EIPExplicitMessageService.h"
+#include "services/EIPIdentityService.h"
+#include "services/LoadTestService.h"
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace
+{
+Device makeDevice(uint16_t port)
+{
+    Device device;
+    device.name = "emulated";
+    device.ipAddress = "127.0.0.1";
+    device.port = port;
+    device.timeoutMs = 1000;
+    ConnectionConfig connection;
+    connection.outputAssembly = {150, 8};
+    connection.inputAssembly = {100, 8};
+    connection.rpiUs = 10000;
+    device.connection = connection;
+    return device;
+}
+
+template <typename Predicate> bool waitFor(Predicate predicate)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!predicate())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    AdapterEmulator emulator;
+    std::string error;
+    assert(emulator.start(error));
+    assert(!emulator.start(error));
+    const auto device = makeDevice(emulator.tcpPort());
+    auto sessions = std::make_shared<SessionPool>();
+
+    {
+        EIPIdentityService identity(sessions);
+        const auto result = identity.readIdentity(device, error);
+        assert(result);
+        assert(result->vendorId == 0xFFFE && result->deviceType == 0x0C);
+        assert(result->serialNumber == 0x00C1A55E);
+        assert(result->productName == "cipMasterWeb adapter emulator");
+    }
+
+    {
+        EIPExplicitMessageService explicitMessages(sessions);
+        ExplicitMessageRequest request;
+        request.serviceCode = 0x10;
+        request.classId = 0x04;
+        request.instanceId = 150;
+        request.attributeId = 3;
+        request.payload = {1, 2, 3, 4, 5, 6, 7, 8};
+        auto result = explicitMessages.sendExplicit(device, request, error);
+        assert(result && result->generalStatus == 0);
+        assert(emulator.assembly(150) == request.payload);
+
+        request.serviceCode = 0x0E;
+        request.payload.clear();
+        result = explicitMessages.sendExplicit(device, request, error);
+        assert(result && result->generalStatus == 0 && result->responseData == emulator.assembly(150));
+
+        // Wrong sizes and unknown objects come back as CIP errors, not transport failures.
+        request.serviceCode = 0x10;
+        request.payload = {1, 2};
+        result = explicitMessages.sendExplicit(device, request, error);
+        assert(result && result->generalStatus == 0x13);
+        request.instanceId = 999;
+        result = explicitMessages.sendExplicit(device, request, error);
+        assert(result && result->generalStatus == 0x05);
+        // Both services shared one pooled session.
+        assert(emulator.stats().sessions == 1);
+    }
+
+    {
+        IoRuntimeConfig io;
+        io.threads = 1;
+        TrafficRecorderConfig recording;
+        recording.directory =
+            (std::filesystem::temp_directory_path() / ("emulator-tests-" + std::to_string(::getpid()))).string();
+        auto recorder = std::make_shared<TrafficRecorder>(recording);
+        assert(recorder->start(error));
+        ConnectionLifecycleService connections(io, sessions, recorder);
+        emulator.setAssembly(100, {9, 8, 7, 6, 5, 4, 3, 2});
+        assert(connections.open(device, error));
+        assert(waitFor([&]() { return connections.status(device.name)->connected; }));
+        assert(emulator.stats().connections == 1);
+
+        // Opening a live connection again changes nothing, not even its mappings.
+        auto reopened = device;
+        SignalMapping extra;
+        extra.name = "extra";
+        reopened.signals.push_back(extra);
+        bool completed = false;
+        assert(connections.open(reopened, error, [&](const ConnectionStatus &status) {
+            completed = status.connected;
+        }));
+        assert(completed);
+        assert(IOSignalServiceProvider::instance()->mappings(device.name).size() == device.signals.size());
+
+        // Class 1 traffic flows both ways with in-order sequence counts.
+        assert(waitFor([&]() {
+            const auto status = connections.status(device.name);
+            return status->packetsReceived >= 10 && status->packetsSent >= 10;
+        }));
+        assert(waitFor([&]() { return emulator.stats().packetsConsumed >= 10; }));
+        const auto status = *connections.status(device.name);
+        assert(status.packetsLost == 0 && status.packetsDuplicated == 0 && status.packetsStale == 0);
+        assert(status.lastEncapsulationSequence >= 10 && status.encapsulationLost == 0 &&
+               status.encapsulationDuplicated == 0 && status.encapsulationStale == 0);
+
+        // Both directions went through the recorder.
+        recorder->stop();
+        assert(recorder->stats().frames >= 20 && recorder->stats().dropped == 0);
+        // The log names the connection by the ids the emulator's ForwardOpen reply assigned.
+        bool named = false;
+        TrafficRecorder::readLogs(
+            recorder->stats().files,
+            [&](const TrafficRecorder::LoggedStream &stream) {
+                named = named || (stream.name == device.name && stream.o2tConnectionId >= 0x10000 &&
+                                  stream.t2oConnectionId != 0 && stream.t2oConnectionId != stream.o2tConnectionId);
+            },
+            [](const TrafficRecorder::LoggedFrame &) {});
+        assert(named);
+        std::filesystem::remove_all(recording.directory);
+
+        assert(connections.close(device.name, error));
+        assert(waitFor([&]() { return emulator.stats().connections == 0 && !connections.status(device.name)->closing; }));
+        assert(emulator.stats().forwardOpens == 1 && emulator.stats().forwardCloses == 1);
+        assert(emulator.stats().timeouts == 0);
+
+        // A connection the target dropped is replaced, not left registered next to the new one.
+        assert(connections.open(device, error));
+        assert(waitFor([&]() { return connections.status(device.name)->connected; }));
+        const auto transport = Class1Transport::instance();
+        assert(transport->connections() == 1);
+        assert(emulator.dropConnections() == 1);
+        assert(waitFor([&]() { return connections.status(device.name)->lastError == "Connection closed by target"; }));
+        assert(connections.open(device, error));
+        assert(waitFor([&]() {
+            const auto status = connections.status(device.name);
+            return status->connected && status->packetsReceived > 0;
+        }));
+        assert(transport->connections() == 1);
+        assert(connections.close(device.name, error));
+        assert(waitFor([&]() { return transport->connections() == 0 && emulator.stats().connections == 0; }));
+    }
+
+    {
+        // O->T goes out once per RPI, measured by the connection's own send timing.
+        IoRuntimeConfig io;
+        io.threads = 1;
+        ConnectionLifecycleService connections(io, sessions);
+        auto fast = device;
+        fast.connection->rpiUs = 2000;
+        // A 32 ms timeout rides out scheduling stalls on a busy single-core box.
+        fast.connection->timeoutMultiplier = 2;
+        assert(connections.open(fast, error));
+        assert(waitFor([&]() { return connections.status(fast.name)->packetsSent >= 250; }));
+        const auto interSend = connections.timing(fast.name)->toJson()["interSend"];
+        const auto p50 = interSend["p50Us"].asUInt64();
+        std::cout << "2000 us RPI: interSend p50 " << p50 << " us over " << interSend["count"].asUInt64()
+                  << " packets" << std::endl;
+        assert(p50 >= 1900 && p50 <= 2100);
+        assert(connections.status(fast.name)->packetsReceived >= 200);
+
+        assert(connections.close(fast.name, error));
+        assert(waitFor([&]() { return emulator.stats().connections == 0; }));
+        assert(emulator.stats().timeouts == 0);
+    }
+
+    {
+        // Virtual originators share UDP 2222, and each one gets its own T->O traffic.
+        IoRuntimeConfig io;
+        io.threads = 2;
+        ConnectionLifecycleService connections(io, sessions);
+        LoadTestSpec spec;
+        spec.count = 4;
+        const auto originators = LoadTestService::expand(device, spec);
+        std::atomic<bool> opened{false};
+        connections.openAll(originators, 0, [&](const std::vector<ConnectionStatus> &statuses) {
+            for (const auto &status : statuses)
+            {
+                assert(status.connected);
+            }
+            opened = true;
+        });
+        assert(waitFor([&]() { return opened.load(); }));
+        assert(emulator.stats().connections == originators.size());
+        assert(waitFor([&]() {
+            for (const auto &originator : originators)
+            {
+                if (connections.status(originator.name)->packetsReceived < 20)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }));
+        for (const auto &originator : originators)
+        {
+            const auto status = *connections.status(originator.name);
+            assert(status.connected && status.packetsLost == 0 && status.packetsDuplicated == 0);
+        }
+
+        // A load test ramp over the same originators keeps every one of them connected.
+        for (const auto &originator : originators)
+        {
+            assert(connections.close(originator.name, error));
+        }
+        assert(waitFor([&]() { return emulator.stats().connections == 0; }));
+        LoadTestService load(connections);
+        spec.step = 2;
+        spec.holdMs = 200;
+        assert(load.start(device, spec, error));
+        assert(waitFor([&]() { return load.report().state != "running"; }));
+        const auto report = load.report();
+        assert(report.state == "finished" && report.steps.size() == 2);
+        assert(report.steps[1].connected == 4 && report.steps[1].dropped == 0);
+        assert(!report.saturationAt && report.maxStable == 4);
+        assert(waitFor([&]() { return emulator.stats().connections == 0; }));
+        assert(emulator.stats().timeouts == 0);
+    }
+
+    {
+        // Connections with mixed RPIs are spread over every I/O thread, and each keeps its own RPI.
+        IoRuntimeConfig io;
+        io.threads = 3;
+        ConnectionLifecycleService connections(io, sessions);
+        LoadTestSpec spec;
+        spec.count = 12;
+        spec.rpiUs = {2000, 5000, 10000};
+        auto mixed = device;
+        mixed.connection->timeoutMultiplier = 2;
+        const auto originators = LoadTestService::expand(mixed, spec);
+        std::atomic<bool> opened{false};
+        connections.openAll(originators, 0, [&](const std::vector<ConnectionStatus> &statuses) {
+            for (const auto &status : statuses)
+            {
+                assert(status.connected);
+            }
+            opened = true;
+        });
+        assert(waitFor([&]() { return opened.load(); }));
+
+        const auto threads = connections.ioThreads();
+        assert(threads.size() == 3);
+        double lightest = threads.front().packetsPerSecond;
+        double heaviest = lightest;
+        for (const auto &thread : threads)
+        {
+            assert(thread.connections > 0);
+            lightest = std::min(lightest, thread.packetsPerSecond);
+            heaviest = std::max(heaviest, thread.packetsPerSecond);
+        }
+        assert(heaviest <= 2 * lightest);
+
+        assert(waitFor([&]() {
+            for (const auto &originator : originators)
+            {
+                if (connections.status(originator.name)->packetsReceived < 50)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }));
+        for (const auto &originator : originators)
+        {
+            const auto status = *connections.status(originator.name);
+            assert(status.connected && status.ioThread >= 0);
+            const auto rpi = originator.connection->rpiUs;
+            const auto p50 = connections.timing(originator.name)->toJson()["interSend"]["p50Us"].asUInt64();
+            assert(p50 >= rpi * 9 / 10 && p50 <= rpi * 11 / 10);
+        }
+
+        std::vector<std::string> names;
+        for (const auto &originator : originators)
+        {
+            names.push_back(originator.name);
+        }
+        std::atomic<bool> closed{false};
+        connections.closeAll(names, 0, [&](const std::vector<ConnectionStatus> &) { closed = true; });
+        assert(waitFor([&]() { return closed.load() && emulator.stats().connections == 0; }));
+        assert(emulator.stats().timeouts == 0);
+    }
+
+    {
+        // openAll brings up a fleet of devices that stay connected and keep receiving.
+        IoRuntimeConfig io;
+        io.threads = 2;
+        io.controlThreads = 2;
+        ConnectionLifecycleService connections(io, sessions);
+        std::vector<Device> fleet;
+        std::vector<std::string> names;
+        for (int i = 1; i <= 5; ++i)
+        {
+            auto car = device;
+            car.name = "car-" + std::to_string(i);
+            car.connection->timeoutMultiplier = 2;
+            fleet.push_back(car);
+            names.push_back(car.name);
+        }
+        std::vector<ConnectionStatus> results;
+        std::atomic<bool> opened{false};
+        connections.openAll(fleet, 2, [&](const std::vector<ConnectionStatus> &statuses) {
+            results = statuses;
+            opened = true;
+        });
+        assert(waitFor([&]() { return opened.load(); }));
+        assert(results.size() == fleet.size());
+        for (size_t i = 0; i < fleet.size(); ++i)
+        {
+            assert(results[i].deviceName == fleet[i].name && results[i].connected);
+        }
+        assert(emulator.stats().connections == fleet.size());
+
+        // Twenty RPIs later every device is still connected and has received more.
+        std::vector<uint64_t> received;
+        for (const auto &name : names)
+        {
+            received.push_back(connections.status(name)->packetsReceived);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(20 * device.connection->rpiUs));
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            const auto status = *connections.status(names[i]);
+            assert(status.connected && status.lastError.empty());
+            assert(status.packetsReceived >= received[i] + 10);
+        }
+
+        std::atomic<bool> closed{false};
+        connections.closeAll(names, 2, [&](const std::vector<ConnectionStatus> &statuses) {
+            for (const auto &status : statuses)
+            {
+                assert(!status.connected && status.lastError.empty());
+            }
+            closed = true;
+        });
+        assert(waitFor([&]() { return closed.load() && emulator.stats().connections == 0; }));
+        assert(emulator.stats().timeouts == 0);
+    }
+
+    emulator.stop();
+    std::cout << "Emulator tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,274 @@
+#include "services/IOSignalService.h"
+#include "services/SignalPlan.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace
+{
+std::atomic<size_t> allocations{0};
+
+SignalMapping makeMapping(const std::string &name, SignalDirection direction, SignalType type, uint16_t byteOffset)
+{
+    SignalMapping mapping;
+    mapping.name = name;
+    mapping.direction = direction;
+    mapping.type = type;
+    mapping.byteOffset = byteOffset;
+    return mapping;
+}
+
+// Every replaceable allocation and deallocation function goes through these
+// two, so each new/delete pair matches.
+void *countedAlloc(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+// Kept out of line: inlined into a caller, g++ would see free() on a pointer
+// from operator new and warn, although the two match here.
+[[gnu::noinline]] void countedFree(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    if (void *ptr = countedAlloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    if (void *ptr = countedAlloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    countedFree(ptr);
+}
+
+int main()
+{
+    constexpr uint16_t kAssemblyBytes = 512;
+    constexpr int kSignals = 300;
+    constexpr int kPackets = 20000;
+
+    IOSignalService service;
+    std::vector<SignalMapping> mappings;
+    for (int i = 0; i < kSignals; ++i)
+    {
+        const auto direction = i % 2 == 0 ? SignalDirection::Input : SignalDirection::Output;
+        const auto type = i % 3 == 0 ? SignalType::UInt16 : SignalType::UInt8;
+        mappings.push_back(makeMapping("SIG_" + std::to_string(i), direction, type, static_cast<uint16_t>(i)));
+    }
+    service.applyMappings("Bench", mappings);
+    auto device = service.attach("Bench");
+
+    ConnectionConfig config;
+    config.inputAssembly = {101, kAssemblyBytes};
+    config.outputAssembly = {100, kAssemblyBytes};
+    config.useLargeForwardOpen = true;
+    service.configureAssemblies(device, config);
+
+    std::vector<uint8_t> input(kAssemblyBytes, 0x5A);
+    std::vector<uint8_t> output(kAssemblyBytes, 0);
+
+    // Warm up once so every frame has been touched before counting.
+    for (int i = 0; i < 4; ++i)
+    {
+        service.consumeInputBytes(device, input);
+        service.fillOutputBytes(device, output);
+    }
+
+    auto run = [&](const char *label, bool writeOutput) {
+        const auto before = allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kPackets; ++i)
+        {
+            input[0] = static_cast<uint8_t>(i);
+            service.consumeInputBytes(device, input);
+            if (writeOutput)
+            {
+                service.setOutputValue("Bench", IOSignalService::SignalHandle{1}, static_cast<double>(i % 200));
+            }
+            service.fillOutputBytes(device, output);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto steadyAllocations = allocations.load() - before;
+
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        std::cout << label << " (" << kSignals << " signals, " << kAssemblyBytes << " bytes): " << ns / kPackets
+                  << " ns/packet, " << steadyAllocations << " allocations" << std::endl;
+        assert(steadyAllocations == 0);
+    };
+
+    run("io cycle, outputs idle", false);
+    run("io cycle, one output written", true);
+    assert(output.size() == kAssemblyBytes);
+    assert(output[1] == (kPackets - 1) % 200);
+
+    {
+        // 200 outputs animated by generators: every send re-evaluates and re-encodes all of them.
+        constexpr int kGenerated = 200;
+        IOSignalService generated;
+        std::vector<SignalMapping> waves;
+        for (int i = 0; i < kGenerated; ++i)
+        {
+            auto mapping = makeMapping("WAVE_" + std::to_string(i), SignalDirection::Output, SignalType::Real32,
+                                       static_cast<uint16_t>(4 * i));
+            mapping.generator = SignalGenerator();
+            mapping.generator->type = i % 2 == 0 ? GeneratorType::Sine : GeneratorType::Ramp;
+            mapping.generator->high = 100.0;
+            mapping.generator->periodMs = 500;
+            mapping.generator->phase = static_cast<double>(i) / kGenerated;
+            waves.push_back(mapping);
+        }
+        generated.applyMappings("Waves", waves);
+        auto waveDevice = generated.attach("Waves");
+        config.outputAssembly = {100, 4 * kGenerated};
+        generated.configureAssemblies(waveDevice, config);
+        std::vector<uint8_t> frame(4 * kGenerated, 0);
+        generated.fillOutputBytes(waveDevice, frame);
+
+        const auto before = allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kPackets; ++i)
+        {
+            generated.fillOutputBytes(waveDevice, frame);
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        const auto steadyAllocations = allocations.load() - before;
+        std::cout << "send with " << kGenerated << " generated outputs: " << ns / kPackets << " ns/packet, "
+                  << steadyAllocations << " allocations" << std::endl;
+        assert(steadyAllocations == 0);
+    }
+
+    {
+        // 64 rules on one device reading another's inputs: evaluated by the receiving thread, sent next frame.
+        constexpr int kRules = 64;
+        IOSignalService linked;
+        std::vector<SignalMapping> inputs;
+        std::vector<SignalMapping> logic;
+        for (int i = 0; i < kRules; ++i)
+        {
+            inputs.push_back(makeMapping("IN_" + std::to_string(i), SignalDirection::Input, SignalType::UInt8,
+                                         static_cast<uint16_t>(i)));
+            auto output = makeMapping("OUT_" + std::to_string(i), SignalDirection::Output, SignalType::UInt8,
+                                      static_cast<uint16_t>(i));
+            output.rule = SignalRule{"", "Rack:IN_" + std::to_string(i) + " > 100 && Rack:IN_" +
+                                             std::to_string((i + 1) % kRules) + " * 2 < 400"};
+            logic.push_back(output);
+        }
+        linked.applyMappings("Rack", inputs);
+        linked.applyMappings("Logic", logic);
+        auto rack = linked.attach("Rack");
+        auto controller = linked.attach("Logic");
+        std::vector<uint8_t> packet(kRules, 0);
+        std::vector<uint8_t> frame(kRules, 0);
+        linked.consumeInputBytes(rack, packet);
+        linked.fillOutputBytes(controller, frame);
+
+        const auto before = allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kPackets; ++i)
+        {
+            packet[0] = static_cast<uint8_t>(i);
+            linked.consumeInputBytes(rack, packet);
+            linked.fillOutputBytes(controller, frame);
+            assert(frame[0] == (packet[0] > 100 ? 1 : 0));
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        const auto steadyAllocations = allocations.load() - before;
+        std::cout << "io cycle with " << kRules << " rules: " << ns / kPackets << " ns/packet, " << steadyAllocations
+                  << " allocations" << std::endl;
+        assert(steadyAllocations == 0);
+    }
+
+    // Packed rail-style assembly: 256 bytes of BOOL bits followed by 128 UINT16 words.
+    std::vector<SignalMapping> packed;
+    for (int bit = 0; bit < 256 * 8; ++bit)
+    {
+        auto mapping = makeMapping("BIT_" + std::to_string(bit), SignalDirection::Input, SignalType::Bool,
+                                   static_cast<uint16_t>(bit / 8));
+        mapping.bitOffset = static_cast<uint8_t>(bit % 8);
+        packed.push_back(mapping);
+    }
+    for (int word = 0; word < 128; ++word)
+    {
+        packed.push_back(makeMapping("WORD_" + std::to_string(word), SignalDirection::Input, SignalType::UInt16,
+                                     static_cast<uint16_t>(256 + 2 * word)));
+    }
+    std::vector<uint8_t> packet(kAssemblyBytes);
+    for (size_t i = 0; i < packet.size(); ++i)
+    {
+        packet[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    std::vector<double> values(packed.size());
+
+    auto decode = [&](const char *label, const SignalKernels *kernels) {
+        const auto plan = SignalDecodePlan::compile(packed, kernels);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kPackets; ++i)
+        {
+            packet[0] = static_cast<uint8_t>(i);
+            plan.run(packet.data(), packet.size(), values.data());
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "decode " << packed.size() << " packed signals, " << label << ": " << ns / kPackets << " ns/packet"
+                  << std::endl;
+    };
+    decode("per signal", nullptr);
+    for (const auto *kernels : SignalKernels::available())
+    {
+        decode(kernels->name, kernels);
+    }
+    return 0;
+}
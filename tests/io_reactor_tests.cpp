@@ -0,0 +1,219 @@
+#include "services/IOReactorPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct FakeConnection
+{
+    std::mutex mutex;
+    std::vector<Clock::time_point> polls;
+
+    void poll()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        polls.push_back(Clock::now());
+    }
+
+    size_t count()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return polls.size();
+    }
+};
+} // namespace
+
+int main()
+{
+    {
+        // A 2 ms connection is polled once per period, not on a fixed sleep.
+        IOReactor reactor;
+        FakeConnection conn;
+        reactor.attach("fast", [&conn]() { conn.poll(); }, std::chrono::microseconds(2000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        reactor.detach("fast");
+
+        std::lock_guard<std::mutex> lock(conn.mutex);
+        const auto cycles = conn.polls.size();
+        assert(cycles >= 60 && cycles <= 102);
+        // Median rather than mean: a loaded machine can stall the odd wakeup.
+        std::vector<long> periods;
+        for (size_t i = 1; i < cycles; ++i)
+        {
+            periods.push_back(
+                std::chrono::duration_cast<std::chrono::microseconds>(conn.polls[i] - conn.polls[i - 1]).count());
+        }
+        std::nth_element(periods.begin(), periods.begin() + periods.size() / 2, periods.end());
+        const auto medianUs = periods[periods.size() / 2];
+        assert(medianUs >= 1900 && medianUs <= 2300);
+        // Never twice in one slot. A poll after a late wake comes early to get back on the schedule,
+        // so only the whole run is bounded, not the gap between two polls.
+        const auto spanUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(conn.polls.back() - conn.polls.front()).count();
+        assert(static_cast<long>(cycles - 1) <= spanUs / 2000 + 1);
+        std::cout << "2 ms task: " << cycles << " cycles, median period " << medianUs << " us" << std::endl;
+    }
+
+    {
+        // Nothing runs after detach returns.
+        IOReactor reactor;
+        FakeConnection conn;
+        reactor.attach("dev", [&conn]() { conn.poll(); }, std::chrono::microseconds(20000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        reactor.detach("dev");
+        const auto polls = conn.count();
+        assert(polls >= 4 && polls <= 6);
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        assert(conn.count() == polls);
+    }
+
+    {
+        // Re-attaching under the same name replaces the task.
+        IOReactor reactor;
+        FakeConnection first;
+        FakeConnection second;
+        reactor.attach("dev", [&first]() { first.poll(); }, std::chrono::microseconds(1000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        reactor.attach("dev", [&second]() { second.poll(); }, std::chrono::microseconds(1000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const auto firstPolls = first.count();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        reactor.detach("dev");
+        assert(first.count() == firstPolls);
+        assert(second.count() > 0);
+    }
+
+    {
+        // Input runs on the reactor thread as soon as its fd is readable, not at the next slot.
+        IOReactor reactor;
+        const int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        assert(fd >= 0);
+        std::mutex mutex;
+        std::thread::id pollThread;
+        std::thread::id inputThread;
+        std::atomic<int> inputs{0};
+        reactor.attach(
+            "dev",
+            [&]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                pollThread = std::this_thread::get_id();
+            },
+            std::chrono::seconds(10), fd,
+            [&]() {
+                uint64_t count;
+                while (::read(fd, &count, sizeof(count)) == sizeof(count))
+                {
+                    inputs++;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                inputThread = std::this_thread::get_id();
+            });
+        const uint64_t one = 1;
+        for (int i = 1; i <= 3; ++i)
+        {
+            assert(::write(fd, &one, sizeof(one)) == sizeof(one));
+            const auto deadline = Clock::now() + std::chrono::seconds(1);
+            while (inputs < i && Clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            assert(inputs == i);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            assert(inputThread == pollThread && inputThread != std::this_thread::get_id());
+        }
+
+        // Once detached the fd is no longer watched.
+        reactor.detach("dev");
+        assert(::write(fd, &one, sizeof(one)) == sizeof(one));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assert(inputs == 3);
+        ::close(fd);
+    }
+
+    {
+        // Connections are balanced by packets per second and keep their thread.
+        Json::Value io;
+        io["threads"] = 2;
+        io["cpus"].append(0);
+        io["cpus"].append(-3);
+        const auto config = IoRuntimeConfig::fromJson(io);
+        assert(config.threadCount() == 2 && config.cpus == std::vector<int>({0}));
+
+        IOReactorPool pool(config);
+        auto noop = []() {};
+        const std::chrono::microseconds fast(1000);
+        const std::chrono::microseconds slow(10000);
+        assert(pool.attach("a", noop, fast) == 0);
+        assert(pool.attach("b", noop, fast) == 1);
+        assert(pool.attach("c", noop, slow) == 0);
+        assert(pool.attach("d", noop, slow) == 1);
+        assert(pool.attach("e", noop, slow) == 0);
+        assert(pool.attach("a", noop, slow) == 0);
+
+        auto threads = pool.threads();
+        assert(threads[0].connections == 3 && threads[1].connections == 2);
+        assert(std::fabs(threads[0].packetsPerSecond - 300.0) < 1e-6);
+        assert(std::fabs(threads[1].packetsPerSecond - 1100.0) < 1e-6);
+        assert(threads[0].cpu == 0 && threads[1].cpu == 0);
+
+        pool.detach("b");
+        pool.detach("missing");
+        threads = pool.threads();
+        assert(threads[1].connections == 1 && std::fabs(threads[1].packetsPerSecond - 100.0) < 1e-6);
+        assert(pool.attach("f", noop, fast) == 1);
+
+        // A re-opened connection returns to its thread even when another is lighter, until it is forgotten.
+        pool.detach("d");
+        assert(pool.threads()[1].connections == 1);
+        assert(pool.attach("d", noop, slow) == 1);
+        pool.forget("d");
+        threads = pool.threads();
+        assert(threads[1].connections == 1 && std::fabs(threads[1].packetsPerSecond - 1000.0) < 1e-6);
+        assert(pool.attach("d", noop, slow) == 0);
+    }
+
+    {
+        IOReactor reactor;
+        std::string error;
+        assert(!reactor.pin(-1, error) && !error.empty());
+        assert(!reactor.setRealtimePriority(100, error) && !error.empty());
+    }
+
+    {
+        // Real-time threads either run at the requested priority or say why not.
+        Json::Value io;
+        io["threads"] = 1;
+        io["realtime"]["enabled"] = true;
+        io["realtime"]["priority"] = 10;
+        io["realtime"]["lockMemory"] = false;
+        io["realtime"]["prefaultStackKb"] = 64;
+        IOReactorPool pool(IoRuntimeConfig::fromJson(io));
+        const auto thread = pool.threads()[0];
+        assert(thread.realtimePriority == 10 ? thread.realtimeError.empty() : !thread.realtimeError.empty());
+
+        std::atomic<int> polls{0};
+        pool.attach("rt", [&]() { polls++; }, std::chrono::microseconds(1000));
+        const auto start = Clock::now();
+        while (polls < 3 && Clock::now() - start < std::chrono::seconds(2))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(polls >= 3);
+        pool.detach("rt");
+    }
+
+    std::cout << "IO reactor tests passed" << std::endl;
+    return 0;
+}
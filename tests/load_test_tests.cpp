@@ -0,0 +1,102 @@
+#include "services/LoadTestService.h"
+#include <cassert>
+#include <iostream>
+#include <set>
+
+namespace
+{
+Device makeDevice()
+{
+    Device device;
+    device.name = "target";
+    device.ipAddress = "127.0.0.1";
+    device.port = 1;
+    device.timeoutMs = 500;
+    device.group = "car-1";
+    ConnectionConfig connection;
+    connection.outputAssembly = {150, 8};
+    connection.inputAssembly = {100, 8};
+    connection.rpiUs = 10000;
+    device.connection = connection;
+    return device;
+}
+
+LoadTestReport waitForEnd(const LoadTestService &service)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    auto report = service.report();
+    while (report.state == "running" && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        report = service.report();
+    }
+    return report;
+}
+} // namespace
+
+int main()
+{
+    {
+        // Each virtual originator gets its own name and Forward Open identity.
+        LoadTestSpec spec;
+        spec.count = 6;
+        spec.rpiUs = {2000, 5000};
+        const auto originators = LoadTestService::expand(makeDevice(), spec);
+        assert(originators.size() == 6);
+        std::set<std::string> names;
+        std::set<uint16_t> connectionSerials;
+        std::set<uint32_t> originatorSerials;
+        for (size_t i = 0; i < originators.size(); ++i)
+        {
+            const auto &connection = *originators[i].connection;
+            names.insert(originators[i].name);
+            connectionSerials.insert(*connection.connectionSerial);
+            originatorSerials.insert(*connection.originatorSerial);
+            assert(connection.rpiUs == (i % 2 == 0 ? 2000u : 5000u));
+            assert(!originators[i].group && *connection.connectionSerial != 0);
+        }
+        assert(originators[3].name == "target#3");
+        assert(names.size() == 6 && connectionSerials.size() == 6 && originatorSerials.size() == 6);
+
+        Json::Value json;
+        json["count"] = 0;
+        std::string error;
+        assert(!LoadTestSpec::fromJson(json).isValid(error) && !error.empty());
+        json["count"] = 10;
+        assert(LoadTestSpec::fromJson(json).step == 10);
+    }
+
+    {
+        // A target that refuses the first step saturates at that step and everything is closed.
+        IoRuntimeConfig io;
+        io.threads = 1;
+        ConnectionLifecycleService connections(io, std::make_shared<SessionPool>());
+        LoadTestService service(connections);
+        std::string error;
+        assert(!service.stop(error));
+
+        LoadTestSpec spec;
+        spec.count = 4;
+        spec.step = 2;
+        spec.holdMs = 20;
+        assert(service.start(makeDevice(), spec, error));
+        const auto report = waitForEnd(service);
+        assert(report.state == "finished");
+        assert(report.steps.size() == 1 && report.steps[0].connections == 2);
+        assert(report.steps[0].openFailures == 2 && report.steps[0].connected == 0);
+        assert(report.saturationAt && *report.saturationAt == 2);
+        assert(report.maxStable == 0 && !report.firstError.empty());
+        // Originators are forgotten once closed, so repeated runs leave nothing behind.
+        assert(connections.listStatuses().empty());
+        assert(!IOSignalServiceProvider::instance()->assemblies("target#0"));
+
+        // Without stopOnDrop the ramp runs to the full count.
+        spec.stopOnDrop = false;
+        assert(service.start(makeDevice(), spec, error));
+        assert(waitForEnd(service).steps.size() == 2);
+        assert(connections.listStatuses().empty());
+    }
+
+    std::cout << "Load test tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "services/ReplayService.h"
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace
+{
+SignalMapping makeMapping(const std::string &name, SignalDirection direction)
+{
+    SignalMapping mapping;
+    mapping.name = name;
+    mapping.direction = direction;
+    mapping.type = SignalType::UInt8;
+    mapping.byteOffset = 0;
+    return mapping;
+}
+
+ReplayReport waitForEnd(const ReplayService &service)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    auto report = service.report();
+    while (report.state == "running" && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        report = service.report();
+    }
+    return report;
+}
+} // namespace
+
+int main()
+{
+    constexpr int kFrames = 20;
+    constexpr auto kSpacing = std::chrono::milliseconds(5);
+
+    TrafficRecorderConfig config;
+    config.directory =
+        (std::filesystem::temp_directory_path() / ("replay-tests-" + std::to_string(::getpid()))).string();
+    auto recorder = std::make_shared<TrafficRecorder>(config);
+    std::string error;
+    assert(recorder->start(error));
+    const auto stream = recorder->openStream("field", "10.0.0.1", 1, 2);
+    for (int i = 0; i < kFrames; ++i)
+    {
+        recorder->record(stream, TrafficRecorder::Direction::Input, static_cast<uint16_t>(i),
+                         {static_cast<uint8_t>(i + 1), 0, 0, 0});
+        recorder->record(stream, TrafficRecorder::Direction::Output, static_cast<uint16_t>(i), {0xEE, 0, 0, 0});
+        std::this_thread::sleep_for(kSpacing);
+    }
+    recorder->stop();
+
+    IOSignalService signals;
+    signals.applyMappings("bench", {makeMapping("command", SignalDirection::Output),
+                                    makeMapping("status", SignalDirection::Input)});
+    auto device = signals.attach("bench");
+    ConnectionConfig connection;
+    connection.inputAssembly = {100, 4};
+    connection.outputAssembly = {150, 4};
+    signals.configureAssemblies(device, connection);
+    ReplayService service(signals, recorder);
+
+    {
+        // Input frames of the field device drive the bench device's outputs at the recorded spacing.
+        ReplaySpec spec;
+        spec.source = "field";
+        spec.target = "bench";
+        const auto start = std::chrono::steady_clock::now();
+        assert(service.start(spec, error));
+        assert(!service.start(spec, error));
+        const auto report = waitForEnd(service);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(report.state == "finished" && report.frames == kFrames && report.applied == kFrames);
+        assert(report.loops == 1 && report.truncated == 0);
+        assert(elapsed >= kSpacing * (kFrames - 1) * 9 / 10);
+        std::cout << "replay at 1x: " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+                  << " ms, late mean " << report.meanLateUs << " us, max " << report.maxLateUs << " us" << std::endl;
+
+        std::vector<uint8_t> buffer(4, 0);
+        signals.fillOutputBytes(device, buffer);
+        assert(buffer[0] == kFrames);
+    }
+
+    {
+        // Scaled up, the same stream takes a fraction of the time; inputs mode feeds the decoder.
+        ReplaySpec spec;
+        spec.source = "field";
+        spec.direction = "output";
+        spec.target = "bench";
+        spec.mode = "inputs";
+        spec.speed = 10.0;
+        const auto start = std::chrono::steady_clock::now();
+        assert(service.start(spec, error));
+        const auto report = waitForEnd(service);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(report.state == "finished" && report.applied == kFrames);
+        assert(elapsed < kSpacing * (kFrames - 1) / 2);
+        for (const auto &value : signals.snapshot("bench"))
+        {
+            if (value.mapping.name == "status")
+            {
+                assert(value.engineeringValue == 0xEE);
+            }
+        }
+    }
+
+    {
+        // A looping replay runs until stopped.
+        ReplaySpec spec;
+        spec.source = "field";
+        spec.target = "bench";
+        spec.speed = 20.0;
+        spec.loop = true;
+        assert(service.start(spec, error));
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        assert(service.stop(error));
+        const auto report = waitForEnd(service);
+        assert(report.state == "stopped" && report.loops >= 2);
+        assert(!service.stop(error));
+    }
+
+    {
+        ReplaySpec spec;
+        spec.source = "missing";
+        spec.target = "bench";
+        assert(!service.start(spec, error) && error.find("missing") != std::string::npos);
+        spec.source = "field";
+        spec.speed = 0.0;
+        assert(!service.start(spec, error));
+    }
+
+    std::filesystem::remove_all(config.directory);
+    std::cout << "Replay tests passed" << std::endl;
+    return 0;
+}
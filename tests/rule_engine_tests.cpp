@@ -0,0 +1,144 @@
+#include "services/IOSignalService.h"
+#include "services/RuleProgram.h"
+#include <cassert>
+#include <iostream>
+#include <map>
+
+namespace
+{
+SignalMapping makeMapping(const std::string &name, SignalDirection direction, SignalType type, uint16_t byteOffset)
+{
+    SignalMapping mapping;
+    mapping.name = name;
+    mapping.direction = direction;
+    mapping.type = type;
+    mapping.byteOffset = byteOffset;
+    return mapping;
+}
+
+SignalMapping makeRule(const std::string &name, uint16_t byteOffset, const std::string &when, const std::string &value)
+{
+    auto mapping = makeMapping(name, SignalDirection::Output, SignalType::UInt8, byteOffset);
+    mapping.rule = SignalRule{when, value};
+    return mapping;
+}
+
+const IOSignalService::RuleStatus &statusOf(const std::vector<IOSignalService::RuleStatus> &statuses,
+                                            const std::string &signal)
+{
+    for (const auto &status : statuses)
+    {
+        if (status.signal == signal)
+        {
+            return status;
+        }
+    }
+    assert(false && "rule missing from status");
+    return statuses.front();
+}
+} // namespace
+
+int main()
+{
+    {
+        // Expressions compile to stack code over registers named by the resolver.
+        std::map<std::string, uint32_t> names{{"a", 0}, {"b", 1}, {"door-1:closed", 2}};
+        const RuleProgram::Resolver resolve = [&](const std::string &device, const std::string &signal,
+                                                  std::string &error) -> std::optional<uint32_t> {
+            const auto it = names.find(device.empty() ? signal : device + ":" + signal);
+            if (it == names.end())
+            {
+                error = "unknown " + signal;
+                return std::nullopt;
+            }
+            return it->second;
+        };
+        std::atomic<double> registers[3];
+        registers[0] = 4.0;
+        registers[1] = 0.0;
+        registers[2] = 1.0;
+
+        RuleProgram program;
+        std::string error;
+        auto evaluate = [&](const std::string &expression) {
+            RuleProgram::Entry entry;
+            const bool compiled = program.compile(expression, resolve, entry, error);
+            assert(compiled);
+            std::vector<double> stack(program.stackDepth());
+            return program.run(entry, registers, stack.data());
+        };
+        assert(evaluate("1 + 2 * 3") == 7.0);
+        assert(evaluate("(1 + 2) * 3 == 9 && true") == 1.0);
+        assert(evaluate("a / 2 - -1") == 3.0);
+        assert(evaluate("!b && a >= 4 || false") == 1.0);
+        assert(evaluate("a < 4 || b != 0") == 0.0);
+        assert(evaluate("'door-1':closed && a <= 4.5") == 1.0);
+
+        const auto size = program.size();
+        RuleProgram::Entry entry;
+        assert(!program.compile("a &&", resolve, entry, error) && error.find("position 5") != std::string::npos);
+        assert(!program.compile("a = 1", resolve, entry, error));
+        assert(!program.compile("(a", resolve, entry, error));
+        assert(!program.compile("missing > 1", resolve, entry, error) && error == "unknown missing");
+        assert(!program.compile("", resolve, entry, error));
+        assert(program.size() == size);
+        assert(RuleProgram::check("dev:x > 3 || 'a b':y", error));
+        assert(!RuleProgram::check("x >", error));
+    }
+
+    {
+        // "When door_closed goes true, set traction_enable": the reaction is in the very next output frame.
+        IOSignalService service;
+        service.applyMappings("traction", {makeRule("traction_enable", 0, "'door-1':door_closed", "1"),
+                                           makeRule("slow", 1, "", "'door-1':door_closed && 'door-1':speed < 5"),
+                                           makeRule("broken", 2, "", "'door-1':missing")});
+        auto statuses = service.rules();
+        assert(statuses.size() == 3 && !statusOf(statuses, "traction_enable").active);
+        assert(statusOf(statuses, "traction_enable").error == "unknown device door-1");
+
+        service.applyMappings("door-1", {makeMapping("door_closed", SignalDirection::Input, SignalType::Bool, 0),
+                                         makeMapping("speed", SignalDirection::Input, SignalType::UInt8, 1)});
+        statuses = service.rules();
+        assert(statusOf(statuses, "traction_enable").active && statusOf(statuses, "slow").active);
+        assert(!statusOf(statuses, "broken").active);
+
+        auto door = service.attach("door-1");
+        auto traction = service.attach("traction");
+        std::vector<uint8_t> output;
+        service.consumeInputBytes(door, {0, 3});
+        service.fillOutputBytes(traction, output);
+        assert(output[0] == 0 && output[1] == 0);
+
+        service.consumeInputBytes(door, {1, 3});
+        service.fillOutputBytes(traction, output);
+        assert(output[0] == 1 && output[1] == 1);
+
+        // Edge rules fire once per rising edge, so the output can be written in between.
+        assert(service.setOutputValue("traction", "traction_enable", 0.0));
+        service.consumeInputBytes(door, {1, 9});
+        service.fillOutputBytes(traction, output);
+        assert(output[0] == 0 && output[1] == 0);
+        service.consumeInputBytes(door, {0, 9});
+        service.consumeInputBytes(door, {1, 2});
+        service.fillOutputBytes(traction, output);
+        assert(output[0] == 1 && output[1] == 1);
+        assert(statusOf(service.rules(), "traction_enable").fired == 2);
+
+        // Recompiling after an unrelated mapping change keeps the edge state.
+        service.applyMappings("spare", {makeMapping("x", SignalDirection::Input, SignalType::UInt8, 0)});
+        assert(service.setOutputValue("traction", "traction_enable", 0.0));
+        service.consumeInputBytes(door, {1, 2});
+        service.fillOutputBytes(traction, output);
+        assert(output[0] == 0);
+        assert(statusOf(service.rules(), "traction_enable").fired == 2);
+
+        // Removing the input deactivates the rules that read it.
+        service.applyMappings("door-1", {makeMapping("speed", SignalDirection::Input, SignalType::UInt8, 1)});
+        statuses = service.rules();
+        assert(!statusOf(statuses, "traction_enable").active && !statusOf(statuses, "slow").active);
+        service.consumeInputBytes(door, {1, 0});
+    }
+
+    std::cout << "Rule engine tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "services/SessionPool.h"
+#include <EIPScanner/eip/EncapsPacket.h>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+struct FakeState
+{
+    std::atomic<int> created{0};
+    std::atomic<int> destroyed{0};
+    std::atomic<int> probes{0};
+    std::atomic<bool> failProbes{false};
+};
+
+class FakeSession : public eipScanner::SessionInfoIf
+{
+public:
+    FakeSession(std::shared_ptr<FakeState> state, uint16_t port)
+        : state_(std::move(state)), endPoint_("127.0.0.1", port), handle_(++state_->created)
+    {
+    }
+
+    ~FakeSession() override { state_->destroyed++; }
+
+    eipScanner::eip::EncapsPacket sendAndReceive(const eipScanner::eip::EncapsPacket &packet) const override
+    {
+        state_->probes++;
+        if (state_->failProbes)
+        {
+            throw std::runtime_error("Connection reset");
+        }
+        return packet;
+    }
+
+    eipScanner::cip::CipUdint getSessionHandle() const override { return handle_; }
+    eipScanner::sockets::EndPoint getRemoteEndPoint() const override { return endPoint_; }
+
+private:
+    std::shared_ptr<FakeState> state_;
+    eipScanner::sockets::EndPoint endPoint_;
+    eipScanner::cip::CipUdint handle_;
+};
+
+SessionPool::Factory fakeFactory(const std::shared_ptr<FakeState> &state)
+{
+    return [state](const std::string &, uint16_t port, std::chrono::milliseconds) -> SessionPool::Session {
+        return std::make_shared<FakeSession>(state, port);
+    };
+}
+
+template <typename Predicate>
+bool waitUntil(Predicate predicate)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!predicate())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    const auto timeout = std::chrono::milliseconds(500);
+
+    {
+        // Returned sessions are reused per target; a transport error drops them instead.
+        auto state = std::make_shared<FakeState>();
+        SessionPool pool({}, fakeFactory(state));
+
+        eipScanner::cip::CipUdint handle = 0;
+        {
+            auto lease = pool.acquire("127.0.0.1", 44818, timeout);
+            assert(!lease.reused());
+            handle = lease.session()->getSessionHandle();
+            assert(pool.stats().leased == 1);
+        }
+        assert(pool.stats().idle == 1 && pool.stats().leased == 0);
+
+        {
+            auto lease = pool.acquire("127.0.0.1", 44818, timeout);
+            assert(lease.reused() && lease.session()->getSessionHandle() == handle);
+            // Concurrent callers never share a session.
+            auto other = pool.acquire("127.0.0.1", 44818, timeout);
+            assert(!other.reused() && other.session()->getSessionHandle() != handle);
+            auto elsewhere = pool.acquire("127.0.0.1", 2222, timeout);
+            assert(!elsewhere.reused());
+            lease.invalidate();
+        }
+        assert(state->created == 3 && state->destroyed == 1);
+        auto stats = pool.stats();
+        assert(stats.idle == 2 && stats.created == 3 && stats.reused == 1 && stats.dropped == 1);
+    }
+
+    {
+        // Idle sessions beyond the per-target cap are closed, oldest first.
+        auto state = std::make_shared<FakeState>();
+        SessionPoolConfig config;
+        config.maxIdlePerTarget = 2;
+        SessionPool pool(config, fakeFactory(state));
+        {
+            auto first = pool.acquire("127.0.0.1", 44818, timeout);
+            auto second = pool.acquire("127.0.0.1", 44818, timeout);
+            auto third = pool.acquire("127.0.0.1", 44818, timeout);
+        }
+        assert(pool.stats().idle == 2 && state->destroyed == 1);
+        // The most recently returned session is handed out first.
+        auto lease = pool.acquire("127.0.0.1", 44818, timeout);
+        assert(lease.session()->getSessionHandle() == 1);
+    }
+
+    {
+        // Keepalive probes idle sessions and drops those that fail.
+        auto state = std::make_shared<FakeState>();
+        SessionPoolConfig config;
+        config.keepaliveMs = 20;
+        SessionPool pool(config, fakeFactory(state));
+        {
+            auto lease = pool.acquire("127.0.0.1", 44818, timeout);
+        }
+        assert(waitUntil([&]() { return state->probes >= 2; }));
+        assert(pool.stats().idle == 1 && state->destroyed == 0);
+
+        state->failProbes = true;
+        assert(waitUntil([&]() { return pool.stats().idle == 0; }));
+        assert(state->destroyed == 1);
+        assert(!pool.acquire("127.0.0.1", 44818, timeout).reused());
+    }
+
+    {
+        // Sessions unused for idleTimeoutMs are closed.
+        auto state = std::make_shared<FakeState>();
+        SessionPoolConfig config;
+        config.idleTimeoutMs = 50;
+        SessionPool pool(config, fakeFactory(state));
+        {
+            auto lease = pool.acquire("127.0.0.1", 44818, timeout);
+        }
+        assert(waitUntil([&]() { return state->destroyed == 1; }));
+        assert(pool.stats().idle == 0 && pool.stats().dropped == 1);
+    }
+
+    std::cout << "Session pool tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "services/TrafficRecorder.h"
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unistd.h>
+
+namespace
+{
+struct Packet
+{
+    uint32_t captured{0};
+    uint32_t length{0};
+    std::vector<uint8_t> data;
+};
+
+uint32_t le32(const std::vector<uint8_t> &bytes, size_t offset)
+{
+    return bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) |
+           (static_cast<uint32_t>(bytes[offset + 3]) << 24);
+}
+
+// Walks the pcapng blocks, checking the section and interface headers.
+std::vector<Packet> readPcapng(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<Packet> packets;
+    size_t offset = 0;
+    while (offset < bytes.size())
+    {
+        const auto type = le32(bytes, offset);
+        const auto total = le32(bytes, offset + 4);
+        assert(total % 4 == 0 && le32(bytes, offset + total - 4) == total);
+        if (offset == 0)
+        {
+            assert(type == 0x0A0D0D0A && le32(bytes, 8) == 0x1A2B3C4D);
+        }
+        else if (type == 1)
+        {
+            assert((bytes[offset + 8] | (bytes[offset + 9] << 8)) == 101);
+        }
+        else if (type == 6)
+        {
+            Packet packet;
+            packet.captured = le32(bytes, offset + 20);
+            packet.length = le32(bytes, offset + 24);
+            packet.data.assign(bytes.begin() + offset + 28, bytes.begin() + offset + 28 + packet.captured);
+            packets.push_back(packet);
+        }
+        offset += total;
+    }
+    return packets;
+}
+
+void waitForWriter()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+} // namespace
+
+int main()
+{
+    const auto directory = std::filesystem::temp_directory_path() / ("recorder-tests-" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    const auto exportPath = (directory / "out.pcapng").string();
+
+    {
+        TrafficRecorderConfig config;
+        config.directory = directory.string();
+        config.fileKb = 4;
+        config.maxFiles = 2;
+        config.queueFrames = 64;
+        TrafficRecorder recorder(config);
+        const auto stream = recorder.openStream("door-1", "10.0.0.7", 0x11223344, 0x55667788);
+
+        // Nothing is kept until recording starts.
+        recorder.record(stream, TrafficRecorder::Direction::Input, 1, {1, 2, 3});
+        assert(recorder.stats().frames == 0);
+
+        std::string error;
+        assert(recorder.start(error));
+        assert(!recorder.start(error));
+        for (uint16_t i = 0; i < 10; ++i)
+        {
+            const auto direction = i % 2 == 0 ? TrafficRecorder::Direction::Input : TrafficRecorder::Direction::Output;
+            recorder.record(stream, direction, i, {static_cast<uint8_t>(i), 0xAA, 0xBB, 0xCC});
+        }
+        recorder.stop();
+        auto stats = recorder.stats();
+        assert(!stats.recording && stats.frames == 10 && stats.dropped == 0);
+        assert(stats.files.size() == 1 && stats.bytesWritten > 0);
+        // The unused preallocation is released when the file is closed.
+        assert(std::filesystem::file_size(stats.files[0]) < 4096);
+
+        assert(recorder.exportPcapng(exportPath, error));
+        auto packets = readPcapng(exportPath);
+        assert(packets.size() == 10);
+        // IPv4 from the device for input, UDP 2222, then the CPF items and sequence count.
+        const auto &first = packets[0].data;
+        assert(first[0] == 0x45 && first[9] == 17);
+        assert(first[12] == 10 && first[13] == 0 && first[14] == 0 && first[15] == 7);
+        assert(first[20] == 0x08 && first[21] == 0xAE);
+        assert(first[28] == 2 && first[30] == 0x02 && first[31] == 0x80 && first[32] == 8);
+        // Input carries the T->O connection id, output the O->T one.
+        assert(first[34] == 0x88 && first[35] == 0x77 && first[36] == 0x66 && first[37] == 0x55);
+        assert(first[42] == 0xB1 && first[44] == 6 && first[46] == 0 && first[48] == 0);
+        assert(first.size() == 52 && first[51] == 0xCC);
+        const auto &second = packets[1].data;
+        assert(second[16] == 10 && second[19] == 7 && second[46] == 1);
+        assert(second[34] == 0x44 && second[35] == 0x33 && second[36] == 0x22 && second[37] == 0x11);
+
+        // Long frames are cut at the snap length but keep their original length.
+        assert(recorder.start(error));
+        recorder.record(stream, TrafficRecorder::Direction::Input, 0, std::vector<uint8_t>(2000, 0x11));
+        recorder.stop();
+        assert(recorder.exportPcapng(exportPath, error));
+        packets = readPcapng(exportPath);
+        assert(packets.back().length == 48 + 2000);
+        assert(packets.back().captured == 48 + TrafficRecorder::kSnapBytes);
+
+        // Rotation keeps maxFiles files, each readable without the ones deleted before it.
+        assert(recorder.start(error));
+        const uint64_t before = recorder.stats().frames;
+        for (uint16_t i = 0; i < 200; ++i)
+        {
+            recorder.record(stream, TrafficRecorder::Direction::Input, i, std::vector<uint8_t>(100, 0x22));
+            if (i % 16 == 15)
+            {
+                waitForWriter();
+            }
+        }
+        recorder.stop();
+        stats = recorder.stats();
+        assert(stats.frames - before + stats.dropped == 200);
+        assert(stats.files.size() == 2);
+        for (const auto &file : stats.files)
+        {
+            assert(std::filesystem::file_size(file) <= 4096);
+        }
+        assert(recorder.exportPcapng(exportPath, error));
+        packets = readPcapng(exportPath);
+        assert(!packets.empty() && packets.size() < 200);
+        for (const auto &packet : packets)
+        {
+            assert(packet.data[12] == 10 && packet.data[15] == 7 && packet.data[34] == 0x88);
+        }
+    }
+
+    {
+        // A full queue drops frames instead of waiting for the writer.
+        TrafficRecorderConfig config;
+        config.directory = (directory / "small").string();
+        config.queueFrames = 2;
+        TrafficRecorder recorder(config);
+        std::string error;
+        assert(recorder.start(error));
+        const auto stream = recorder.openStream("door-2", "10.0.0.8", 1, 2);
+        for (int i = 0; i < 1000; ++i)
+        {
+            recorder.record(stream, TrafficRecorder::Direction::Output, 0, std::vector<uint8_t>(32, 0));
+        }
+        recorder.stop();
+        const auto stats = recorder.stats();
+        assert(stats.frames + stats.dropped == 1000 && stats.dropped > 0);
+    }
+
+    std::filesystem::remove_all(directory);
+    std::cout << "Traffic recorder tests passed" << std::endl;
+    return 0;
+}